@@ -0,0 +1,205 @@
+#include "batch_processor.h"
+
+#include <assert.h>
+#include <unistd.h>
+
+#include "body_extractor.h"
+#include "list_page_classifier.h"
+#include "dom_arena.h"
+#include "dom_tree.h"
+
+using namespace std;
+
+BatchProcessor::BatchProcessor(const BodyExtractor* extractor, const ListPageClassifier* classifier, int thread_count, bool to_utf8) :
+    m_extractor(extractor),
+    m_classifier(classifier),
+    m_parser(SI_AUTO, to_utf8),
+    m_batch_id(0),
+    m_busy_count(0),
+    m_stopping(false),
+    m_documents(NULL),
+    m_doms(NULL),
+    m_urls(NULL),
+    m_results(NULL),
+    m_batch_size(0),
+    m_next_document(0)
+{
+    assert(extractor != NULL);
+    assert(classifier != NULL);
+
+    if (thread_count <= 0)
+    {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpu_count > 0 ? static_cast<int>(cpu_count) : 1;
+    }
+
+    pthread_mutex_init(&this->m_mutex, NULL);
+    pthread_cond_init(&this->m_batch_started, NULL);
+    pthread_cond_init(&this->m_batch_done, NULL);
+    for (int i = 0; i < thread_count; ++i)
+    {
+        Worker* worker = new Worker();
+        worker->processor = this;
+        int result = pthread_create(&worker->thread, NULL, BatchProcessor::run_worker, worker);
+        assert(result == 0);
+        (void)result;
+        this->m_workers.push_back(worker);
+    }
+}
+
+BatchProcessor::~BatchProcessor()
+{
+    pthread_mutex_lock(&this->m_mutex);
+    this->m_stopping = true;
+    pthread_cond_broadcast(&this->m_batch_started);
+    pthread_mutex_unlock(&this->m_mutex);
+
+    for (size_t i = 0; i < this->m_workers.size(); ++i)
+    {
+        pthread_join(this->m_workers[i]->thread, NULL);
+        delete this->m_workers[i];
+    }
+
+    pthread_cond_destroy(&this->m_batch_done);
+    pthread_cond_destroy(&this->m_batch_started);
+    pthread_mutex_destroy(&this->m_mutex);
+}
+
+void BatchProcessor::process(const vector<BatchDocument>& documents, vector<BatchResult>& results)
+{
+    results.resize(documents.size());
+    this->m_documents = &documents;
+    this->m_doms = NULL;
+    this->m_urls = NULL;
+    this->m_results = &results;
+    this->run_batch(documents.size());
+}
+
+void BatchProcessor::process(const vector<const DomNode*>& doms, const vector<const char*>& urls, vector<BatchResult>& results)
+{
+    assert(doms.size() == urls.size());
+
+    results.resize(doms.size());
+    this->m_documents = NULL;
+    this->m_doms = &doms;
+    this->m_urls = &urls;
+    this->m_results = &results;
+    this->run_batch(doms.size());
+}
+
+void BatchProcessor::run_batch(size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&this->m_mutex);
+    this->m_batch_size = size;
+    this->m_next_document = 0;
+    this->m_busy_count = this->m_workers.size();
+    ++this->m_batch_id;
+    pthread_cond_broadcast(&this->m_batch_started);
+    while (this->m_busy_count > 0)
+    {
+        pthread_cond_wait(&this->m_batch_done, &this->m_mutex);
+    }
+
+    pthread_mutex_unlock(&this->m_mutex);
+}
+
+void* BatchProcessor::run_worker(void* arg)
+{
+    Worker* worker = static_cast<Worker*>(arg);
+    worker->processor->work(*worker);
+    return NULL;
+}
+
+void BatchProcessor::work(Worker& worker)
+{
+    size_t batch_id = 0;
+    while (true)
+    {
+        pthread_mutex_lock(&this->m_mutex);
+        while (!this->m_stopping && this->m_batch_id == batch_id)
+        {
+            pthread_cond_wait(&this->m_batch_started, &this->m_mutex);
+        }
+
+        if (this->m_stopping)
+        {
+            pthread_mutex_unlock(&this->m_mutex);
+            return;
+        }
+
+        batch_id = this->m_batch_id;
+        pthread_mutex_unlock(&this->m_mutex);
+
+        // documents are taken one at a time, so a slow page doesn't hold back a whole share.
+        while (true)
+        {
+            size_t i = __sync_fetch_and_add(&this->m_next_document, 1);
+            if (i >= this->m_batch_size)
+            {
+                break;
+            }
+
+            if (this->m_documents != NULL)
+            {
+                this->process_document((*this->m_documents)[i], (*this->m_results)[i]);
+            }
+            else
+            {
+                this->process_dom(worker, (*this->m_doms)[i], (*this->m_urls)[i], (*this->m_results)[i]);
+            }
+        }
+
+        pthread_mutex_lock(&this->m_mutex);
+        if (--this->m_busy_count == 0)
+        {
+            pthread_cond_signal(&this->m_batch_done);
+        }
+
+        pthread_mutex_unlock(&this->m_mutex);
+    }
+}
+
+void BatchProcessor::process_document(const BatchDocument& document, BatchResult& result) const
+{
+    result = BatchResult();
+    // the tree lives in the arena of the thread, which keeps its blocks after reset.
+    DomArena& arena = DomArena::get_thread_arena();
+    DomNode* dom = this->m_parser.parse(document.html, document.length, arena);
+    if (dom != NULL)
+    {
+        result.parsed = true;
+        // classified first, the extraction drops nodes.
+        result.is_list_page = this->m_classifier->classify(dom, document.url);
+        DomNode* body = this->m_extractor->extract(dom);
+        if (body != NULL)
+        {
+            result.has_body = true;
+            serialize_html(body, result.body_html);
+        }
+    }
+
+    arena.reset();
+}
+
+void BatchProcessor::process_dom(Worker& worker, const DomNode* dom, const char* url, BatchResult& result) const
+{
+    result = BatchResult();
+    if (dom == NULL)
+    {
+        return;
+    }
+
+    result.parsed = true;
+    int32_t body = this->m_extractor->extract(dom, worker.flat_dom, worker.kept);
+    result.is_list_page = this->m_classifier->classify(worker.flat_dom, url);
+    if (body >= 0)
+    {
+        result.has_body = true;
+        serialize_html(worker.flat_dom, body, worker.kept, result.body_html);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef _BATCH_PROCESSOR_H_
+#define _BATCH_PROCESSOR_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "flat_dom.h"
+#include "html_parser.h"
+
+class BodyExtractor;
+class ListPageClassifier;
+class DomNode;
+
+// a page of a batch, html is not copied and should outlive the batch.
+struct BatchDocument
+{
+    BatchDocument() :
+        html(NULL), length(0), url("")
+    {
+    }
+
+    BatchDocument(const char* html, size_t length, const char* url) :
+        html(html), length(length), url(url)
+    {
+    }
+
+    const char* html;
+    size_t length;
+    const char* url;
+};
+
+struct BatchResult
+{
+    BatchResult() :
+        parsed(false), is_list_page(false), has_body(false)
+    {
+    }
+
+    bool parsed;
+    bool is_list_page;
+    bool has_body;
+    // the extracted body written back to html.
+    std::string body_html;
+};
+
+// parses, classifies and extracts the bodies of batches of pages on a pool of threads,
+// which share the extractor and the classifier. every thread keeps its arena and scratch
+// trees between documents and batches. results are in the order of the documents.
+// one batch is processed at a time, process should not be called by several threads.
+class BatchProcessor
+{
+public:
+    // thread_count <= 0 starts one thread per cpu. with to_utf8, pages are converted to utf-8
+    // before they are parsed, see HtmlParser, the body html is in utf-8 then.
+    BatchProcessor(const BodyExtractor* extractor, const ListPageClassifier* classifier, int thread_count, bool to_utf8 = false);
+    ~BatchProcessor();
+
+    int get_thread_count() const
+    {
+        return static_cast<int>(this->m_workers.size());
+    }
+
+    void process(const std::vector<BatchDocument>& documents, std::vector<BatchResult>& results);
+    // trees are only read, so they can be used for other analyzers after, urls[i] is the url of doms[i].
+    void process(const std::vector<const DomNode*>& doms, const std::vector<const char*>& urls, std::vector<BatchResult>& results);
+
+private:
+    struct Worker
+    {
+        BatchProcessor* processor;
+        pthread_t thread;
+        // scratch of the extraction of trees, reused for every document.
+        FlatDom flat_dom;
+        FlatDomMask kept;
+    };
+
+    static void* run_worker(void* arg);
+    void work(Worker& worker);
+    // hand the batch to the workers and wait until it is done.
+    void run_batch(size_t size);
+    void process_document(const BatchDocument& document, BatchResult& result) const;
+    void process_dom(Worker& worker, const DomNode* dom, const char* url, BatchResult& result) const;
+
+    // not copyable, workers point to it.
+    BatchProcessor(const BatchProcessor&);
+    BatchProcessor& operator=(const BatchProcessor&);
+
+    const BodyExtractor* m_extractor;
+    const ListPageClassifier* m_classifier;
+    HtmlParser m_parser;
+    std::vector<Worker*> m_workers;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_batch_started;
+    pthread_cond_t m_batch_done;
+    // a new batch is started when it changes.
+    size_t m_batch_id;
+    size_t m_busy_count;
+    bool m_stopping;
+
+    // the current batch, one of documents and doms is set.
+    const std::vector<BatchDocument>* m_documents;
+    const std::vector<const DomNode*>* m_doms;
+    const std::vector<const char*>* m_urls;
+    std::vector<BatchResult>* m_results;
+    size_t m_batch_size;
+    // index of the next document to take, taken atomically.
+    size_t m_next_document;
+};
+
+#endif
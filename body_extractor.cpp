@@ -1,10 +1,12 @@
 #include "body_extractor.h"
 
+#include "config.h"
+#include "log.h"
+#include "stage_stats.h"
 #include "utils.h"
 #include <cmath>
 #include <assert.h>
 #include <vector>
-#include <iostream>
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
@@ -15,16 +17,16 @@ using namespace std;
 static const char* c_section_name = "bodyExtractor";
 
 // define header tags.
-static const char* _header_tags[] = {"h1", "h2", "h3", "h4", "h5", "h6"};
+static const HtmlTag _header_tags[] = {TAG_H1, TAG_H2, TAG_H3, TAG_H4, TAG_H5, TAG_H6};
 // interactive: 
-static const char* _interactive_tags[] = {"form", "iframe"};
+static const HtmlTag _interactive_tags[] = {TAG_FORM, TAG_IFRAME};
 // struct: 
-static const char* _struct_tags[] = {"table", "ul", "div"};
+static const HtmlTag _struct_tags[] = {TAG_TABLE, TAG_UL, TAG_DIV};
 
-// vectors of tags, why?
-static const vector<string> c_header_tags(_header_tags, _header_tags + sizeof(_header_tags) / sizeof(_header_tags[0]));
-static const vector<string> c_interactive_tags(_interactive_tags, _interactive_tags + sizeof(_interactive_tags) / sizeof(_interactive_tags[0]));
-static const vector<string> c_struct_tags(_struct_tags, _struct_tags + sizeof(_struct_tags) / sizeof(_struct_tags[0]));
+// sets of tags, a tag test is a bitmask test.
+static const HtmlTagSet c_header_tags(_header_tags, sizeof(_header_tags) / sizeof(_header_tags[0]));
+static const HtmlTagSet c_interactive_tags(_interactive_tags, sizeof(_interactive_tags) / sizeof(_interactive_tags[0]));
+static const HtmlTagSet c_struct_tags(_struct_tags, sizeof(_struct_tags) / sizeof(_struct_tags[0]));
 
 // # in #define: converte param to char.
 // so all features defined in body_extractor_features.h is just strings?
@@ -35,6 +37,19 @@ static const char* c_feature_names[] =
 #undef BODY_EXTRACTOR_FEATURE
 };
 
+// atoms of the known tags in names.
+static void get_tag_set(const vector<string>& names, HtmlTagSet& tags)
+{
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        HtmlTag tag = lookup_html_tag(names[i].c_str());
+        if (tag != TAG_UNKNOWN)
+        {
+            tags.insert(tag);
+        }
+    }
+}
+
 //select the best one
 bool comparer(const DomNode* first, const DomNode* second)
 {
@@ -49,47 +64,205 @@ features used by sanitize classifier: FN_IS_HEADER_TAG, FN_BASIC_WEIGHT, FN_LINK
 features used by sibling classifier : FN_IS_P_TAG, FN_TEXT_CURRENT_LENGTH, FN_LINK_DENSITY, FN_FOUND_BREAK_PUNC
 */
 
+static size_t get_depth(const DomNode* node)
+{
+    size_t depth = 0;
+    for (; node->get_parent() != NULL; node = node->get_parent())
+    {
+        ++depth;
+    }
+
+    return depth;
+}
+
+// is first visited before second by a postorder traversal? only asked on ties of scores.
+static bool precedes_in_postorder(const DomNode* first, const DomNode* second)
+{
+    size_t first_depth = get_depth(first);
+    size_t second_depth = get_depth(second);
+    // a descendant comes before its ancestors.
+    const DomNode* first_ancestor = first;
+    const DomNode* second_ancestor = second;
+    for (; first_depth > second_depth; --first_depth)
+    {
+        first_ancestor = first_ancestor->get_parent();
+    }
+
+    for (; second_depth > first_depth; --second_depth)
+    {
+        second_ancestor = second_ancestor->get_parent();
+    }
+
+    if (first_ancestor == second_ancestor)
+    {
+        return first != first_ancestor;
+    }
+
+    // else the one under the earlier child of the common ancestor.
+    while (first_ancestor->get_parent() != second_ancestor->get_parent())
+    {
+        first_ancestor = first_ancestor->get_parent();
+        second_ancestor = second_ancestor->get_parent();
+    }
+
+    const DomNodeList& children = *first_ancestor->get_parent()->get_children();
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        if (children[i] == first_ancestor || children[i] == second_ancestor)
+        {
+            return children[i] == first_ancestor;
+        }
+    }
+
+    return false;
+}
+
 // use this class to visit dom tree.
-// in preprocess, drop negative node.
-class BodyExtractorVisitor : public DomTreeVisitor
+// in preprocess, drop negative node. in visit, extract features, then score the node if it
+// is a candidate, all in one pass. the children and grandchildren of a node are final when
+// it is visited, so candidate ancestors are known then too.
+// dispatched at compile time by DomTreeTraversal, so the steps are inlined into the traversal.
+// fused with other visitors, negative nodes are only marked in preprocess, so the others
+// still walk their subtrees, and unlinked when their parent is visited.
+class BodyExtractorVisitor : public InlineDomTreeVisitor
 {
 public:
-    BodyExtractorVisitor(const BodyExtractor* extractor, vector<DomNode*>& candidates) :
+    BodyExtractorVisitor(const BodyExtractor* extractor, SubstringMatchCache& class_ids, bool fused = false) :
         _extractor(extractor),
-        _candidates(candidates)
+        _class_ids(class_ids),
+        _fused(fused),
+        _negative_root(NULL),
+        _best_candidate(NULL),
+        _best_source(0),
+        _best_promoter(NULL),
+        _node_count(0),
+        _candidate_count(0)
     {
     }
 
-    // called in DomNode::postorder_traverse
-    virtual bool preprocess(DomNode* node)
+    // called in DomTreeTraversal::postorder
+    bool preprocess(DomNode* node)
     {
-        // drop negative node. if dropped, return false, else return true.
-        return !this->_extractor->drop_negative_node(node);
+        if (!this->_fused)
+        {
+            // drop negative node. if dropped, return false, else return true.
+            return !this->_extractor->drop_negative_node(node, this->_class_ids);
+        }
+
+        if (this->_negative_root == NULL && this->_extractor->is_negative_node(node, this->_class_ids))
+        {
+            this->_negative_root = node;
+            this->_negative_nodes.push_back(node);
+        }
+
+        return true;
     }
 
-    // called in DomNode::postorder_traverse
-    // extract features, and add into candidate if valid.
-    virtual bool visit(DomNode* node)
+    // called in DomTreeTraversal::postorder
+    // extract features, and score the node if it is a candidate.
+    bool visit(DomNode* node)
     {
+        // the nodes of a negative subtree are not extracted.
+        if (this->_negative_root != NULL)
+        {
+            if (this->_negative_root == node)
+            {
+                this->_negative_root = NULL;
+            }
+
+            return true;
+        }
+
+        // the walk of the negative children is done, unlink them before the features are summed.
+        while (!this->_negative_nodes.empty() && this->_negative_nodes.back()->get_parent() == node)
+        {
+            DomNode::drop_node(this->_negative_nodes.back());
+            this->_negative_nodes.pop_back();
+        }
+
         // extract features?
-        this->_extractor->extract_features(node);
-        node->print_node();
-        // validate
-        if (this->_extractor->valid_node(node))
+        this->_extractor->extract_features(node, this->_class_ids);
+        ++this->_node_count;
+        DomNode* promoter;
+        int source = this->_extractor->get_candidate_source(node, promoter);
+        if (source >= 0)
         {
-            this->_extractor->add_candidate(node, 0, _candidates);
+            this->_extractor->score_candidate(node, source);
+            ++this->_candidate_count;
+            double score = node->get_extra(BodyExtractor::FN_BASIC_WEIGHT);
+            if (this->_best_candidate == NULL || score > this->_best_candidate->get_extra(BodyExtractor::FN_BASIC_WEIGHT) ||
+                (score == this->_best_candidate->get_extra(BodyExtractor::FN_BASIC_WEIGHT) && this->comes_first(source, promoter)))
+            {
+                this->_best_candidate = node;
+                this->_best_source = source;
+                this->_best_promoter = promoter;
+            }
         }
 
         return true;
     }
 
+    DomNode* get_best_candidate() const
+    {
+        return this->_best_candidate;
+    }
+
+    // a negative root is left, it has no parent to be unlinked from.
+    void drop_negative_nodes()
+    {
+        for (size_t i = 0; i < this->_negative_nodes.size(); ++i)
+        {
+            DomNode::drop_node(this->_negative_nodes[i]);
+        }
+
+        this->_negative_nodes.clear();
+    }
+
+    // nodes visited and candidates scored, for the stage stats.
+    size_t get_node_count() const
+    {
+        return this->_node_count;
+    }
+
+    size_t get_candidate_count() const
+    {
+        return this->_candidate_count;
+    }
+
 private:
+    // the first best wins, in the order the candidates used to be listed: the valid nodes in
+    // postorder, then the ancestors as they were promoted, the parent and the grand parent
+    // of each valid node in turn. an ancestor is ranked by the first valid node under it.
+    bool comes_first(int source, DomNode* promoter) const
+    {
+        if (source == 0 || this->_best_source == 0)
+        {
+            return source == 0 && this->_best_source != 0;
+        }
+
+        if (promoter == this->_best_promoter)
+        {
+            return source < this->_best_source;
+        }
+
+        return precedes_in_postorder(promoter, this->_best_promoter);
+    }
+
     const BodyExtractor* _extractor;
-    vector<DomNode*>& _candidates;
+    SubstringMatchCache& _class_ids;
+    bool _fused;
+    // the negative node whose subtree is walked, and the ones waiting for their parent.
+    DomNode* _negative_root;
+    vector<DomNode*> _negative_nodes;
+    DomNode* _best_candidate;
+    int _best_source;
+    DomNode* _best_promoter;
+    size_t _node_count;
+    size_t _candidate_count;
 };
 
 // for dom node, visit return bool value, should or should not drop node.
-class SanitizeVisitor : public DomTreeVisitor
+class SanitizeVisitor : public InlineDomTreeVisitor
 {
 public:
     // pass extractor object while constructing.
@@ -98,7 +271,7 @@ public:
     {
     }
 
-    virtual bool visit(DomNode* node)
+    bool visit(DomNode* node)
     {
         // if do not have basic weight, calculate and set first.
         if (!node->has_extra(BodyExtractor::FN_BASIC_WEIGHT))
@@ -109,11 +282,12 @@ public:
         }
 
         // get all features values
-        const map<int, double>& features = node->get_extras();
+        FeatureArray features = node->get_extras();
 
         bool result = this->_extractor->_sanitize_classifier.classify(features);
         if (result)
         {
+            this->_extractor->record_flight_event(FLIGHT_SANITIZE_DROP, node, 0, node->get_extra(BodyExtractor::FN_BASIC_WEIGHT));
             DomNode::drop_node(node);
             return false;
         }
@@ -126,7 +300,17 @@ private:
 };
 
 BodyExtractor::BodyExtractor() :
-    _initialized(false)
+    _initialized(false),
+    _negative_tags_enabled(false),
+    _negative_class_ids_enabled(false),
+    _include_parent_node_enabled(false),
+    _include_grand_parent_node_enabled(false),
+    _min_text_length(0),
+    _classifier_threshold(0.0),
+    _shared_class_id_cache(NULL),
+    _flight_recorder_enabled(false),
+    _class_id_lookup_count(0),
+    _class_id_hit_count(0)
 {
 }
 
@@ -139,52 +323,86 @@ bool BodyExtractor::init(const char* config_file_path)
     assert(config_file_path != NULL);
     assert(!this->_initialized);
 
-    // init config.
-    bool success = this->_config.Init(config_file_path);
+    // init config, it is only read here.
+    Config config;
+    bool success = config.Init(config_file_path);
     if (!success)
     {
-        cout << "init config failed" << endl;
+        ERROR_LOG(LOG_CONFIG, "init config failed");
         return false;
     }
 
     // init base classifier, read weights and threshold value from config.
-    const vector<double>& weights = this->_config.GetDoubleList(c_section_name, "classifier_weights");
-    double threshold = this->_config.GetDoubleValue(c_section_name, "classifier_threshold", 0.0);
-    success = this->_basic_classifier.init(weights, threshold);
+    const vector<double>& weights = config.GetDoubleList(c_section_name, "classifier_weights");
+    this->_classifier_threshold = config.GetDoubleValue(c_section_name, "classifier_threshold", 0.0);
+    success = this->_basic_classifier.init(weights, this->_classifier_threshold);
     if (!success)
     {
-        cout << "init basic classifier failed" << endl;
+        ERROR_LOG(LOG_CONFIG, "init basic classifier failed");
         return false;
     }
 
     // init sanitize classifier.
     vector<string> feature_names(c_feature_names, c_feature_names + sizeof(c_feature_names) / sizeof(c_feature_names[0]));
 
-    string sanitize_expression = this->_config.GetStringValue(c_section_name, "sanitize_expression");
+    string sanitize_expression = config.GetStringValue(c_section_name, "sanitize_expression");
     success = this->_sanitize_classifier.init(sanitize_expression.c_str(), feature_names);
     if (!success)
     {
-        cout << "init santize classifier failed" << endl;
+        ERROR_LOG(LOG_CONFIG, "init santize classifier failed");
         return false;
     }
 
     // init sibling classifier.
-    string sibling_expression = this->_config.GetStringValue(c_section_name, "sibling_expression");
+    string sibling_expression = config.GetStringValue(c_section_name, "sibling_expression");
     success = this->_sibling_classifier.init(sibling_expression.c_str(), feature_names);
     if (!success)
     {
-        cout << "init sibling classifier failed" << endl;
+        ERROR_LOG(LOG_CONFIG, "init sibling classifier failed");
         return false;
     }
 
-    const vector<string>& factor_tag_names = this->_config.GetStringList(c_section_name, "factor_tag_names");
-    const vector<double>& factor_tag_values = this->_config.GetDoubleList(c_section_name, "factor_tag_values");
-    if (factor_tag_names.size() != factor_tag_values.size())
+    this->_factor_tag_names = config.GetStringList(c_section_name, "factor_tag_names");
+    this->_factor_tag_values = config.GetDoubleList(c_section_name, "factor_tag_values");
+    if (this->_factor_tag_names.size() != this->_factor_tag_values.size())
     {
-        cout << "factor tag name/values should be in pairs" << endl;
+        ERROR_LOG(LOG_CONFIG, "factor tag name/values should be in pairs");
         return false;
     }
 
+    // tag lists as atoms, the first one wins like match_list.
+    this->_negative_tag_names = config.GetStringList(c_section_name, "negative_tags");
+    this->_candidate_tag_names = config.GetStringList(c_section_name, "candidate_tag_names");
+    get_tag_set(this->_negative_tag_names, this->_negative_tags);
+    get_tag_set(this->_candidate_tag_names, this->_candidate_tags);
+    for (size_t i = 0; i < this->_factor_tag_names.size(); ++i)
+    {
+        HtmlTag tag = lookup_html_tag(this->_factor_tag_names[i].c_str());
+        if (tag != TAG_UNKNOWN && !this->_factor_tags.contains(tag))
+        {
+            this->_factor_tags.insert(tag);
+            this->_tag_factors[tag] = this->_factor_tag_values[i];
+        }
+    }
+
+    this->_negative_tags_enabled = config.GetBoolValue(c_section_name, "negative_tags_enabled");
+    this->_negative_class_ids_enabled = config.GetBoolValue(c_section_name, "negative_class_ids_enabled");
+    this->_include_parent_node_enabled = config.GetBoolValue(c_section_name, "include_parent_node_enabled");
+    this->_include_grand_parent_node_enabled = config.GetBoolValue(c_section_name, "include_grand_parent_node_enabled");
+    this->_min_text_length = config.GetIntValue(c_section_name, "min_text_length");
+    this->_class_id_matcher.add_patterns(config.GetStringList(c_section_name, "negative_class_ids"), CL_NEGATIVE);
+    this->_class_id_matcher.add_patterns(config.GetStringList(c_section_name, "good_class_ids"), CL_GOOD);
+    this->_class_id_matcher.add_patterns(config.GetStringList(c_section_name, "bad_class_ids"), CL_BAD);
+    this->_class_id_matcher.build();
+    // verdicts of other extractors with the same lists are shared, the fingerprint of the lists keeps the others apart.
+    if (config.GetBoolValue(c_section_name, "shared_class_id_cache_enabled", false))
+    {
+        this->_shared_class_id_cache = &SharedSubstringMatchCache::get_process_cache();
+    }
+    this->_flight_recorder_enabled = config.GetBoolValue(c_section_name, "flight_recorder_enabled", false);
+    this->_paragraph_break_punctuations = config.GetStringList(c_section_name, "paragraph_break_punctuations");
+    this->_paragraph_end_punctuations = config.GetStringList(c_section_name, "paragraph_end_punctuations");
+
     this->_initialized = true;
     return true;
 }
@@ -194,54 +412,121 @@ DomNode* BodyExtractor::extract(DomNode* dom) const
     assert(dom != NULL);
     assert(_initialized);
 
-    // traverse dom tree to drop invalid nodes, select candidate nodes, extract features
-    vector<DomNode*> candidates;
-    BodyExtractorVisitor visitor(this, candidates);
+    uint64_t start = stage_now();
+    this->begin_flight_document(0);
+    // traverse dom tree to drop invalid nodes, extract features, select and score candidate nodes
+    SubstringMatchCache class_ids(&this->_class_id_matcher, this->_shared_class_id_cache);
+    BodyExtractorVisitor visitor(this, class_ids);
+    DomTraversalStack stack;
     // call preprocess, visit, postprocess in visitor.
-    dom->postorder_traverse(visitor);
+    DomTreeTraversal<BodyExtractorVisitor>::postorder(dom, visitor, stack);
+    uint64_t time = record_stage(STAGE_TRAVERSE, start);
+    record_value(COUNT_NODES, visitor.get_node_count());
+    record_value(COUNT_CANDIDATES, visitor.get_candidate_count());
+    this->add_class_id_cache_stats(class_ids);
+    DomNode* body = this->extract_body(visitor.get_best_candidate(), time);
+    record_stage(STAGE_EXTRACT, start);
+    this->end_flight_document(body != NULL, start);
+    return body;
+}
+
+DomNode* BodyExtractor::extract(DomNode* dom, DomTreeVisitor& visitor) const
+{
+    assert(dom != NULL);
+    assert(_initialized);
+
+    uint64_t start = stage_now();
+    this->begin_flight_document(0);
+    // the extraction visitor goes first, it keeps the negative nodes until the visitor has seen them.
+    SubstringMatchCache class_ids(&this->_class_id_matcher, this->_shared_class_id_cache);
+    BodyExtractorVisitor extractor_visitor(this, class_ids, true);
+    FusedDomTreeVisitor<BodyExtractorVisitor, DomTreeVisitor> fused_visitor(extractor_visitor, visitor);
+    DomTraversalStack stack;
+    DomTreeTraversal<FusedDomTreeVisitor<BodyExtractorVisitor, DomTreeVisitor> >::postorder(dom, fused_visitor, stack);
+    extractor_visitor.drop_negative_nodes();
+    uint64_t time = record_stage(STAGE_TRAVERSE, start);
+    record_value(COUNT_NODES, extractor_visitor.get_node_count());
+    record_value(COUNT_CANDIDATES, extractor_visitor.get_candidate_count());
+    this->add_class_id_cache_stats(class_ids);
+    DomNode* body = this->extract_body(extractor_visitor.get_best_candidate(), time);
+    record_stage(STAGE_EXTRACT, start);
+    this->end_flight_document(body != NULL, start);
+    return body;
+}
 
-    // select ancestor nodes of candidates.
-    vector<DomNode*>::const_iterator end = candidates.end();
-    for (vector<DomNode*>::const_iterator iter = candidates.begin(); iter != end; ++iter)
+void BodyExtractor::get_class_id_cache_stats(uint64_t& lookup_count, uint64_t& hit_count) const
+{
+    lookup_count = __sync_fetch_and_add(&this->_class_id_lookup_count, 0);
+    hit_count = __sync_fetch_and_add(&this->_class_id_hit_count, 0);
+}
+
+void BodyExtractor::add_class_id_cache_stats(const SubstringMatchCache& class_ids) const
+{
+    __sync_fetch_and_add(&this->_class_id_lookup_count, class_ids.get_lookup_count());
+    __sync_fetch_and_add(&this->_class_id_hit_count, class_ids.get_hit_count());
+}
+
+void BodyExtractor::record_flight_event(FlightEventType type, const DomNode* node, int detail, double value) const
+{
+    if (this->_flight_recorder_enabled)
     {
-        this->select_ancestor_nodes(*iter, candidates);
+        FlightRecorder::get_thread_recorder().record(type, node->get_tag_atom(), node->get_class(), node->get_id(), detail, value);
     }
+}
 
-    // calculate scores, filter by threshold
-    for (size_t i = 0; i < candidates.size(); ++i)
+void BodyExtractor::record_flight_event(FlightEventType type, const FlatDom& dom, int32_t node, int detail, double value) const
+{
+    if (this->_flight_recorder_enabled)
     {
-        DomNode* node = candidates[i];
-        double score;
-        // calculate basic score
-        bool success = this->calculate_basic_score(node, score);
-        // set score
-        node->set_extra(FN_BASIC_WEIGHT, score);
-        // set is candidate
-        node->set_extra(FN_IS_CANDIDATE, success);
-        cout << "candidate " << node->get_tag() << " " << score << node->get_attribute("class") << " " << node->get_attribute("id") << endl;
+        FlightRecorder::get_thread_recorder().record(type, dom.get_tag_atom(node), dom.get_class(node), dom.get_id(node), detail, value);
     }
+}
 
-    if (candidates.size() == 0)
+void BodyExtractor::begin_flight_document(int detail) const
+{
+    if (this->_flight_recorder_enabled)
+    {
+        FlightRecorder::get_thread_recorder().begin_document(detail);
+    }
+}
+
+void BodyExtractor::end_flight_document(bool has_body, uint64_t start) const
+{
+    if (this->_flight_recorder_enabled)
+    {
+        double microseconds = static_cast<double>(stage_now() - start) / 1000;
+        FlightRecorder::get_thread_recorder().record(FLIGHT_DONE, TAG_UNKNOWN, NULL, NULL, has_body, microseconds);
+    }
+}
+
+DomNode* BodyExtractor::extract_body(DomNode* best_candidate, uint64_t start) const
+{
+    if (best_candidate == NULL)
     {
         return NULL; //TODO: try again without invalid node drop;
     }
 
-    DomNode* best_candidate = *(max_element(candidates.begin(), candidates.end(), comparer));
-    cout << "best candidate" << best_candidate->get_tag() << endl;
+    DEBUG_LOG(LOG_EXTRACT, "best candidate " << best_candidate->get_tag());
+    this->record_flight_event(FLIGHT_BEST, best_candidate, 0, best_candidate->get_extra(FN_BASIC_WEIGHT));
 
     // get the main body node
     DomNode* body = this->get_body(best_candidate);
+    uint64_t time = record_stage(STAGE_GET_BODY, start);
 
     if (body == NULL)
     {
         return NULL;
     }
 
+    this->record_flight_event(FLIGHT_BODY, body, 0, body->get_extra_default(FN_TEXT_LENGTH, 0));
+
     // sanitize
     this->sanitize(body);
 
     // post validation
-    if (this->post_validate(body))
+    bool valid = this->post_validate(body);
+    record_stage(STAGE_SANITIZE, time);
+    if (valid)
     {
         return body;
     }
@@ -251,50 +536,341 @@ DomNode* BodyExtractor::extract(DomNode* dom) const
     }
 }
 
-// called in DomNode::postorder_traverse, than called by visitor's preprocess.
-// drop negative node: by node tag, class and id to drop node. if should by dropped,
-// drop it and return true, else return false.
-bool BodyExtractor::drop_negative_node(DomNode* node) const
+// orders flat nodes as the postorder traversal visits them: node i is the
+// (subtree_end - 1 - depth)-th node finished, dropped nodes don't change the order of the others.
+class FlatPostorderLess
+{
+public:
+    FlatPostorderLess(const FlatDom& dom) :
+        _dom(dom)
+    {
+    }
+
+    bool operator()(int32_t first, int32_t second) const
+    {
+        return this->_dom.get_subtree_end(first) - this->_dom.get_depth(first) < this->_dom.get_subtree_end(second) - this->_dom.get_depth(second);
+    }
+
+private:
+    const FlatDom& _dom;
+};
+
+int32_t BodyExtractor::extract(const DomNode* dom, FlatDom& flat_dom, FlatDomMask& kept) const
+{
+    assert(dom != NULL);
+
+    uint64_t start = stage_now();
+    flat_dom.build(dom);
+    record_stage(STAGE_FLAT_BUILD, start);
+    return this->extract(flat_dom, kept);
+}
+
+// clear the kept flags of the subtree of node, which is a range in a flat tree.
+static void drop_flat_node(const FlatDom& dom, int32_t node, FlatDomMask& kept)
+{
+    kept.erase(node, dom.get_subtree_end(node));
+}
+
+int32_t BodyExtractor::extract(const FlatDom& dom, FlatDomMask& kept) const
+{
+    assert(_initialized);
+
+    kept.assign(dom.size(), true);
+    if (dom.size() == 0)
+    {
+        return -1;
+    }
+
+    uint64_t start = stage_now();
+    this->begin_flight_document(1);
+    vector<double> features(static_cast<size_t>(dom.size()) * FN_TOTAL_FEATURE_COUNT, 0);
+    vector<int32_t> candidates;
+    this->extract_flat_candidates(dom, kept, features, candidates);
+    uint64_t time = record_stage(STAGE_TRAVERSE, start);
+    record_value(COUNT_NODES, static_cast<uint64_t>(kept.count()));
+
+    // select ancestor nodes of candidates, as select_ancestor_nodes does.
+    for (size_t i = 0, count = candidates.size(); i < count; ++i)
+    {
+        int32_t parent = dom.get_parent(candidates[i]);
+        if (this->_include_parent_node_enabled && parent >= 0 && features[parent * FN_TOTAL_FEATURE_COUNT + FN_IS_CANDIDATE] == 0)
+        {
+            features[parent * FN_TOTAL_FEATURE_COUNT + FN_CANDIDATE_SOURCE] = 1;
+            features[parent * FN_TOTAL_FEATURE_COUNT + FN_IS_CANDIDATE] = 1;
+            candidates.push_back(parent);
+        }
+
+        if (this->_include_grand_parent_node_enabled && parent >= 0)
+        {
+            int32_t grand_parent = dom.get_parent(parent);
+            if (grand_parent >= 0 && features[grand_parent * FN_TOTAL_FEATURE_COUNT + FN_IS_CANDIDATE] == 0)
+            {
+                features[grand_parent * FN_TOTAL_FEATURE_COUNT + FN_CANDIDATE_SOURCE] = 2;
+                features[grand_parent * FN_TOTAL_FEATURE_COUNT + FN_IS_CANDIDATE] = 1;
+                candidates.push_back(grand_parent);
+            }
+        }
+    }
+
+    time = record_stage(STAGE_PROMOTE, time);
+    record_value(COUNT_CANDIDATES, candidates.size());
+    if (candidates.size() == 0)
+    {
+        record_stage(STAGE_EXTRACT, start);
+        this->end_flight_document(false, start);
+        return -1;
+    }
+
+    // calculate scores, the first one with the best score wins.
+    int32_t best_candidate = -1;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        double* node_features = &features[candidates[i] * FN_TOTAL_FEATURE_COUNT];
+        double score;
+        bool success = this->calculate_basic_score(node_features, score);
+        node_features[FN_BASIC_WEIGHT] = score;
+        node_features[FN_IS_CANDIDATE] = success;
+        this->record_flight_event(FLIGHT_CANDIDATE, dom, candidates[i], static_cast<int>(node_features[FN_CANDIDATE_SOURCE]) | (success ? 4 : 0), score);
+    }
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (best_candidate < 0 || features[candidates[i] * FN_TOTAL_FEATURE_COUNT + FN_BASIC_WEIGHT] > features[best_candidate * FN_TOTAL_FEATURE_COUNT + FN_BASIC_WEIGHT])
+        {
+            best_candidate = candidates[i];
+        }
+    }
+
+    time = record_stage(STAGE_SCORE, time);
+    this->record_flight_event(FLIGHT_BEST, dom, best_candidate, 0, features[best_candidate * FN_TOTAL_FEATURE_COUNT + FN_BASIC_WEIGHT]);
+    int32_t body = this->get_flat_body(dom, best_candidate, kept, features);
+    this->record_flight_event(FLIGHT_BODY, dom, body, 0, features[body * FN_TOTAL_FEATURE_COUNT + FN_TEXT_LENGTH]);
+    time = record_stage(STAGE_GET_BODY, time);
+    this->sanitize_flat(dom, body, kept, features);
+    record_stage(STAGE_SANITIZE, time);
+    record_stage(STAGE_EXTRACT, start);
+    this->end_flight_document(true, start);
+    return body;
+}
+
+void BodyExtractor::extract_flat_candidates(const FlatDom& dom, FlatDomMask& kept, vector<double>& features, vector<int32_t>& candidates) const
+{
+    SubstringMatchCache class_ids(&this->_class_id_matcher, this->_shared_class_id_cache);
+    // drop negative nodes in document order, the subtree of a dropped node is skipped.
+    for (int32_t i = 0; i < dom.size(); )
+    {
+        if (this->is_negative_node(dom.get_tag_atom(i), dom.get_tag(i), dom.get_class(i), dom.get_id(i), class_ids))
+        {
+            this->record_flight_event(FLIGHT_DROP, dom, i, 0, 0);
+            drop_flat_node(dom, i, kept);
+            i = dom.get_subtree_end(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // aggregate features in reverse document order, children come before their parents.
+    for (int32_t i = dom.size() - 1; i >= 0; --i)
+    {
+        if (!kept.contains(i))
+        {
+            continue;
+        }
+
+        double* node_features = &features[i * FN_TOTAL_FEATURE_COUNT];
+        bool has_children = false;
+        for (int32_t child = dom.get_first_child(i); child >= 0; child = dom.get_next_sibling(child))
+        {
+            if (!kept.contains(child))
+            {
+                continue;
+            }
+
+            const double* child_features = &features[child * FN_TOTAL_FEATURE_COUNT];
+            node_features[FN_TEXT_LENGTH] += child_features[FN_TEXT_LENGTH];
+            node_features[FN_COMMA_COUNT] += child_features[FN_COMMA_COUNT];
+            node_features[FN_CHAR_COUNT] += child_features[FN_CHAR_COUNT];
+            node_features[FN_STOP_COUNT] += child_features[FN_STOP_COUNT];
+            node_features[FN_LINK_LENGTH] += child_features[FN_LINK_LENGTH];
+            node_features[FN_NODE_COUNT] += child_features[FN_NODE_COUNT];
+            node_features[FN_LINK_COUNT] += child_features[FN_LINK_COUNT];
+            has_children = true;
+        }
+
+        TextStats text_stats;
+        for (size_t j = 0; j < dom.get_text_piece_count(i); ++j)
+        {
+            StringPiece piece = dom.get_text_piece(i, j);
+            count_text(piece.data(), piece.size(), text_stats);
+        }
+
+        this->calculate_features(dom.get_tag_atom(i), dom.get_tag(i), dom.get_class(i), dom.get_id(i), class_ids, has_children, dom.get_text_length(i), text_stats, node_features);
+        if (this->valid_node(dom.get_tag_atom(i), dom.get_tag(i), node_features[FN_TEXT_LENGTH]))
+        {
+            node_features[FN_CANDIDATE_SOURCE] = 0;
+            node_features[FN_IS_CANDIDATE] = 1;
+            candidates.push_back(i);
+        }
+    }
+
+    this->add_class_id_cache_stats(class_ids);
+    // same order as the candidates of the postorder traversal.
+    sort(candidates.begin(), candidates.end(), FlatPostorderLess(dom));
+}
+
+int32_t BodyExtractor::get_flat_body(const FlatDom& dom, int32_t best_candidate, FlatDomMask& kept, vector<double>& features) const
+{
+    int32_t parent = dom.get_parent(best_candidate);
+    if (parent < 0)
+    {
+        return best_candidate;
+    }
+
+    vector<int32_t> dropping_siblings;
+    string text;
+    for (int32_t sibling = dom.get_first_child(parent); sibling >= 0; sibling = dom.get_next_sibling(sibling))
+    {
+        if (!kept.contains(sibling))
+        {
+            continue;
+        }
+
+        double* sibling_features = &features[sibling * FN_TOTAL_FEATURE_COUNT];
+        if (sibling == best_candidate ||
+            (sibling_features[FN_IS_CANDIDATE] == 1 && sibling_features[FN_BASIC_WEIGHT] >= max(10.0, sibling_features[FN_BASIC_WEIGHT] * 0.2)))
+        {
+            continue;
+        }
+
+        // as valid_paragraph_sibling.
+        dom.get_text(sibling, text);
+        sibling_features[FN_IS_P_TAG] = dom.get_tag_atom(sibling) == TAG_P;
+        sibling_features[FN_HAS_BREAK_PUNC] = this->has_break_punctuation(text.c_str());
+        if (!this->_sibling_classifier.classify(FeatureArray(sibling_features, FN_TOTAL_FEATURE_COUNT)))
+        {
+            dropping_siblings.push_back(sibling);
+        }
+    }
+
+    // drop unlikely sibling nodes.
+    for (size_t i = 0; i < dropping_siblings.size(); ++i)
+    {
+        this->record_flight_event(FLIGHT_SIBLING_DROP, dom, dropping_siblings[i], 0, 0);
+        drop_flat_node(dom, dropping_siblings[i], kept);
+    }
+
+    int32_t only_child = -1;
+    int32_t child_count = 0;
+    for (int32_t child = dom.get_first_child(parent); child >= 0; child = dom.get_next_sibling(child))
+    {
+        if (kept.contains(child))
+        {
+            only_child = child;
+            ++child_count;
+        }
+    }
+
+    return child_count == 1 ? only_child : parent;
+}
+
+// as SanitizeVisitor in preorder. nodes which are not candidates keep the basic weight 0
+// of their features, as the tree nodes do after set_extras.
+void BodyExtractor::sanitize_flat(const FlatDom& dom, int32_t body, FlatDomMask& kept, vector<double>& features) const
+{
+    int32_t end = dom.get_subtree_end(body);
+    for (int32_t i = body; i < end; )
+    {
+        if (!kept.contains(i))
+        {
+            ++i;
+            continue;
+        }
+
+        double* node_features = &features[i * FN_TOTAL_FEATURE_COUNT];
+        if (this->_sanitize_classifier.classify(FeatureArray(node_features, FN_TOTAL_FEATURE_COUNT)))
+        {
+            this->record_flight_event(FLIGHT_SANITIZE_DROP, dom, i, 0, node_features[FN_BASIC_WEIGHT]);
+            drop_flat_node(dom, i, kept);
+            i = dom.get_subtree_end(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+bool BodyExtractor::drop_negative_node(DomNode* node, SubstringMatchCache& class_ids) const
+{
+    if (this->is_negative_node(node, class_ids))
+    {
+        DomNode::drop_node(node);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool BodyExtractor::is_negative_node(const DomNode* node, SubstringMatchCache& class_ids) const
+{
+    if (this->is_negative_node(node->get_tag_atom(), node->get_tag(), node->get_class(), node->get_id(), class_ids))
+    {
+        TRACE_LOG(LOG_EXTRACT, "dropped " << node->get_tag());
+        this->record_flight_event(FLIGHT_DROP, node, 0, 0);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// by node tag, class and id, should the node be dropped?
+bool BodyExtractor::is_negative_node(HtmlTag tag, const char* tag_name, const char* class_attrib, const char* id_attrib, SubstringMatchCache& class_ids) const
 {
     bool dropped = false;
     // if match negative_tags list, drop it.
-    if (this->_config.GetBoolValue(c_section_name, "negative_tags_enabled") && match_list(node->get_tag(), this->_config.GetStringList(c_section_name, "negative_tags"), 1) >= 0)
+    if (this->_negative_tags_enabled && this->match_tag(tag, tag_name, this->_negative_tags, this->_negative_tag_names))
     {
         dropped = true;
     }
     // if negative class ids enabled and match, drop it.
     // first use class, if can not drop by class, use id.
-    else if (this->_config.GetBoolValue(c_section_name, "negative_class_ids_enabled"))
+    // positive_class_ids are not read: the check against them has always been true,
+    // so a negative match is dropped whatever positive one it has.
+    else if (this->_negative_class_ids_enabled)
     {
-        const char* class_attrib = node->get_attribute("class");
-        if (class_attrib != NULL &&
-            match_list(class_attrib, this->_config.GetStringList(c_section_name, "negative_class_ids"), 2) >= 0 &&
-            !match_list(class_attrib, this->_config.GetStringList(c_section_name, "positive_class_ids"), 2) >= 0)
+        uint32_t class_lists = class_attrib != NULL ? class_ids.match(class_attrib) : 0;
+        if ((class_lists & CL_NEGATIVE) != 0)
         {
             dropped = true;
         }
         else
         {
-            const char* id_attrib = node->get_attribute("id");
-            if (id_attrib != NULL &&
-                match_list(id_attrib, this->_config.GetStringList(c_section_name, "negative_class_ids"), 2) >= 0 &&
-                !match_list(id_attrib, this->_config.GetStringList(c_section_name, "positive_class_ids"), 2) >= 0)
+            uint32_t id_lists = id_attrib != NULL ? class_ids.match(id_attrib) : 0;
+            if ((id_lists & CL_NEGATIVE) != 0)
             {
                 dropped = true;
             }
         }
     }
 
-    if (dropped)
-    {
-        cout << "dropped " << node->get_tag() << endl;
-        DomNode::drop_node(node);
-        return true;
-    }
-    else
+    return dropped;
+}
+
+// tags which are not atoms can't be in the set, they are matched by name.
+bool BodyExtractor::match_tag(HtmlTag tag, const char* tag_name, const HtmlTagSet& tags, const vector<string>& tag_names) const
+{
+    if (tag != TAG_UNKNOWN)
     {
-        return false;
+        return tags.contains(tag);
     }
+
+    return match_list(tag_name, tag_names, 1) >= 0;
 }
 
 bool BodyExtractor::rename_div(DomNode* node) const
@@ -304,11 +880,16 @@ bool BodyExtractor::rename_div(DomNode* node) const
 
 // is candidate?
 bool BodyExtractor::valid_node(DomNode* node) const
+{
+    return this->valid_node(node->get_tag_atom(), node->get_tag(), node->get_extra(FN_TEXT_LENGTH));
+}
+
+bool BodyExtractor::valid_node(HtmlTag tag, const char* tag_name, double text_length) const
 {
     // if match candidate tag names, and text length is enough
-    if (match_list(node->get_tag(), this->_config.GetStringList(c_section_name, "candidate_tag_names"), 1) >= 0)
+    if (this->match_tag(tag, tag_name, this->_candidate_tags, this->_candidate_tag_names))
     {
-        if (node->get_extra(FN_TEXT_LENGTH) <= this->_config.GetIntValue(c_section_name, "min_text_length"))
+        if (text_length <= this->_min_text_length)
         {
             return false;
         }
@@ -322,78 +903,114 @@ bool BodyExtractor::valid_node(DomNode* node) const
 }
 
 // extract features, and set info node's extras.
-void BodyExtractor::extract_features(DomNode* node) const
+void BodyExtractor::extract_features(DomNode* node, SubstringMatchCache& class_ids) const
 {
-    // get class and id
-    const char* class_attrib = node->get_attribute("class");
-    const char* id_attrib = node->get_attribute("id");
-
     // use enum as int, as count of enum members.
-    vector<double> features(FN_TOTAL_FEATURE_COUNT, 0);
+    double features[FN_TOTAL_FEATURE_COUNT] = {0};
 
-    // good class and ids.
-    if (match_list(class_attrib, this->_config.GetStringList(c_section_name, "good_class_ids"), 2) != -1)
+    // set features. why children? calculate from direct children
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        // get extra information from children, TODO but where extra in children been set?
+        DomNode* child = (*node->get_children())[i];
+        // text length
+        features[FN_TEXT_LENGTH] += child->get_extra(FN_TEXT_LENGTH);
+        // comma count
+        features[FN_COMMA_COUNT] += child->get_extra(FN_COMMA_COUNT);
+        // code point and stop count
+        features[FN_CHAR_COUNT] += child->get_extra(FN_CHAR_COUNT);
+        features[FN_STOP_COUNT] += child->get_extra(FN_STOP_COUNT);
+        // link length
+        features[FN_LINK_LENGTH] += child->get_extra(FN_LINK_LENGTH);
+        // node count
+        features[FN_NODE_COUNT] += child->get_extra(FN_NODE_COUNT);
+        // link count
+        features[FN_LINK_COUNT] += child->get_extra(FN_LINK_COUNT);
+    }
+
+    // count the text pieces so the text is not concatenated.
+    TextStats text_stats;
+    for (size_t i = 0; i < node->get_text_piece_count(); ++i)
+    {
+        StringPiece piece = node->get_text_piece(i);
+        count_text(piece.data(), piece.size(), text_stats);
+    }
+
+    this->calculate_features(node->get_tag_atom(), node->get_tag(), node->get_class(), node->get_id(), class_ids, node->get_children()->size() > 0, node->get_text_length(), text_stats, features);
+
+    // set extra into node.
+    node->set_extras(features, FN_TOTAL_FEATURE_COUNT);
+
+    if (LOG_ENABLED(LOG_LEVEL_TRACE, LOG_EXTRACT))
+    {
+        for (int j = 0; j < FN_TOTAL_FEATURE_COUNT; ++j)
+        {
+            TRACE_LOG(LOG_EXTRACT, "fe " << node->get_tag() << " " << node->get_class() << " " << node->get_id() << " " << c_feature_names[j] << " " << features[j]);
+        }
+    }
+}
+
+// features of one node, the sums of text length, comma, code point and stop counts, link length,
+// node count and link count over the children should be in features already.
+void BodyExtractor::calculate_features(HtmlTag tag, const char* tag_name, const char* class_attrib, const char* id_attrib, SubstringMatchCache& class_ids, bool has_children, size_t text_length, const TextStats& text_stats, double* features) const
+{
+    // good and bad class and ids, one scan each.
+    uint32_t class_lists = class_ids.match(class_attrib);
+    uint32_t id_lists = class_ids.match(id_attrib);
+    if ((class_lists & CL_GOOD) != 0)
     {
         ++features[FN_MATCHED_GOOD_CLASS_IDS];
     }
 
-    if (match_list(id_attrib, this->_config.GetStringList(c_section_name, "good_class_ids"), 2) != -1)
+    if ((id_lists & CL_GOOD) != 0)
     {
         ++features[FN_MATCHED_GOOD_CLASS_IDS];
     }
 
-    // bad class and ids.
-    if (match_list(class_attrib, this->_config.GetStringList(c_section_name, "bad_class_ids"), 2) != -1)
+    if ((class_lists & CL_BAD) != 0)
     {
         ++features[FN_MATCHED_BAD_CLASS_IDS];
     }
 
-    if (match_list(id_attrib, this->_config.GetStringList(c_section_name, "bad_class_ids"), 2) != -1)
+    if ((id_lists & CL_BAD) != 0)
     {
         ++features[FN_MATCHED_BAD_CLASS_IDS];
     }
 
     // factor tag names. TODO why called factor?
-    int pos = match_list(node->get_tag(), this->_config.GetStringList(c_section_name, "factor_tag_names"), 1);
-    if (pos != -1)
+    if (tag != TAG_UNKNOWN)
     {
-        features[FN_TAG_FACTOR] = this->_config.GetDoubleList(c_section_name, "factor_tag_values")[pos];
+        if (this->_factor_tags.contains(tag))
+        {
+            features[FN_TAG_FACTOR] = this->_tag_factors[tag];
+        }
     }
-
-    // set features. why children? calculate from direct children
-    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    else
     {
-        // get extra information from children, TODO but where extra in children been set?
-        DomNode* child = (*node->get_children())[i];
-        // text length
-        features[FN_TEXT_LENGTH] += child->get_extra(FN_TEXT_LENGTH);
-        // comma count
-        features[FN_COMMA_COUNT] += child->get_extra(FN_COMMA_COUNT);
-        // link length
-        features[FN_LINK_LENGTH] += child->get_extra(FN_LINK_LENGTH);
-        // node count
-        features[FN_NODE_COUNT] += child->get_extra(FN_NODE_COUNT);
-        // link count
-        features[FN_LINK_COUNT] += child->get_extra(FN_LINK_COUNT);
+        int pos = match_list(tag_name, this->_factor_tag_names, 1);
+        if (pos != -1)
+        {
+            features[FN_TAG_FACTOR] = this->_factor_tag_values[pos];
+        }
     }
 
     // TODO understand this
-    if (node->get_children()->size() == 0)
+    if (!has_children)
     {
         features[FN_NODE_COUNT] ++;
     }
 
-    // get text string of node
-    const string& text = node->get_text_string();
     // count with space.
-    features[FN_CURRENT_TEXT_LENGTH] = static_cast<int>(text.size());//count_without_spaces(text.c_str());
+    features[FN_CURRENT_TEXT_LENGTH] = static_cast<int>(text_length);//count_without_spaces(text.c_str());
     // same as current text length
     features[FN_TEXT_LENGTH] += features[FN_CURRENT_TEXT_LENGTH];
-    // add comma count.
-    features[FN_COMMA_COUNT] += static_cast<double>(count(text.begin(), text.end(), ',')); // TODO: need to consider chinese punctuations
+    // add comma count, with the chinese ones.
+    features[FN_COMMA_COUNT] += text_stats.comma_count;
+    features[FN_CHAR_COUNT] += text_stats.non_space_count;
+    features[FN_STOP_COUNT] += text_stats.stop_count;
 
     // get link count and length
-    if (strncmp(node->get_tag(), "a", 1) == 0) //TODO: case insensesive
+    if (tag == TAG_A)
     {
         features[FN_LINK_LENGTH] += features[FN_CURRENT_TEXT_LENGTH];
         features[FN_LINK_COUNT] ++;
@@ -405,66 +1022,84 @@ void BodyExtractor::extract_features(DomNode* node) const
     features[FN_LINK_NODE_DENSITY] = features[FN_NODE_COUNT] != 0 ? features[FN_LINK_COUNT] / features[FN_NODE_COUNT] : 0.0;
 
     // is header?
-    if (match_list(node->get_tag(),  c_header_tags, 1) >= 0)
+    if (c_header_tags.contains(tag))
     {
         features[FN_IS_HEADER_TAG] = 1;
     }
 
     // is interactive node?
-    if (match_list(node->get_tag(),  c_interactive_tags, 1) >= 0)
+    if (c_interactive_tags.contains(tag))
     {
         features[FN_IS_INTERACTIVE_TAG] = 1;
     }
 
     // is struct node?
-    if (match_list(node->get_tag(),  c_struct_tags, 1) >= 0)
+    if (c_struct_tags.contains(tag))
     {
         features[FN_IS_STRUCT_TAG] = 1;
     }
 
     features[FN_IS_CANDIDATE] = 0;
+}
 
-    // set extra into node.
-    for (int i = 0; i < static_cast<int>(features.size()); ++i)
-    {
-        node->set_extra(i, features[i]);
-    }
-
-    for (int j = 0; j < FN_TOTAL_FEATURE_COUNT; ++j)
-    {
-        cout << "fe " << node->get_tag() << " "  << node->get_attribute("class") << " " << node->get_attribute("id") << " " << node->get_extra(j) << " " << endl;
-    }
+int BodyExtractor::get_candidate_source(DomNode* node) const
+{
+    DomNode* promoter;
+    return this->get_candidate_source(node, promoter);
 }
 
-void BodyExtractor::select_ancestor_nodes(DomNode* node, vector<DomNode*>& candidates) const
+int BodyExtractor::get_candidate_source(DomNode* node, DomNode*& promoter) const
 {
-    DomNode* parent = node->get_parent();
-    if (this->_config.GetBoolValue(c_section_name, "include_parent_node_enabled") && parent != NULL && find(candidates.begin(), candidates.end(), parent) == candidates.end())
+    // a valid node is a candidate itself, source=0.
+    promoter = node;
+    if (this->valid_node(node))
     {
-        // TODO understand source=1
-        this->add_candidate(parent, 1, candidates);
+        return 0;
     }
 
-    if (this->_config.GetBoolValue(c_section_name, "include_grand_parent_node_enabled") && parent != NULL)
+    // the parent of a valid node, source=1, or its grand parent, source=2. the valid nodes
+    // were taken in postorder, the grand children under a child come before it.
+    const DomNodeList* children = node->get_children();
+    for (size_t i = 0; i < children->size(); ++i)
     {
-        DomNode* grand_parent = parent->get_parent();
+        DomNode* child = (*children)[i];
+        if (this->_include_grand_parent_node_enabled)
+        {
+            const DomNodeList* grand_children = child->get_children();
+            for (size_t j = 0; j < grand_children->size(); ++j)
+            {
+                if (this->valid_node((*grand_children)[j]))
+                {
+                    promoter = (*grand_children)[j];
+                    return 2;
+                }
+            }
+        }
 
-        if (grand_parent != NULL && find(candidates.begin(), candidates.end(), parent) == candidates.end())
+        if (this->_include_parent_node_enabled && this->valid_node(child))
         {
-            // TODO understand source=2
-            this->add_candidate(grand_parent, 2, candidates);
+            promoter = child;
+            return 1;
         }
     }
+
+    promoter = NULL;
+    return -1;
 }
 
-void BodyExtractor::add_candidate(DomNode* node, int source, vector<DomNode*>& candidates) const
+void BodyExtractor::score_candidate(DomNode* node, int source) const
 {
-    // if add into candidates as self, source=0.
-    // if add into candidates as parent node, source=1.
-    // if add into candidates as grand parent node, source=1.
     // use source to normalize score of candidates.
     node->set_extra(FN_CANDIDATE_SOURCE, source);
-    candidates.push_back(node);
+    double score;
+    // calculate basic score, filter by threshold
+    bool success = this->calculate_basic_score(node, score);
+    // set score
+    node->set_extra(FN_BASIC_WEIGHT, score);
+    // set is candidate
+    node->set_extra(FN_IS_CANDIDATE, success);
+    this->record_flight_event(FLIGHT_CANDIDATE, node, source | (success ? 4 : 0), score);
+    TRACE_LOG(LOG_EXTRACT, "candidate " << node->get_tag() << " " << score << " " << node->get_class() << " " << node->get_id());
 }
 
 void BodyExtractor::sort_candidates(vector<DomNode*>& candidates) const
@@ -498,6 +1133,7 @@ DomNode* BodyExtractor::get_body(DomNode* best_candidate) const
     // drop unlikely sibling nodes.
     for (size_t i = 0; i < dropping_siblings.size(); ++i)
     {
+        this->record_flight_event(FLIGHT_SIBLING_DROP, dropping_siblings[i], 0, 0);
         DomNode::drop_node(dropping_siblings[i]);
     }
 
@@ -517,17 +1153,21 @@ valid sibling classifier: FN_IS_P_TAG == 1 && FN_TEXT_CURRENT_LENGTH > 80 && FN_
 bool BodyExtractor::valid_paragraph_sibling(DomNode* sibling) const
 {
     // TODO has break func?
-    bool found_break_func =
-        match_list(sibling->get_text(), this->_config.GetStringList(c_section_name, "paragraph_break_punctuations"), 2) >= 0 ||
-        match_list(sibling->get_text(), this->_config.GetStringList(c_section_name, "paragraph_end_punctuations"), 3) >= 0;
+    bool found_break_func = this->has_break_punctuation(sibling->get_text());
 
-    sibling->set_extra(FN_IS_P_TAG, strncmp(sibling->get_tag(), "p", 1) == 0);
+    sibling->set_extra(FN_IS_P_TAG, sibling->get_tag_atom() == TAG_P);
     sibling->set_extra(FN_HAS_BREAK_PUNC, found_break_func);
 
     // understand sibling classifier, as in boolean classifier
     // boolean classifier is just judge by an expression, if satisfy it, return true, else return false.
     return this->_sibling_classifier.classify(sibling->get_extras());
 }
+
+bool BodyExtractor::has_break_punctuation(const char* text) const
+{
+    return match_list(text, this->_paragraph_break_punctuations, 2) >= 0 ||
+        match_list(text, this->_paragraph_end_punctuations, 3) >= 0;
+}
 /*
 current boolean expression for sanitize:
 FN_IS_HEADER_TAG == 1 && FN_BASIC_WEIGHT < 0 || FN_IS_HEADER_TAG == 1 && FN_LINK_DENSITY > 0.33 || FN_IS_INTERACTIVE_TAG == 1|| FN_IS_STRUCT_TAG == 1 && FN_BASIC_WEIGHT < 0
@@ -536,7 +1176,8 @@ TODO: some sanitize work has been dropped
 void BodyExtractor::sanitize(DomNode* body) const
 {
     SanitizeVisitor visitor(this);
-    body->preorder_traverse(visitor);
+    DomTraversalStack stack;
+    DomTreeTraversal<SanitizeVisitor>::preorder(body, visitor, stack);
 }
 
 // TODO: validate body text size, etc.;
@@ -547,15 +1188,15 @@ bool BodyExtractor::post_validate(const DomNode* body) const
 
 bool BodyExtractor::calculate_basic_score(const DomNode* node, double& score) const
 {
-    vector<double> features(FN_TOTAL_FEATURE_COUNT, 0);
-    for (int j = 0; j < FN_TOTAL_FEATURE_COUNT; ++j)
-    {
-        features[j] = node->get_extra(j);
-    }
+    // the extras are dense, ones not set are 0.
+    return this->calculate_basic_score(node->get_extras().values, score);
+}
 
+bool BodyExtractor::calculate_basic_score(const double* features, double& score) const
+{
     // call classifier to get score by features.
-    this->_basic_classifier.classify(features, score);
+    this->_basic_classifier.classify(features, FN_TOTAL_FEATURE_COUNT, score);
     // normalize score.
     score = score * (1 - features[FN_LINK_NODE_DENSITY]) / sqrt(features[FN_CANDIDATE_SOURCE] + 1);
-    return score >= this->_config.GetDoubleValue(c_section_name, "classifier_threshold");
+    return score >= this->_classifier_threshold;
 }
@@ -1,14 +1,20 @@
 #ifndef _BODY_EXTRACTOR_H_
 #define _BODY_EXTRACTOR_H_
 
-#include "config.h"
 #include "linear_classifier.h"
 #include "boolean_classifier.h"
 #include "dom_tree.h"
+#include "flat_dom.h"
+#include "substring_matcher.h"
+#include "flight_recorder.h"
 
 #include <vector>
 #include <string>
 
+struct TextStats;
+
+// init is not thread safe. once initialized, an extractor can be shared by many threads:
+// the const methods only write the documents given, and the cache counters, atomically.
 class BodyExtractor
 {
 public:
@@ -20,6 +26,21 @@ public:
 
     // returned dom node is a sub tree in the root dom tree, don't release this node since it shares the memory with root dom node
     DomNode* extract(DomNode* dom) const;
+    // the same, with visitor run in the traversal of the extraction: it sees every node,
+    // the negative ones are unlinked once their subtree is walked. it should not drop nodes itself.
+    DomNode* extract(DomNode* dom, DomTreeVisitor& visitor) const;
+
+    // the class and id values matched against the class/id lists since init, and the ones
+    // found in the cache of their document, which memoizes the values repeated in a page.
+    void get_class_id_cache_stats(uint64_t& lookup_count, uint64_t& hit_count) const;
+
+    // same extraction on a flat tree, which is not modified: kept has one flag per node
+    // and is cleared for the nodes extract(DomNode*) would drop.
+    // returns the body node, -1 if not found.
+    int32_t extract(const FlatDom& dom, FlatDomMask& kept) const;
+    // the same on dom, which is left untouched for other analyzers: flat_dom is built from it,
+    // the body is dom node flat_dom.get_node(body). serialize_html with kept writes the body.
+    int32_t extract(const DomNode* dom, FlatDom& flat_dom, FlatDomMask& kept) const;
 
 private:
 
@@ -77,26 +98,90 @@ private:
     friend class BodyExtractorVisitor;
     friend class SanitizeVisitor;
     friend bool comparer(const DomNode*, const DomNode*);
+    friend class BodyExtractorTest;
 
-    bool drop_negative_node(DomNode* node) const;
+    bool drop_negative_node(DomNode* node, SubstringMatchCache& class_ids) const;
+    bool is_negative_node(const DomNode* node, SubstringMatchCache& class_ids) const;
+    bool is_negative_node(HtmlTag tag, const char* tag_name, const char* class_attrib, const char* id_attrib, SubstringMatchCache& class_ids) const;
+    bool match_tag(HtmlTag tag, const char* tag_name, const HtmlTagSet& tags, const std::vector<std::string>& tag_names) const;
     bool rename_div(DomNode* node) const;
     bool valid_node(DomNode* node) const;
-    void extract_features(DomNode* node) const;
-    void select_ancestor_nodes(DomNode* node, std::vector<DomNode*>& candidates) const;
-    void add_candidate(DomNode* node, int source, std::vector<DomNode*>& candidates) const;
+    bool valid_node(HtmlTag tag, const char* tag_name, double text_length) const;
+    void extract_features(DomNode* node, SubstringMatchCache& class_ids) const;
+    void calculate_features(HtmlTag tag, const char* tag_name, const char* class_attrib, const char* id_attrib, SubstringMatchCache& class_ids, bool has_children, size_t text_length, const TextStats& text_stats, double* features) const;
+    // add the counters of the cache of a document to the totals.
+    void add_class_id_cache_stats(const SubstringMatchCache& class_ids) const;
+    // 0 if node is valid, 1 if it is the parent of a valid node, 2 if it is the grand parent
+    // of one, as far as enabled, else -1. node and its descendants should have their features.
+    int get_candidate_source(DomNode* node) const;
+    // promoter is the valid node which makes node a candidate, node itself for source=0.
+    int get_candidate_source(DomNode* node, DomNode*& promoter) const;
+    void score_candidate(DomNode* node, int source) const;
     void sort_candidates(std::vector<DomNode*>& candidates) const;
+    // the steps of extract after the traversal, which ended at start.
+    DomNode* extract_body(DomNode* best_candidate, uint64_t start) const;
     DomNode* get_body(DomNode* best_candidate) const;
     bool valid_paragraph_sibling(DomNode* sibling) const;
+    bool has_break_punctuation(const char* text) const;
     void sanitize(DomNode* body) const;
     bool post_validate(const DomNode* body) const;
     bool calculate_basic_score(const DomNode* node, double& score) const;
+    bool calculate_basic_score(const double* features, double& score) const;
+
+    // steps of extract(const FlatDom&), features has FN_TOTAL_FEATURE_COUNT values per node.
+    void extract_flat_candidates(const FlatDom& dom, FlatDomMask& kept, std::vector<double>& features, std::vector<int32_t>& candidates) const;
+    int32_t get_flat_body(const FlatDom& dom, int32_t best_candidate, FlatDomMask& kept, std::vector<double>& features) const;
+    void sanitize_flat(const FlatDom& dom, int32_t body, FlatDomMask& kept, std::vector<double>& features) const;
+
+    // add an event of a node to the flight recorder of the thread, if it is enabled.
+    void record_flight_event(FlightEventType type, const DomNode* node, int detail, double value) const;
+    void record_flight_event(FlightEventType type, const FlatDom& dom, int32_t node, int detail, double value) const;
+    // the document events around an extraction, start is when it began.
+    void begin_flight_document(int detail) const;
+    void end_flight_document(bool has_body, uint64_t start) const;
 
     bool _initialized;
 
-    Config _config;
     LinearClassifier _basic_classifier;
     BooleanClassifier _sanitize_classifier;
     BooleanClassifier _sibling_classifier;
+
+    // tag lists of the config as atom sets.
+    HtmlTagSet _negative_tags;
+    HtmlTagSet _candidate_tags;
+    HtmlTagSet _factor_tags;
+    double _tag_factors[TAG_COUNT];
+
+    // settings of the config, read once in init so the extraction never goes to the config.
+    bool _negative_tags_enabled;
+    bool _negative_class_ids_enabled;
+    bool _include_parent_node_enabled;
+    bool _include_grand_parent_node_enabled;
+    int _min_text_length;
+    double _classifier_threshold;
+    // the names are still needed for tags which are not atoms.
+    std::vector<std::string> _negative_tag_names;
+    std::vector<std::string> _candidate_tag_names;
+    std::vector<std::string> _factor_tag_names;
+    std::vector<double> _factor_tag_values;
+    // the class/id lists in one automaton, a scan of a class or id gives the lists it matches.
+    enum ClassIdLists
+    {
+        CL_NEGATIVE = 1 << 0,
+        CL_GOOD = 1 << 1,
+        CL_BAD = 1 << 2,
+    };
+
+    SubstringMatcher _class_id_matcher;
+    // the process cache if shared_class_id_cache_enabled, or NULL.
+    SharedSubstringMatchCache* _shared_class_id_cache;
+    // decisions go to the flight recorder of the thread if flight_recorder_enabled.
+    bool _flight_recorder_enabled;
+    // totals of the caches, updated atomically by the extractions of all threads.
+    mutable uint64_t _class_id_lookup_count;
+    mutable uint64_t _class_id_hit_count;
+    std::vector<std::string> _paragraph_break_punctuations;
+    std::vector<std::string> _paragraph_end_punctuations;
 };
 
 #endif
@@ -24,3 +24,8 @@ BODY_EXTRACTOR_FEATURE(FN_BASIC_WEIGHT)
 BODY_EXTRACTOR_FEATURE(FN_IS_CANDIDATE)
 BODY_EXTRACTOR_FEATURE(FN_IS_P_TAG)
 BODY_EXTRACTOR_FEATURE(FN_HAS_BREAK_PUNC)
+
+// code points without spaces and cjk stops over the subtree. FN_TEXT_LENGTH stays in bytes,
+// the thresholds are tuned on it.
+BODY_EXTRACTOR_FEATURE(FN_CHAR_COUNT)
+BODY_EXTRACTOR_FEATURE(FN_STOP_COUNT)
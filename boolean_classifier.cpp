@@ -4,10 +4,10 @@
 #include <vector>
 #include <map>
 #include <string>
-#include <iostream>
 #include <algorithm>
 #include <cstdlib>
 
+#include "log.h"
 #include "utils.h"
 
 using namespace std;
@@ -74,7 +74,7 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
             }
             else
             {
-                cout << "need and/or but met" << items[i] << endl;
+                ERROR_LOG(LOG_CONFIG, "need and/or but met " << items[i]);
                 return false;
             }
         }
@@ -84,7 +84,7 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
             {
                 if (current_not)
                 {
-                    cout << "duplicate not is not allowed" << endl;
+                    ERROR_LOG(LOG_CONFIG, "duplicate not is not allowed");
                     return false;
                 }
                 else
@@ -99,14 +99,14 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
                 {
                     if (i + 2 >= items.size())
                     {
-                        cout << "no comparer op found" << items[i] << endl;
+                        ERROR_LOG(LOG_CONFIG, "no comparer op found " << items[i]);
                         return false;
                     }
 
                     int comparer_op_id = match_list(items[i + 1].c_str(), comparer_ops, 1);
                     if (comparer_op_id < 0)
                     {
-                        cout << "invalid comparer op" << items[i] << endl;
+                        ERROR_LOG(LOG_CONFIG, "invalid comparer op " << items[i]);
                         return false;
                     }
 
@@ -119,7 +119,7 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
                 }
                 else
                 {
-                    cout << "need not or feature name but met" << items[i] << endl;
+                    ERROR_LOG(LOG_CONFIG, "need not or feature name but met " << items[i]);
                     return false;
                 }
             }
@@ -128,7 +128,7 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
 
     if (!needs_op)
     {
-        cout << "ends with op" << endl;
+        ERROR_LOG(LOG_CONFIG, "ends with op");
         return false;
     }
 
@@ -136,42 +136,8 @@ bool BooleanClassifier::init(const char* expression_str, const vector<string>& f
     return true;
 }
 
-bool BooleanClassifier::classify(const map<int, double>& features) const
+bool BooleanClassifier::compare(int comparer_op_id, double left_value, double right_value)
 {
-    int current_group_id = 0;
-    bool current_result = false;
-    for (size_t i = 0; i < this->_expression.size(); ++i)
-    {
-        const Atom& atom = this->_expression[i];
-        const map<int, double>::const_iterator iter = features.find(atom.feature_id);
-        assert(iter != features.end());
-        double feature_value = iter->second;
-
-        assert(atom.comparer_op_id < static_cast<int>(sizeof(c_comparers) / sizeof(c_comparers[0])));
-
-        if (current_result && atom.group_id > current_group_id)
-        {
-            return true;//return if one and group returns true
-        }
-        else if (atom.group_id < current_group_id)
-        {
-            continue; // skip if the and group is false
-        }
-
-        bool (*comparer)(double, double) = c_comparers[atom.comparer_op_id];
-        bool result = comparer(feature_value, atom.right_value);
-        if (atom.with_not)
-        {
-            result = !result;
-        }
-
-        if (!result)
-        {
-            ++current_group_id;
-        }
-
-        current_result = result;
-    }
-
-    return current_result;
+    assert(comparer_op_id >= 0 && comparer_op_id < static_cast<int>(sizeof(c_comparers) / sizeof(c_comparers[0])));
+    return c_comparers[comparer_op_id](left_value, right_value);
 }
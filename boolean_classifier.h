@@ -4,6 +4,18 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <assert.h>
+
+#include "feature_array.h"
+
+// map from feature id to value, the feature should be present.
+template <typename FeatureMap>
+double get_feature_value(const FeatureMap& features, int feature_id)
+{
+    const typename FeatureMap::const_iterator iter = features.find(feature_id);
+    assert(iter != features.end());
+    return iter->second;
+}
 
 class BooleanClassifier
 {
@@ -18,9 +30,14 @@ public:
     }
 
     bool init(const char* expression_str, const std::vector<std::string>& feature_names);
-    bool classify(const std::map<int, double>& features) const;
+
+    // features is a FeatureArray, such as DomNode::get_extras(), or a map from feature id to value.
+    template <typename Features>
+    bool classify(const Features& features) const;
 
 private:
+    static bool compare(int comparer_op_id, double left_value, double right_value);
+
     bool _initialized;
 
     struct Atom
@@ -41,4 +58,41 @@ private:
 
     std::vector<Atom> _expression;
 };
+
+template <typename Features>
+bool BooleanClassifier::classify(const Features& features) const
+{
+    int current_group_id = 0;
+    bool current_result = false;
+    for (size_t i = 0; i < this->_expression.size(); ++i)
+    {
+        const Atom& atom = this->_expression[i];
+        double feature_value = get_feature_value(features, atom.feature_id);
+
+        if (current_result && atom.group_id > current_group_id)
+        {
+            return true;//return if one and group returns true
+        }
+        else if (atom.group_id < current_group_id)
+        {
+            continue; // skip if the and group is false
+        }
+
+        bool result = BooleanClassifier::compare(atom.comparer_op_id, feature_value, atom.right_value);
+        if (atom.with_not)
+        {
+            result = !result;
+        }
+
+        if (!result)
+        {
+            ++current_group_id;
+        }
+
+        current_result = result;
+    }
+
+    return current_result;
+}
+
 #endif
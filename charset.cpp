@@ -0,0 +1,372 @@
+#include "charset.h"
+#include "charset_tables.h"
+#include "utils.h"
+
+#include <assert.h>
+#include <cstddef>
+#include <cstring>
+#include <strings.h>
+#include <stdint.h>
+
+using namespace std;
+
+static const char* c_charset_names[] = {"utf-8", "gbk", "big5", "windows-1252"};
+
+typedef char charset_name_check[sizeof(c_charset_names) / sizeof(c_charset_names[0]) == CHARSET_COUNT ? 1 : -1];
+
+struct CharsetLabel
+{
+    const char* label;
+    Charset charset;
+};
+
+static const CharsetLabel c_charset_labels[] =
+{
+    {"utf-8", CHARSET_UTF8},
+    {"utf8", CHARSET_UTF8},
+    {"unicode-1-1-utf-8", CHARSET_UTF8},
+    {"gb2312", CHARSET_GBK},
+    {"gbk", CHARSET_GBK},
+    {"gb18030", CHARSET_GBK},
+    {"x-gbk", CHARSET_GBK},
+    {"cp936", CHARSET_GBK},
+    {"ms936", CHARSET_GBK},
+    {"windows-936", CHARSET_GBK},
+    {"csgb2312", CHARSET_GBK},
+    {"gb_2312-80", CHARSET_GBK},
+    {"chinese", CHARSET_GBK},
+    {"big5", CHARSET_BIG5},
+    {"big5-hkscs", CHARSET_BIG5},
+    {"x-x-big5", CHARSET_BIG5},
+    {"cn-big5", CHARSET_BIG5},
+    {"csbig5", CHARSET_BIG5},
+    {"cp950", CHARSET_BIG5},
+    {"windows-1252", CHARSET_WINDOWS_1252},
+    {"cp1252", CHARSET_WINDOWS_1252},
+    {"x-cp1252", CHARSET_WINDOWS_1252},
+    {"iso-8859-1", CHARSET_WINDOWS_1252},
+    {"iso8859-1", CHARSET_WINDOWS_1252},
+    {"latin1", CHARSET_WINDOWS_1252},
+    {"l1", CHARSET_WINDOWS_1252},
+    {"us-ascii", CHARSET_WINDOWS_1252},
+    {"ascii", CHARSET_WINDOWS_1252},
+};
+
+// code points of the bytes 0x80 to 0x9f of windows-1252, 0 if not mapped.
+static const uint16_t c_windows_1252_table[32] =
+{
+    0x20ac, 0, 0x201a, 0x0192, 0x201e, 0x2026, 0x2020, 0x2021, 0x02c6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017d, 0,
+    0, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014, 0x02dc, 0x2122, 0x0161, 0x203a, 0x0153, 0, 0x017e, 0x0178,
+};
+
+// the double byte tables have a row of trail bytes 0x40 to 0xfe per lead byte.
+static const int c_trail_count = 0xff - 0x40;
+static const unsigned char c_gbk_first_lead = 0x81;
+static const unsigned char c_big5_first_lead = 0xa1;
+static const unsigned char c_big5_last_lead = 0xf9;
+
+// how far meta tags are searched for a charset, as html5 does, and how many bytes
+// are counted when there is none.
+static const size_t c_prescan_length = 1024;
+static const size_t c_sample_length = 64 * 1024;
+
+static const uint32_t c_replacement_char = 0xfffd;
+
+Charset lookup_charset(const char* label, size_t length)
+{
+    for (size_t i = 0; i < sizeof(c_charset_labels) / sizeof(c_charset_labels[0]); ++i)
+    {
+        if (strlen(c_charset_labels[i].label) == length && strncasecmp(c_charset_labels[i].label, label, length) == 0)
+        {
+            return c_charset_labels[i].charset;
+        }
+    }
+
+    return CHARSET_UNKNOWN;
+}
+
+const char* get_charset_name(Charset charset)
+{
+    assert(charset >= 0 && charset < CHARSET_COUNT);
+    return c_charset_names[charset];
+}
+
+static bool is_label_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == ':' || c == '.';
+}
+
+// the charset of the first "charset=label" which is known, from a meta tag such as
+// <meta charset="gbk"> or <meta http-equiv="content-type" content="text/html; charset=gbk">.
+static Charset find_meta_charset(const char* html, size_t length)
+{
+    static const char c_attribute[] = "charset";
+    const size_t attribute_length = sizeof(c_attribute) - 1;
+    const char* end = html + length;
+    for (const char* p = html; end - p > static_cast<ptrdiff_t>(attribute_length); ++p)
+    {
+        // accept-charset of forms is not a charset of the page.
+        if (strncasecmp(p, c_attribute, attribute_length) != 0 || (p > html && p[-1] == '-'))
+        {
+            continue;
+        }
+
+        const char* q = p + attribute_length;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'))
+        {
+            ++q;
+        }
+
+        if (q == end || *q != '=')
+        {
+            continue;
+        }
+
+        ++q;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n' || *q == '"' || *q == '\''))
+        {
+            ++q;
+        }
+
+        const char* label = q;
+        while (q < end && is_label_char(*q))
+        {
+            ++q;
+        }
+
+        Charset charset = lookup_charset(label, static_cast<size_t>(q - label));
+        if (charset != CHARSET_UNKNOWN)
+        {
+            return charset;
+        }
+    }
+
+    return CHARSET_UNKNOWN;
+}
+
+static uint32_t lookup_gbk(unsigned char lead, unsigned char trail)
+{
+    if (lead < c_gbk_first_lead || lead == 0xff || trail < 0x40 || trail == 0xff)
+    {
+        return 0;
+    }
+
+    return c_gbk_table[(lead - c_gbk_first_lead) * c_trail_count + (trail - 0x40)];
+}
+
+static uint32_t lookup_big5(unsigned char lead, unsigned char trail)
+{
+    if (lead < c_big5_first_lead || lead > c_big5_last_lead || trail < 0x40 || trail == 0xff)
+    {
+        return 0;
+    }
+
+    return c_big5_table[(lead - c_big5_first_lead) * c_trail_count + (trail - 0x40)];
+}
+
+// utf-8 if the sample is valid utf-8, else gbk or big5 if most of its pairs of bytes
+// >= 0x80 are chars of them, else windows-1252.
+static Charset guess_charset(const char* html, size_t length)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(html);
+    const unsigned char* end = p + length;
+    bool utf8 = true;
+    for (const unsigned char* q = p; q < end && utf8; )
+    {
+        if (*q < 0x80)
+        {
+            ++q;
+            continue;
+        }
+
+        uint32_t code_point;
+        size_t size = decode_utf8(reinterpret_cast<const char*>(q), static_cast<size_t>(end - q), code_point);
+        // a char may be cut by the end of the sample.
+        utf8 = size > 0 || (length == c_sample_length && end - q < 4);
+        q += size > 0 ? size : static_cast<size_t>(end - q);
+    }
+
+    if (utf8)
+    {
+        return CHARSET_UTF8;
+    }
+
+    // gbk and big5 both map most pairs, but the trail bytes of simplified chinese text
+    // are nearly always >= 0xa1, while big5 puts a good part of its common chars at 0x40 to 0x7e.
+    size_t pair_count = 0;
+    size_t gbk_count = 0;
+    size_t big5_count = 0;
+    size_t low_trail_count = 0;
+    while (p + 1 < end)
+    {
+        if (*p < 0x80)
+        {
+            ++p;
+            continue;
+        }
+
+        ++pair_count;
+        gbk_count += lookup_gbk(p[0], p[1]) != 0 ? 1 : 0;
+        big5_count += lookup_big5(p[0], p[1]) != 0 ? 1 : 0;
+        low_trail_count += p[1] < 0xa1 ? 1 : 0;
+        p += 2;
+    }
+
+    if (gbk_count * 4 < pair_count * 3 && big5_count * 4 < pair_count * 3)
+    {
+        return CHARSET_WINDOWS_1252;
+    }
+    else if (big5_count * 10 < gbk_count * 9)
+    {
+        return CHARSET_GBK;
+    }
+    else if (gbk_count * 10 < big5_count * 9)
+    {
+        return CHARSET_BIG5;
+    }
+
+    return low_trail_count * 8 > pair_count ? CHARSET_BIG5 : CHARSET_GBK;
+}
+
+Charset detect_charset(const char* html, size_t length)
+{
+    if (length >= 3 && memcmp(html, "\xef\xbb\xbf", 3) == 0)
+    {
+        return CHARSET_UTF8;
+    }
+
+    Charset charset = find_meta_charset(html, length < c_prescan_length ? length : c_prescan_length);
+    if (charset != CHARSET_UNKNOWN)
+    {
+        return charset;
+    }
+
+    return guess_charset(html, length < c_sample_length ? length : c_sample_length);
+}
+
+static char* write_utf8(uint32_t code_point, char* output)
+{
+    if (code_point < 0x80)
+    {
+        *output++ = static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        *output++ = static_cast<char>(0xc0 | (code_point >> 6));
+        *output++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    else
+    {
+        // the tables only have code points of the bmp.
+        assert(code_point < 0x10000);
+        *output++ = static_cast<char>(0xe0 | (code_point >> 12));
+        *output++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        *output++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+
+    return output;
+}
+
+// converts the char at p, which is >= 0x80, returns the bytes it takes.
+static size_t convert_double_byte(const unsigned char* p, const unsigned char* end, Charset charset, char*& output)
+{
+    if (charset == CHARSET_GBK && p[0] == 0x80)
+    {
+        // the euro sign of cp936.
+        output = write_utf8(0x20ac, output);
+        return 1;
+    }
+
+    if (end - p < 2)
+    {
+        output = write_utf8(c_replacement_char, output);
+        return 1;
+    }
+
+    uint32_t code_point = charset == CHARSET_GBK ? lookup_gbk(p[0], p[1]) : lookup_big5(p[0], p[1]);
+    if (code_point != 0)
+    {
+        output = write_utf8(code_point, output);
+        return 2;
+    }
+
+    output = write_utf8(c_replacement_char, output);
+    if (charset == CHARSET_GBK && end - p >= 4 && p[1] >= 0x30 && p[1] <= 0x39 && p[2] >= 0x81 && p[2] <= 0xfe && p[3] >= 0x30 && p[3] <= 0x39)
+    {
+        // a four byte char of gb18030 is one char.
+        return 4;
+    }
+
+    // an ascii byte after a lead byte is read again as a char.
+    return p[1] < 0x80 ? 1 : 2;
+}
+
+size_t convert_to_utf8(const char* text, size_t length, Charset charset, char* output)
+{
+    assert(charset >= 0 && charset < CHARSET_COUNT);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    const unsigned char* end = p + length;
+    char* begin = output;
+    if (charset == CHARSET_UTF8 && length >= 3 && memcmp(text, "\xef\xbb\xbf", 3) == 0)
+    {
+        p += 3;
+    }
+
+    while (p < end)
+    {
+        // runs of ascii are the same in every charset and are copied at once.
+        const unsigned char* ascii_end = p;
+        while (ascii_end < end && *ascii_end < 0x80)
+        {
+            ++ascii_end;
+        }
+
+        memcpy(output, p, static_cast<size_t>(ascii_end - p));
+        output += ascii_end - p;
+        p = ascii_end;
+        if (p == end)
+        {
+            break;
+        }
+
+        uint32_t code_point;
+        size_t size;
+        switch (charset)
+        {
+        case CHARSET_UTF8:
+            size = decode_utf8(reinterpret_cast<const char*>(p), static_cast<size_t>(end - p), code_point);
+            if (size > 0)
+            {
+                memcpy(output, p, size);
+                output += size;
+            }
+            else
+            {
+                output = write_utf8(c_replacement_char, output);
+                size = 1;
+            }
+
+            break;
+        case CHARSET_WINDOWS_1252:
+            code_point = *p < 0xa0 ? c_windows_1252_table[*p - 0x80] : *p;
+            // the bytes which are not mapped stay the c1 controls, as browsers read them.
+            output = write_utf8(code_point != 0 ? code_point : *p, output);
+            size = 1;
+            break;
+        default:
+            size = convert_double_byte(p, end, charset, output);
+            break;
+        }
+
+        p += size;
+    }
+
+    return static_cast<size_t>(output - begin);
+}
+
+void convert_to_utf8(const char* text, size_t length, Charset charset, string& utf8)
+{
+    utf8.resize(get_max_utf8_length(length));
+    size_t utf8_length = length > 0 ? convert_to_utf8(text, length, charset, &utf8[0]) : 0;
+    utf8.resize(utf8_length);
+}
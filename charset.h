@@ -0,0 +1,43 @@
+#ifndef _CHARSET_H_
+#define _CHARSET_H_
+
+#include <cstddef>
+#include <string>
+
+// charsets html is converted to utf-8 from, without iconv.
+enum Charset
+{
+    CHARSET_UNKNOWN = -1,
+    // ascii is read as utf-8.
+    CHARSET_UTF8 = 0,
+    // gb2312 and gbk, the four byte chars of gb18030 are not mapped.
+    CHARSET_GBK,
+    // big5 with the extensions of cp950.
+    CHARSET_BIG5,
+    // iso-8859-1 is read as windows-1252, as browsers do.
+    CHARSET_WINDOWS_1252,
+    CHARSET_COUNT,
+};
+
+// the charset of a label such as "gb2312" or "utf-8", case is ignored. CHARSET_UNKNOWN if
+// the label is not known.
+Charset lookup_charset(const char* label, size_t length);
+const char* get_charset_name(Charset charset);
+
+// the charset of html from its bom, else from the charset of a meta tag in the first
+// 1024 bytes, else from the byte statistics of its start. never CHARSET_UNKNOWN.
+Charset detect_charset(const char* html, size_t length);
+
+// converting length bytes to utf-8 never takes more bytes.
+inline size_t get_max_utf8_length(size_t length)
+{
+    return length * 3;
+}
+
+// converts text to utf-8 into output, which should hold get_max_utf8_length(length) bytes,
+// returns the length written. bytes which can't be converted are written as U+FFFD, a utf-8
+// bom is dropped. text in utf-8 is only checked and copied.
+size_t convert_to_utf8(const char* text, size_t length, Charset charset, char* output);
+void convert_to_utf8(const char* text, size_t length, Charset charset, std::string& utf8);
+
+#endif
@@ -146,7 +146,7 @@ int Config::GetIntValue(const string& section, const string& key) const
     {
         string value = this->GetValue(section, key);
         int int_value = atoi(value.c_str());
-        this->m_int_values[key] = int_value;
+        this->m_int_values[unique_key] = int_value;
         return int_value;
     }
 }
@@ -162,7 +162,7 @@ string Config::GetStringValue(const string& section, const string& key) const
     else
     {
         string value = this->GetValue(section, key);
-        this->m_string_values[key] = value;
+        this->m_string_values[unique_key] = value;
         return value;
     }
 }
@@ -191,7 +191,7 @@ double Config::GetDoubleValue(const string& section, const string& key) const
     {
         string value = this->GetValue(section, key);
         double double_value = atof(value.c_str());
-        this->m_double_values[key] = double_value;
+        this->m_double_values[unique_key] = double_value;
         return double_value;
     }
 }
@@ -220,7 +220,7 @@ bool Config::GetBoolValue(const string& section, const string& key) const
     {
         string value = this->GetValue(section, key);
         bool bool_value = strncmp(value.c_str(), "1", 1) == 0;
-        this->m_bool_values[key] = bool_value;
+        this->m_bool_values[unique_key] = bool_value;
         return bool_value;
     }
 }
@@ -317,4 +317,13 @@ const vector<double>& Config::GetDoubleList(const string& section, const string&
 void Config::Set(const string& section, const string& key, const string& value)
 {
     mConfig[section][key] = value;
+
+    // forget the parsed values of the old one.
+    const string unique_key = Config::GenUniqueKey(section, key);
+    this->m_int_values.erase(unique_key);
+    this->m_double_values.erase(unique_key);
+    this->m_bool_values.erase(unique_key);
+    this->m_string_values.erase(unique_key);
+    this->m_string_lists.erase(unique_key);
+    this->m_double_lists.erase(unique_key);
 }
@@ -4,9 +4,16 @@
 #include <string>
 #include <vector>
 
+// the getters cache what they parse, so even a const config should not be shared by threads.
+// the classes configured by it read their settings in init, and keep no config.
 class Config
 {
 public:
+    Config() :
+        mWrite(false)
+    {
+    }
+
     ~Config();
     bool Init(const char* conf_path, bool write = false);
     bool HasKey(const std::string& section, const std::string& key) const;
@@ -22,6 +29,7 @@ public:
     bool GetStringList(const std::string& section, const std::string& key, std::vector<std::string>& list, const char* delimeter = "") const;
     const std::vector<std::string>& GetStringList(const std::string& section, const std::string& key, const char* delimeter = "") const;
     const std::vector<double>& GetDoubleList(const std::string& section, const std::string& key, const char* delimeter = "") const;
+    // the cached values of key are dropped, lists returned for it before are no longer valid.
     void Set(const std::string& section, const std::string& key, const std::string& value);
 private:
     static std::string GenUniqueKey(const std::string& section, const std::string& key);
@@ -0,0 +1,88 @@
+#include "dom_arena.h"
+
+#include <assert.h>
+#include <cstring>
+#include <pthread.h>
+
+using namespace std;
+
+DomArena::~DomArena()
+{
+    for (size_t i = 0; i < this->m_blocks.size(); ++i)
+    {
+        delete[] this->m_blocks[i].data;
+    }
+}
+
+void* DomArena::allocate_slow(size_t size)
+{
+    // move on to the next kept block which is large enough, the rest of the
+    // skipped blocks is wasted until reset.
+    while (this->m_current + 1 < this->m_blocks.size())
+    {
+        ++this->m_current;
+        if (size <= this->m_blocks[this->m_current].size)
+        {
+            this->m_offset = size;
+            this->m_allocated_size += size;
+            return this->m_blocks[this->m_current].data;
+        }
+    }
+
+    Block block;
+    block.size = size > this->m_block_size ? size : this->m_block_size;
+    // new[] of char is aligned for any fundamental type.
+    block.data = new char[block.size];
+    this->m_blocks.push_back(block);
+    this->m_current = this->m_blocks.size() - 1;
+    this->m_offset = size;
+    this->m_allocated_size += size;
+    return block.data;
+}
+
+const char* DomArena::copy_string(const char* str, size_t length)
+{
+    char* copy = static_cast<char*>(this->allocate(length + 1));
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+size_t DomArena::get_capacity() const
+{
+    size_t capacity = 0;
+    for (size_t i = 0; i < this->m_blocks.size(); ++i)
+    {
+        capacity += this->m_blocks[i].size;
+    }
+
+    return capacity;
+}
+
+static pthread_key_t s_thread_arena_key;
+static pthread_once_t s_thread_arena_once = PTHREAD_ONCE_INIT;
+
+static void delete_thread_arena(void* arena)
+{
+    delete static_cast<DomArena*>(arena);
+}
+
+static void create_thread_arena_key()
+{
+    int result = pthread_key_create(&s_thread_arena_key, delete_thread_arena);
+    assert(result == 0);
+    (void)result;
+}
+
+DomArena& DomArena::get_thread_arena()
+{
+    pthread_once(&s_thread_arena_once, create_thread_arena_key);
+    DomArena* arena = static_cast<DomArena*>(pthread_getspecific(s_thread_arena_key));
+    if (arena == NULL)
+    {
+        arena = new DomArena();
+        pthread_setspecific(s_thread_arena_key, arena);
+    }
+
+    return *arena;
+}
@@ -0,0 +1,195 @@
+#ifndef _DOM_ARENA_H_
+#define _DOM_ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// bump allocator for everything of one document: the html buffer, nodes, child lists,
+// attributes and features. memory is never freed one by one, reset() drops the whole
+// document at once and keeps the blocks, so the next document on the same thread
+// doesn't allocate at all once the arena is warm.
+// destructors of objects in the arena are not run, they should not own heap memory.
+class DomArena
+{
+public:
+    DomArena(size_t block_size = 64 * 1024) :
+        m_block_size(block_size), m_current(0), m_offset(0), m_allocated_size(0)
+    {
+    }
+
+    ~DomArena();
+
+    // aligned for any type.
+    void* allocate(size_t size)
+    {
+        size = (size + c_alignment - 1) & ~(c_alignment - 1);
+        if (this->m_current < this->m_blocks.size() && this->m_offset + size <= this->m_blocks[this->m_current].size)
+        {
+            void* p = this->m_blocks[this->m_current].data + this->m_offset;
+            this->m_offset += size;
+            this->m_allocated_size += size;
+            return p;
+        }
+
+        return this->allocate_slow(size);
+    }
+
+    // memory is only given back if p is the last allocation, which is the usual case
+    // when a vector grows, otherwise it is kept until reset.
+    void deallocate(void* p, size_t size)
+    {
+        size = (size + c_alignment - 1) & ~(c_alignment - 1);
+        if (this->m_current < this->m_blocks.size() && this->m_offset >= size &&
+            static_cast<char*>(p) == this->m_blocks[this->m_current].data + this->m_offset - size)
+        {
+            this->m_offset -= size;
+            this->m_allocated_size -= size;
+        }
+    }
+
+    // copy str into the arena with a NUL at the end.
+    const char* copy_string(const char* str, size_t length);
+
+    // forget everything allocated, blocks are kept for reuse.
+    void reset()
+    {
+        this->m_current = 0;
+        this->m_offset = 0;
+        this->m_allocated_size = 0;
+    }
+
+    // bytes allocated since the last reset.
+    size_t get_allocated_size() const
+    {
+        return this->m_allocated_size;
+    }
+
+    // bytes held in blocks.
+    size_t get_capacity() const;
+
+    // arena of the calling thread, deleted when the thread exits.
+    static DomArena& get_thread_arena();
+
+private:
+    struct Block
+    {
+        char* data;
+        size_t size;
+    };
+
+    static const size_t c_alignment = 16;
+
+    void* allocate_slow(size_t size);
+
+    // not copyable.
+    DomArena(const DomArena&);
+    DomArena& operator=(const DomArena&);
+
+    size_t m_block_size;
+    std::vector<Block> m_blocks;
+    size_t m_current;
+    size_t m_offset;
+    size_t m_allocated_size;
+};
+
+// stl allocator on a DomArena, or on the heap if the arena is NULL,
+// so containers of nodes outside any arena keep working.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator(DomArena* arena = NULL) :
+        m_arena(arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) :
+        m_arena(other.get_arena())
+    {
+    }
+
+    DomArena* get_arena() const
+    {
+        return this->m_arena;
+    }
+
+    pointer address(reference x) const
+    {
+        return &x;
+    }
+
+    const_pointer address(const_reference x) const
+    {
+        return &x;
+    }
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        if (this->m_arena != NULL)
+        {
+            return static_cast<pointer>(this->m_arena->allocate(n * sizeof(T)));
+        }
+
+        return static_cast<pointer>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (this->m_arena != NULL)
+        {
+            this->m_arena->deallocate(p, n * sizeof(T));
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+
+    size_type max_size() const
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    void construct(pointer p, const T& value)
+    {
+        new (p) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+private:
+    DomArena* m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.get_arena() == b.get_arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.get_arena() != b.get_arena();
+}
+
+#endif
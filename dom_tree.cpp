@@ -1,146 +1,399 @@
 #include "dom_tree.h"
 
-#include <iostream>
+#include "log.h"
 #include <assert.h>
 #include <algorithm>
+#include <cstring>
 
 #include "utils.h"
 
 using namespace std;
 
 void (*DomNode::node_dropped)(DomNode*) = NULL;
+const double DomNode::s_no_extras[DomNode::c_extra_count] = {0};
 
-const char* DomNode::get_attribute(const char* name) const
+// presence of the extras is a 32 bits mask.
+typedef char extra_count_check[DomNode::c_extra_count <= 32 ? 1 : -1];
+
+void DomNode::append_text(const string& text)
 {
-    map<string, string>::const_iterator iter = this->m_attributes.find(string(name));
-    if (iter != this->m_attributes.end())
+    if (this->m_arena != NULL)
     {
-        return iter->second.c_str();
+        this->append_text(this->m_arena->copy_string(text.data(), text.size()), text.size());
+        return;
     }
-    else
+
+    if (this->is_text_view())
     {
-        return NULL;
+        // a copied piece turns the node into an owned one.
+        this->m_text = this->get_text_string();
+        this->m_text_view = StringPiece();
+        this->m_text_segments.clear();
+        this->m_text_length = 0;
+        delete[] this->m_text_joined;
+        this->m_text_joined = NULL;
     }
+
+    this->m_text.append(text);
 }
 
-void DomNode::find_tags(const char* tag_name, std::vector<DomNode*>& results)
+void DomNode::append_text(const char* text, size_t length)
 {
-    if (this->m_tag.compare(tag_name) == 0)
+    assert(text[length] == '\0');
+    if (!this->is_text_view() && !this->m_text.empty())
     {
-        results.push_back(this);
+        this->m_text.append(text, length);
+        return;
     }
 
-    for (size_t i = 0; i < this->m_children.size(); ++i)
+    if (!this->m_text_segments.empty())
     {
-        this->m_children[i]->find_tags(tag_name, results);
+        this->m_text_segments.push_back(StringPiece(text, length));
+    }
+    else if (this->m_text_view.data() != NULL)
+    {
+        this->m_text_segments.push_back(this->m_text_view);
+        this->m_text_segments.push_back(StringPiece(text, length));
+    }
+    else
+    {
+        this->m_text_view = StringPiece(text, length);
+    }
+
+    this->m_text_length += length;
+    if (this->m_text_joined != NULL)
+    {
+        if (this->m_arena == NULL)
+        {
+            delete[] this->m_text_joined;
+        }
+
+        this->m_text_joined = NULL;
     }
 }
 
-void DomNode::find_tags(const vector<string>& tag_names, vector<DomNode*>& results)
+const char* DomNode::get_text() const
 {
-    if (match_list(this->m_tag.c_str(), tag_names, 1) != -1)
+    if (this->m_text_segments.empty())
     {
-        results.push_back(this);
+        // a single piece is NUL terminated, no need to copy.
+        return this->m_text_view.data() != NULL ? this->m_text_view.data() : this->m_text.c_str();
     }
 
-    for (size_t i = 0; i < this->m_children.size(); ++i)
+    if (this->m_text_joined == NULL)
     {
-        this->m_children[i]->find_tags(tag_names, results);
+        size_t size = this->m_text_length + 1;
+        this->m_text_joined = this->m_arena != NULL ? static_cast<char*>(this->m_arena->allocate(size)) : new char[size];
+        char* p = this->m_text_joined;
+        for (size_t i = 0; i < this->m_text_segments.size(); ++i)
+        {
+            memcpy(p, this->m_text_segments[i].data(), this->m_text_segments[i].size());
+            p += this->m_text_segments[i].size();
+        }
+
+        *p = '\0';
     }
+
+    return this->m_text_joined;
 }
 
-bool DomNode::drop_node(DomNode* node)
+string DomNode::get_text_string() const
 {
-    assert(node != NULL);
+    if (!this->is_text_view())
+    {
+        return this->m_text;
+    }
 
-    if (DomNode::node_dropped != NULL)
+    string text;
+    text.reserve(this->m_text_length);
+    for (size_t i = 0; i < this->get_text_piece_count(); ++i)
     {
-        DomNode::node_dropped(node);
+        StringPiece piece = this->get_text_piece(i);
+        text.append(piece.data(), piece.size());
     }
 
-    cout << "before dropping" << node->m_parent->m_children.size() << endl;
+    return text;
+}
+
+// owned bits of DomAttribute.
+static const uint8_t c_owned_name = 1;
+static const uint8_t c_owned_value = 2;
 
-    if (node->m_parent == NULL)
+static char* copy_heap_string(const char* str)
+{
+    size_t length = strlen(str);
+    char* copy = new char[length + 1];
+    memcpy(copy, str, length + 1);
+    return copy;
+}
+
+void DomNode::add_attribute(const char* name, const char* value)
+{
+    // interned names are not copied.
+    HtmlAttribute name_id = lookup_html_attribute(name);
+    const char* copied_value;
+    uint8_t owned = 0;
+    if (this->m_arena != NULL)
     {
-        return false;
+        copied_value = this->m_arena->copy_string(value, strlen(value));
     }
     else
     {
-        for (vector<DomNode*>::iterator iter = node->m_parent->m_children.begin(); iter != node->m_parent->m_children.end(); ++iter)
+        copied_value = copy_heap_string(value);
+        owned |= c_owned_value;
+    }
+
+    DomAttribute* attribute = const_cast<DomAttribute*>(this->find_attribute(name_id, name));
+    if (attribute != NULL)
+    {
+        if (attribute->owned & c_owned_value)
         {
-            if (*iter == node)
-            {
-                node->m_parent->m_children.erase(iter);
-                break;
-            }
+            delete[] attribute->value;
         }
 
-        delete node;
-        return true;
+        attribute->value = copied_value;
+        attribute->owned = static_cast<uint8_t>((attribute->owned & c_owned_name) | owned);
+        return;
     }
+
+    const char* copied_name = get_html_attribute_name(name_id);
+    if (copied_name == NULL)
+    {
+        if (this->m_arena != NULL)
+        {
+            copied_name = this->m_arena->copy_string(name, strlen(name));
+        }
+        else
+        {
+            copied_name = copy_heap_string(name);
+            owned |= c_owned_name;
+        }
+    }
+
+    DomAttribute new_attribute = {copied_name, copied_value, name_id, owned};
+    this->push_attribute(new_attribute);
 }
 
-// preorder: first visit current, then visit children.
-bool DomNode::preorder_traverse(DomTreeVisitor& visitor)
+void DomNode::push_attribute(const DomAttribute& attribute)
 {
-    bool success = visitor.preprocess(this);
-    if (!success)
+    if (this->m_attribute_count == this->m_attribute_capacity)
     {
-        return false;
+        uint32_t capacity = this->m_attribute_capacity * 2;
+        DomAttribute* attributes;
+        if (this->m_arena != NULL)
+        {
+            attributes = static_cast<DomAttribute*>(this->m_arena->allocate(capacity * sizeof(DomAttribute)));
+        }
+        else
+        {
+            attributes = new DomAttribute[capacity];
+        }
+
+        copy(this->m_attributes, this->m_attributes + this->m_attribute_count, attributes);
+        if (this->m_arena == NULL && this->m_attributes != this->m_inline_attributes)
+        {
+            delete[] this->m_attributes;
+        }
+
+        this->m_attributes = attributes;
+        this->m_attribute_capacity = capacity;
     }
 
-    success = visitor.visit(this);
-    if (!success)
+    this->m_attributes[this->m_attribute_count++] = attribute;
+}
+
+void DomNode::free_attributes()
+{
+    for (uint32_t i = 0; i < this->m_attribute_count; ++i)
     {
-        return false;
+        if (this->m_attributes[i].owned & c_owned_name)
+        {
+            delete[] this->m_attributes[i].name;
+        }
+
+        if (this->m_attributes[i].owned & c_owned_value)
+        {
+            delete[] this->m_attributes[i].value;
+        }
+    }
+
+    if (this->m_attributes != this->m_inline_attributes)
+    {
+        delete[] this->m_attributes;
     }
+}
 
-    for (size_t i = 0; i < this->m_children.size(); ++i)
+void DomNode::set_tag(const string& tag_name)
+{
+    this->m_tag_atom = lookup_html_tag(tag_name.data(), tag_name.size());
+    if (this->m_arena != NULL)
     {
-        bool kept = this->m_children[i]->preorder_traverse(visitor);
-        if (!kept)
+        this->m_tag_view = this->m_arena->copy_string(tag_name.data(), tag_name.size());
+        return;
+    }
+
+    this->m_tag = tag_name;
+    this->m_tag_view = NULL;
+}
+
+const DomAttribute* DomNode::find_attribute(HtmlAttribute name_id, const char* name) const
+{
+    for (uint32_t i = 0; i < this->m_attribute_count; ++i)
+    {
+        const DomAttribute& attribute = this->m_attributes[i];
+        if (name_id != ATTR_UNKNOWN ? attribute.name_id == name_id : attribute.name_id == ATTR_UNKNOWN && strcmp(attribute.name, name) == 0)
         {
-            --i;
+            return &attribute;
         }
     }
 
-    visitor.postprocess(this);
-    return true;
+    return NULL;
 }
 
-// postorder: first visit children, then visit current
-bool DomNode::postorder_traverse(DomTreeVisitor& visitor)
+bool DomNode::has_attribute(const char* name) const
 {
-    cout << "visiting " << this->m_tag.c_str() << " " << this->m_children.size() << " " << this->get_attribute("class") << " " << this->get_attribute("id") << endl;
-    // in preprocess, drop negative node by tag, class, id.
-    // if dropped, success is false.
-    bool success = visitor.preprocess(this);
-    if (!success)
+    return this->find_attribute(lookup_html_attribute(name), name) != NULL;
+}
+
+const char* DomNode::get_attribute(const char* name) const
+{
+    HtmlAttribute name_id = lookup_html_attribute(name);
+    if (name_id != ATTR_UNKNOWN)
     {
-        return false;
+        return this->get_attribute(name_id);
     }
 
-    // postorder_traverse children.
-    for (size_t i = 0; i < this->m_children.size(); ++i)
+    const DomAttribute* attribute = this->find_attribute(name_id, name);
+    return attribute != NULL ? attribute->value : NULL;
+}
+
+const char* DomNode::get_attribute(HtmlAttribute name_id) const
+{
+    assert(name_id != ATTR_UNKNOWN);
+    const DomAttribute* attribute = this->find_attribute(name_id, NULL);
+    if (attribute != NULL)
+    {
+        return attribute->value;
+    }
+
+    return name_id == ATTR_CLASS || name_id == ATTR_ID ? "" : NULL;
+}
+
+void DomNode::get_attributes(vector<pair<const char*, const char*> >& attributes) const
+{
+    attributes.clear();
+    for (uint32_t i = 0; i < this->m_attribute_count; ++i)
+    {
+        attributes.push_back(make_pair(this->m_attributes[i].name, this->m_attributes[i].value));
+    }
+}
+
+void DomNode::find_tags(const char* tag_name, std::vector<DomNode*>& results)
+{
+    // preorder with an explicit stack, children are pushed in reverse order.
+    vector<DomNode*> nodes(1, this);
+    while (!nodes.empty())
+    {
+        DomNode* node = nodes.back();
+        nodes.pop_back();
+        if (strcmp(node->get_tag(), tag_name) == 0)
+        {
+            results.push_back(node);
+        }
+
+        nodes.insert(nodes.end(), node->m_children.rbegin(), node->m_children.rend());
+    }
+}
+
+void DomNode::find_tags(const vector<string>& tag_names, vector<DomNode*>& results)
+{
+    vector<DomNode*> nodes(1, this);
+    while (!nodes.empty())
     {
-        // if child been dropped in for loop, m_children size will change.
-        bool kept = this->m_children[i]->postorder_traverse(visitor);
-        if (!kept)
+        DomNode* node = nodes.back();
+        nodes.pop_back();
+        if (match_list(node->get_tag(), tag_names, 1) != -1)
         {
-            --i;
+            results.push_back(node);
         }
+
+        nodes.insert(nodes.end(), node->m_children.rbegin(), node->m_children.rend());
     }
+}
+
+bool DomNode::drop_node(DomNode* node)
+{
+    assert(node != NULL);
 
-    // in visit, extract features, and add into candidates if valid.
-    success = visitor.visit(this);
-    if (!success)
+    if (DomNode::node_dropped != NULL)
+    {
+        DomNode::node_dropped(node);
+    }
+
+    if (node->m_parent == NULL)
     {
         return false;
     }
+    else
+    {
+        TRACE_LOG(LOG_DOM, "dropping " << node->get_tag() << " of " << node->m_parent->m_children.size() << " children");
+
+        for (DomNodeList::iterator iter = node->m_parent->m_children.begin(); iter != node->m_parent->m_children.end(); ++iter)
+        {
+            if (*iter == node)
+            {
+                node->m_parent->m_children.erase(iter);
+                break;
+            }
+        }
+
+        // arena nodes are freed with the arena.
+        if (node->m_arena == NULL)
+        {
+            delete node;
+        }
+
+        return true;
+    }
+}
+
+// preorder: first visit current, then visit children.
+bool DomNode::preorder_traverse(DomTreeVisitor& visitor)
+{
+    DomTraversalStack stack;
+    return this->preorder_traverse(visitor, stack);
+}
+
+bool DomNode::preorder_traverse(DomTreeVisitor& visitor, DomTraversalStack& stack)
+{
+    return DomTreeTraversal<DomTreeVisitor>::preorder(this, visitor, stack);
+}
+
+// postorder: first visit children, then visit current
+bool DomNode::postorder_traverse(DomTreeVisitor& visitor)
+{
+    DomTraversalStack stack;
+    return this->postorder_traverse(visitor, stack);
+}
+
+bool DomNode::postorder_traverse(DomTreeVisitor& visitor, DomTraversalStack& stack)
+{
+    return DomTreeTraversal<DomTreeVisitor>::postorder(this, visitor, stack);
+}
 
-    // do nothing in postprocess of BodyExtractorVisitor
-    visitor.postprocess(this);
-    return true;
+void DomNode::delete_children()
+{
+    // children are moved to the stack before a node is deleted, so no destructor recurses.
+    vector<DomNode*> nodes(this->m_children.begin(), this->m_children.end());
+    this->m_children.clear();
+    while (!nodes.empty())
+    {
+        DomNode* node = nodes.back();
+        nodes.pop_back();
+        nodes.insert(nodes.end(), node->m_children.begin(), node->m_children.end());
+        node->m_children.clear();
+        delete node;
+    }
 }
 
 double DomNode::get_extra(int key) const
@@ -153,17 +406,42 @@ double DomNode::get_extra(int key) const
     }
     else
     {
-        cout <<"extra " << this->m_tag << key << endl;
+        ERROR_LOG(LOG_DOM, "no extra " << key << " in " << this->get_tag());
         assert(false);
     }
 }
 
+double* DomNode::get_extra_slots()
+{
+    if (this->m_extras == NULL)
+    {
+        if (this->m_arena != NULL)
+        {
+            this->m_extras = static_cast<double*>(this->m_arena->allocate(c_extra_count * sizeof(double)));
+        }
+        else
+        {
+            this->m_extras = new double[c_extra_count];
+        }
+
+        fill(this->m_extras, this->m_extras + c_extra_count, 0.0);
+    }
+
+    return this->m_extras;
+}
+
+void DomNode::set_extras(const double* values, int count)
+{
+    assert(count >= 0 && count <= c_extra_count);
+    copy(values, values + count, this->get_extra_slots());
+    this->m_extra_mask |= count < 32 ? (static_cast<uint32_t>(1) << count) - 1 : ~static_cast<uint32_t>(0);
+}
+
 bool DomNode::get_extra(int key, double& result) const
 {
-    std::map<int, double>::const_iterator iter = this->m_extras.find(key);
-    if (iter != this->m_extras.end())
+    if (this->has_extra(key))
     {
-        result = iter->second;
+        result = this->m_extras[key];
         return true;
     }
     else
@@ -186,10 +464,18 @@ double DomNode::get_extra_default(int key, double default_value) const
     }
 }
 
+void DomNode::print_visiting() const
+{
+    TRACE_LOG(LOG_DOM, "visiting " << this->get_tag() << " " << this->m_children.size() << " " << this->get_class() << " " << this->get_id());
+}
+
 void DomNode::print_node() const
 {
-    for (std::map<int, double>::const_iterator iter = this->m_extras.begin(); iter != this->m_extras.end(); ++iter)
+    for (int i = 0; i < c_extra_count; ++i)
     {
-        cout << this->m_tag.c_str() << " " << iter->first << " " << iter->second << endl;
+        if (this->has_extra(i))
+        {
+            DEBUG_LOG(LOG_DOM, this->get_tag() << " " << i << " " << this->m_extras[i]);
+        }
     }
 }
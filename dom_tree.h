@@ -3,8 +3,15 @@
 
 #include <vector>
 #include <string>
-#include <map>
 #include <cstdio>
+#include <assert.h>
+#include <stdint.h>
+
+#include "string_piece.h"
+#include "dom_arena.h"
+#include "feature_array.h"
+#include "html_tags.h"
+#include "log.h"
 
 class DomNode;
 
@@ -32,37 +39,160 @@ public:
     }
 };
 
+// base of visitors for DomTreeTraversal, the calls are resolved at compile time on the
+// derived type, so a visitor only defines the steps it needs and they are inlined.
+class InlineDomTreeVisitor
+{
+public:
+    bool preprocess(DomNode* node)
+    {
+        return true;
+    }
+
+    bool visit(DomNode* node)
+    {
+        return true;
+    }
+
+    bool postprocess(DomNode* node)
+    {
+        return true;
+    }
+};
+
+// runs two visitors in one traversal, nest it to fuse more of them:
+// FusedDomTreeVisitor<A, FusedDomTreeVisitor<B, C> >. First runs every step before
+// Second, a node dropped by First is not seen by Second, and its subtree by neither.
+// so a visitor which drops nodes goes first, and Second should not drop nodes
+// First keeps state about, like candidates of its visit.
+template <typename First, typename Second>
+class FusedDomTreeVisitor : public InlineDomTreeVisitor
+{
+public:
+    FusedDomTreeVisitor(First& first, Second& second) :
+        m_first(first), m_second(second)
+    {
+    }
+
+    bool preprocess(DomNode* node)
+    {
+        return this->m_first.preprocess(node) && this->m_second.preprocess(node);
+    }
+
+    bool visit(DomNode* node)
+    {
+        return this->m_first.visit(node) && this->m_second.visit(node);
+    }
+
+    bool postprocess(DomNode* node)
+    {
+        // the node is done for both, whatever the first one returns.
+        bool first = this->m_first.postprocess(node);
+        bool second = this->m_second.postprocess(node);
+        return first && second;
+    }
+
+private:
+    First& m_first;
+    Second& m_second;
+};
+
+// explicit stack of the traversals, so deep trees don't overflow the thread stack.
+// keep one around and pass it to the traversals to reuse its memory.
+class DomTraversalStack
+{
+public:
+    // an ancestor of the current node, and the index of the child the traversal went down into.
+    struct Frame
+    {
+        DomNode* node;
+        size_t child;
+    };
+
+    std::vector<Frame> frames;
+};
+
+typedef std::vector<DomNode*, ArenaAllocator<DomNode*> > DomNodeList;
+
+// an attribute of a node, name_id is ATTR_UNKNOWN if the name is not interned.
+struct DomAttribute
+{
+    const char* name;
+    const char* value;
+    HtmlAttribute name_id;
+    // which of name and value are owned by a heap node.
+    uint8_t owned;
+};
+
+// a node either owns copies of its tag, text and attributes, or only keeps views
+// into a buffer which outlives the node, such as the one given to HtmlParser::parse_in_place.
+// text of a view node may be made of several pieces, since tails of children are merged
+// into the parent's text, the pieces are only concatenated when get_text is called.
+// nodes created in a DomArena keep all their memory in the arena, they are never deleted,
+// the whole tree is gone with DomArena::reset. strings given to such nodes are copied into the arena.
 class DomNode
 {
 public:
     DomNode(const std::string& tag, const std::string& text) :
-        m_tag(tag), m_text(text), m_parent(NULL), m_children()
+        m_arena(NULL), m_tag(tag), m_tag_view(NULL), m_tag_atom(lookup_html_tag(tag.data(), tag.size())), m_text(text), m_text_length(0), m_text_joined(NULL), m_parent(NULL),
+        m_attributes(m_inline_attributes), m_attribute_count(0), m_attribute_capacity(c_inline_attribute_count),
+        m_extras(NULL), m_extra_mask(0)
     {
     }
 
+    // tag is a view, it should be NUL terminated and outlive the node.
+    explicit DomNode(const char* tag, DomArena* arena = NULL) :
+        m_arena(arena), m_tag_view(tag), m_tag_atom(lookup_html_tag(tag)), m_text_segments(ArenaAllocator<StringPiece>(arena)), m_text_length(0), m_text_joined(NULL),
+        m_parent(NULL), m_children(ArenaAllocator<DomNode*>(arena)),
+        m_attributes(m_inline_attributes), m_attribute_count(0), m_attribute_capacity(c_inline_attribute_count),
+        m_extras(NULL), m_extra_mask(0)
+    {
+    }
+
+    // a node in the arena, tag should outlive the arena content, such as a view into a buffer in the arena.
+    static DomNode* create(DomArena& arena, const char* tag)
+    {
+        return new (arena.allocate(sizeof(DomNode))) DomNode(tag, &arena);
+    }
+
     ~DomNode()
     {
-        for (size_t i = 0; i < m_children.size(); ++i)
+        // children of an arena node are freed with the arena.
+        if (this->m_arena == NULL)
         {
-            delete m_children[i];
-            m_children[i] = NULL;
+            this->delete_children();
+            delete[] this->m_text_joined;
+            delete[] this->m_extras;
+            this->free_attributes();
         }
     }
 
+    DomArena* get_arena() const
+    {
+        return this->m_arena;
+    }
+
     void append_child(DomNode* child)
     {
+        assert(child->m_arena == this->m_arena);
         this->m_children.push_back(child);
         child->m_parent = this;
     }
 
-    void append_text(const std::string& text)
-    {
-        this->m_text.append(text);
-    }
+    void append_text(const std::string& text);
+
+    // append a piece of text without copying, text[length] should be NUL
+    // and the piece should outlive the node.
+    void append_text(const char* text, size_t length);
 
-    void add_attribute(const char* name, const char* value)
+    // add a copy of the attribute, or replace the value of an existing one.
+    void add_attribute(const char* name, const char* value);
+
+    // add an attribute without copying, name and value should outlive the node.
+    void add_attribute_view(const char* name, const char* value)
     {
-        this->m_attributes[std::string(name)] = std::string(value);
+        DomAttribute attribute = {name, value, lookup_html_attribute(name), 0};
+        this->push_attribute(attribute);
     }
 
     DomNode* get_parent() const
@@ -70,47 +200,130 @@ public:
         return this->m_parent;
     }
 
-    const std::vector<DomNode*>* get_children() const
+    const DomNodeList* get_children() const
     {
         return &this->m_children;
     }
 
-    const char* get_text() const
+    // text pieces of a view node are concatenated on the first call.
+    const char* get_text() const;
+
+    std::string get_text_string() const;
+
+    size_t get_text_length() const
     {
-        return this->m_text.c_str();
+        return this->is_text_view() ? this->m_text_length : this->m_text.size();
     }
 
-    const std::string& get_text_string() const
+    // text as pieces, without concatenating the pieces of a view node.
+    size_t get_text_piece_count() const
     {
-        return this->m_text;
+        if (!this->m_text_segments.empty())
+        {
+            return this->m_text_segments.size();
+        }
+        else if (this->m_text_view.data() != NULL || !this->m_text.empty())
+        {
+            return 1;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    StringPiece get_text_piece(size_t i) const
+    {
+        if (!this->m_text_segments.empty())
+        {
+            return this->m_text_segments[i];
+        }
+        else if (this->m_text_view.data() != NULL)
+        {
+            return this->m_text_view;
+        }
+        else
+        {
+            return StringPiece(this->m_text.data(), this->m_text.size());
+        }
     }
 
     const char* get_tag() const
     {
-        return this->m_tag.c_str();
+        return this->m_tag_view != NULL ? this->m_tag_view : this->m_tag.c_str();
     }
 
-    void set_tag(const std::string& tag_name)
+    // TAG_UNKNOWN if the tag is not a known html tag.
+    HtmlTag get_tag_atom() const
     {
-        this->m_tag = tag_name;
+        return this->m_tag_atom;
     }
 
+    void set_tag(const std::string& tag_name);
+
+    bool has_attribute(const char* name) const;
+
+    // NULL if the node has no such attribute, but class and id are always there, empty if not set.
     const char* get_attribute(const char* name) const;
-    
-    bool has_extra(int key) const
+    const char* get_attribute(HtmlAttribute name_id) const;
+
+    // don't allocate, empty if not set.
+    const char* get_class() const
+    {
+        return this->get_attribute(ATTR_CLASS);
+    }
+
+    const char* get_id() const
+    {
+        return this->get_attribute(ATTR_ID);
+    }
+
+    size_t get_attribute_count() const
+    {
+        return this->m_attribute_count;
+    }
+
+    const DomAttribute& get_attribute_at(size_t i) const
     {
-        return this->m_extras.find(key) != this->m_extras.end();
+        return this->m_attributes[i];
     }
 
+    // name and value of all attributes, both copies and views.
+    void get_attributes(std::vector<std::pair<const char*, const char*> >& attributes) const;
+
+    // one extra slot per body extractor feature, keys are feature ids.
+    static const int c_extra_count = 0
+#define BODY_EXTRACTOR_FEATURE(f) + 1
+#include "body_extractor_features.h"
+#undef BODY_EXTRACTOR_FEATURE
+        ;
+
+    bool has_extra(int key) const
+    {
+        assert(key >= 0 && key < c_extra_count);
+        return (this->m_extra_mask >> key) & 1;
+    }
 
     void set_extra(int key, double value)
     {
-        this->m_extras[key] = value;
+        assert(key >= 0 && key < c_extra_count);
+        this->get_extra_slots()[key] = value;
+        this->m_extra_mask |= static_cast<uint32_t>(1) << key;
+    }
+
+    // set the first count extras at once.
+    void set_extras(const double* values, int count);
+
+    // all extras, the ones not set are 0.
+    FeatureArray get_extras() const
+    {
+        return FeatureArray(this->m_extras != NULL ? this->m_extras : s_no_extras, c_extra_count);
     }
 
-    const std::map<int, double>& get_extras() const
+    // bit key is set if extra key is set.
+    uint32_t get_extra_mask() const
     {
-        return this->m_extras;
+        return this->m_extra_mask;
     }
 
     static void register_node_dropped(void (*func)(DomNode*))
@@ -118,27 +331,197 @@ public:
         DomNode::node_dropped = func;
     }
 
+    // the extras of the node, logged at debug.
     void print_node() const;
+    // logged at trace for every node entered by the postorder traversal.
+    void print_visiting() const;
 
 public:
     void find_tags(const char* tag_name, std::vector<DomNode*>& results);
     void find_tags(const std::vector<std::string>& tag_names, std::vector<DomNode*>& results);
+    // unlink node from its parent, the node is deleted unless it is in an arena.
     static bool drop_node(DomNode* node);
+    // a visitor returning false from preprocess or visit should have dropped the node,
+    // the traversal goes on with the next sibling. returns false if the root is dropped.
     bool preorder_traverse(DomTreeVisitor& visitor);
+    bool preorder_traverse(DomTreeVisitor& visitor, DomTraversalStack& stack);
     bool postorder_traverse(DomTreeVisitor& visitor);
+    bool postorder_traverse(DomTreeVisitor& visitor, DomTraversalStack& stack);
     double get_extra(int key) const;
     bool get_extra(int key, double& result) const;
     double get_extra_default(int key, double default_value) const;
 
 protected:
+    bool is_text_view() const
+    {
+        return this->m_text_view.data() != NULL || !this->m_text_segments.empty();
+    }
+
+    // not copyable.
+    DomNode(const DomNode&);
+    DomNode& operator=(const DomNode&);
+
+    DomArena* m_arena;
     std::string m_tag;
+    const char* m_tag_view;
+    HtmlTag m_tag_atom;
+    // owned text, always empty in a view node.
     std::string m_text;
+    StringPiece m_text_view;
+    // all pieces once the text of a view node has more than one piece.
+    std::vector<StringPiece, ArenaAllocator<StringPiece> > m_text_segments;
+    size_t m_text_length;
+    // concatenated pieces, in the arena or on the heap.
+    mutable char* m_text_joined;
     DomNode* m_parent;
-    std::vector<DomNode*> m_children;
-    std::map<std::string, std::string> m_attributes;
-    std::map<int, double> m_extras;
+    DomNodeList m_children;
+
+    // attributes are inline up to c_inline_attribute_count, then in the arena or on the heap.
+    static const uint32_t c_inline_attribute_count = 3;
+    // without recursion, deep trees would overflow the stack.
+    void delete_children();
+
+    const DomAttribute* find_attribute(HtmlAttribute name_id, const char* name) const;
+    void push_attribute(const DomAttribute& attribute);
+    void free_attributes();
+
+    DomAttribute m_inline_attributes[c_inline_attribute_count];
+    DomAttribute* m_attributes;
+    uint32_t m_attribute_count;
+    uint32_t m_attribute_capacity;
+    // extras are allocated on the first set_extra, in the arena for an arena node.
+    double* get_extra_slots();
+
+    double* m_extras;
+    uint32_t m_extra_mask;
 
+    static const double s_no_extras[c_extra_count];
     static void (*node_dropped)(DomNode*);
 };
 
+// the traversals of DomNode with the visitor type known at compile time, Visitor is
+// DomTreeVisitor for the virtual calls, or a class like InlineDomTreeVisitor whose
+// steps are inlined into the loop. the semantics are the same as DomNode::preorder_traverse
+// and DomNode::postorder_traverse.
+template <typename Visitor>
+class DomTreeTraversal
+{
+public:
+    // preprocess and visit a node when it is entered, postprocess it when its children are done.
+    // the current node and child index stay in locals, the stack only holds the ancestors.
+    static bool preorder(DomNode* root, Visitor& visitor, DomTraversalStack& stack)
+    {
+        std::vector<DomTraversalStack::Frame>& frames = stack.frames;
+        frames.clear();
+
+        if (!visitor.preprocess(root) || !visitor.visit(root))
+        {
+            return false;
+        }
+
+        DomNode* node = root;
+        size_t index = 0;
+        while (true)
+        {
+            const DomNodeList& children = *node->get_children();
+            if (index < children.size())
+            {
+                DomNode* child = children[index];
+                if (!visitor.preprocess(child) || !visitor.visit(child))
+                {
+                    // the child is dropped, the next one moved into its place.
+                    continue;
+                }
+
+                if (child->get_children()->empty())
+                {
+                    // most nodes are leaves, they don't need a frame.
+                    visitor.postprocess(child);
+                    ++index;
+                    continue;
+                }
+
+                DomTraversalStack::Frame frame = {node, index};
+                frames.push_back(frame);
+                node = child;
+                index = 0;
+                continue;
+            }
+
+            visitor.postprocess(node);
+            if (frames.empty())
+            {
+                return true;
+            }
+
+            node = frames.back().node;
+            index = frames.back().child + 1;
+            frames.pop_back();
+        }
+    }
+
+    // preprocess a node when it is entered, visit and postprocess it when its children are done.
+    static bool postorder(DomNode* root, Visitor& visitor, DomTraversalStack& stack)
+    {
+        std::vector<DomTraversalStack::Frame>& frames = stack.frames;
+        frames.clear();
+
+        if (LOG_ENABLED(LOG_LEVEL_TRACE, LOG_DOM))
+        {
+            root->print_visiting();
+        }
+
+        // in preprocess, drop negative node by tag, class, id.
+        // if dropped, success is false.
+        if (!visitor.preprocess(root))
+        {
+            return false;
+        }
+
+        DomNode* node = root;
+        size_t index = 0;
+        while (true)
+        {
+            const DomNodeList& children = *node->get_children();
+            if (index < children.size())
+            {
+                DomNode* child = children[index];
+                if (LOG_ENABLED(LOG_LEVEL_TRACE, LOG_DOM))
+                {
+                    child->print_visiting();
+                }
+
+                if (!visitor.preprocess(child))
+                {
+                    // the child is dropped, the next one moved into its place.
+                    continue;
+                }
+
+                DomTraversalStack::Frame frame = {node, index};
+                frames.push_back(frame);
+                node = child;
+                index = 0;
+                continue;
+            }
+
+            // in visit, extract features, and add into candidates if valid.
+            bool kept = visitor.visit(node);
+            if (kept)
+            {
+                // do nothing in postprocess of BodyExtractorVisitor
+                visitor.postprocess(node);
+            }
+
+            if (frames.empty())
+            {
+                return kept;
+            }
+
+            node = frames.back().node;
+            index = frames.back().child + (kept ? 1 : 0);
+            frames.pop_back();
+        }
+    }
+};
+
 #endif
@@ -0,0 +1,25 @@
+#ifndef _FEATURE_ARRAY_H_
+#define _FEATURE_ARRAY_H_
+
+#include <cstddef>
+#include <assert.h>
+
+// dense features, the feature id is the index.
+struct FeatureArray
+{
+    FeatureArray(const double* values, size_t size) :
+        values(values), size(size)
+    {
+    }
+
+    const double* values;
+    size_t size;
+};
+
+inline double get_feature_value(const FeatureArray& features, int feature_id)
+{
+    assert(feature_id >= 0 && static_cast<size_t>(feature_id) < features.size);
+    return features.values[feature_id];
+}
+
+#endif
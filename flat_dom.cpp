@@ -0,0 +1,138 @@
+#include "flat_dom.h"
+
+#include <assert.h>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "dom_tree.h"
+
+using namespace std;
+
+void FlatDom::clear()
+{
+    this->m_parents.clear();
+    this->m_first_children.clear();
+    this->m_next_siblings.clear();
+    this->m_subtree_ends.clear();
+    this->m_depths.clear();
+    this->m_tag_ids.clear();
+    this->m_tag_atoms.clear();
+    this->m_classes.clear();
+    this->m_ids.clear();
+    this->m_text_lengths.clear();
+    this->m_text_begins.clear();
+    this->m_text_pieces.clear();
+    this->m_tag_names.clear();
+    this->m_nodes.clear();
+}
+
+void FlatDom::build(const DomNode* root)
+{
+    assert(root != NULL);
+    this->clear();
+
+    // known tags are interned by atom, only unknown ones need the name.
+    vector<int32_t> atom_tag_ids(TAG_COUNT, -1);
+    map<string, int32_t> tag_ids;
+    // index of the last child seen for every node, to link the next siblings.
+    vector<int32_t> last_children;
+    // explicit stack of (node, parent index), children are pushed in reverse order.
+    vector<pair<const DomNode*, int32_t> > stack;
+    stack.push_back(make_pair(root, -1));
+    while (!stack.empty())
+    {
+        const DomNode* node = stack.back().first;
+        int32_t parent = stack.back().second;
+        stack.pop_back();
+
+        int32_t index = this->size();
+        this->m_nodes.push_back(node);
+        this->m_parents.push_back(parent);
+        this->m_first_children.push_back(-1);
+        this->m_next_siblings.push_back(-1);
+        this->m_subtree_ends.push_back(index + 1);
+        this->m_depths.push_back(parent >= 0 ? this->m_depths[parent] + 1 : 0);
+        last_children.push_back(-1);
+
+        if (parent >= 0)
+        {
+            if (last_children[parent] >= 0)
+            {
+                this->m_next_siblings[last_children[parent]] = index;
+            }
+            else
+            {
+                this->m_first_children[parent] = index;
+            }
+
+            last_children[parent] = index;
+        }
+
+        HtmlTag atom = node->get_tag_atom();
+        int32_t tag_id;
+        if (atom != TAG_UNKNOWN)
+        {
+            if (atom_tag_ids[atom] < 0)
+            {
+                atom_tag_ids[atom] = static_cast<int32_t>(this->m_tag_names.size());
+                this->m_tag_names.push_back(node->get_tag());
+            }
+
+            tag_id = atom_tag_ids[atom];
+        }
+        else
+        {
+            map<string, int32_t>::iterator iter = tag_ids.find(node->get_tag());
+            if (iter == tag_ids.end())
+            {
+                iter = tag_ids.insert(make_pair(string(node->get_tag()), static_cast<int32_t>(this->m_tag_names.size()))).first;
+                this->m_tag_names.push_back(node->get_tag());
+            }
+
+            tag_id = iter->second;
+        }
+
+        this->m_tag_ids.push_back(tag_id);
+        this->m_tag_atoms.push_back(atom);
+        this->m_classes.push_back(node->get_class());
+        this->m_ids.push_back(node->get_id());
+
+        this->m_text_begins.push_back(static_cast<int32_t>(this->m_text_pieces.size()));
+        for (size_t i = 0; i < node->get_text_piece_count(); ++i)
+        {
+            this->m_text_pieces.push_back(node->get_text_piece(i));
+        }
+
+        this->m_text_lengths.push_back(node->get_text_length());
+
+        const DomNodeList* children = node->get_children();
+        for (size_t i = children->size(); i > 0; --i)
+        {
+            stack.push_back(make_pair((*children)[i - 1], index));
+        }
+    }
+
+    this->m_text_begins.push_back(static_cast<int32_t>(this->m_text_pieces.size()));
+
+    // children come after their parents, so the subtree ends are known in one reverse scan.
+    for (int32_t i = this->size() - 1; i > 0; --i)
+    {
+        int32_t parent = this->m_parents[i];
+        if (this->m_subtree_ends[i] > this->m_subtree_ends[parent])
+        {
+            this->m_subtree_ends[parent] = this->m_subtree_ends[i];
+        }
+    }
+}
+
+void FlatDom::get_text(int32_t node, string& text) const
+{
+    text.clear();
+    text.reserve(this->m_text_lengths[node]);
+    for (size_t i = 0; i < this->get_text_piece_count(node); ++i)
+    {
+        StringPiece piece = this->get_text_piece(node, i);
+        text.append(piece.data(), piece.size());
+    }
+}
@@ -0,0 +1,224 @@
+#ifndef _FLAT_DOM_H_
+#define _FLAT_DOM_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "html_tags.h"
+#include "string_piece.h"
+
+class DomNode;
+
+// one bit per node of a flat tree, like the nodes kept by an extraction.
+class FlatDomMask
+{
+public:
+    FlatDomMask() :
+        m_size(0)
+    {
+    }
+
+    // size bits, all set to value.
+    void assign(int32_t size, bool value)
+    {
+        this->m_size = size;
+        this->m_words.assign((static_cast<size_t>(size) + 63) / 64, value ? ~static_cast<uint64_t>(0) : 0);
+    }
+
+    int32_t size() const
+    {
+        return this->m_size;
+    }
+
+    bool contains(int32_t node) const
+    {
+        return (this->m_words[node / 64] >> (node % 64)) & 1;
+    }
+
+    void insert(int32_t node)
+    {
+        this->m_words[node / 64] |= static_cast<uint64_t>(1) << (node % 64);
+    }
+
+    void erase(int32_t node)
+    {
+        this->m_words[node / 64] &= ~(static_cast<uint64_t>(1) << (node % 64));
+    }
+
+    // clear the bits of [begin, end), like the subtree of a node.
+    void erase(int32_t begin, int32_t end)
+    {
+        for (; begin < end && begin % 64 != 0; ++begin)
+        {
+            this->erase(begin);
+        }
+
+        for (; begin + 64 <= end; begin += 64)
+        {
+            this->m_words[begin / 64] = 0;
+        }
+
+        for (; begin < end; ++begin)
+        {
+            this->erase(begin);
+        }
+    }
+
+    // count of the bits set.
+    int32_t count() const
+    {
+        int32_t count = 0;
+        for (size_t i = 0; i < this->m_words.size(); ++i)
+        {
+            // bits past size are set by assign, they are not counted.
+            uint64_t word = this->m_words[i];
+            if ((i + 1) * 64 > static_cast<size_t>(this->m_size))
+            {
+                word &= (static_cast<uint64_t>(1) << (this->m_size % 64)) - 1;
+            }
+
+            count += __builtin_popcountll(word);
+        }
+
+        return count;
+    }
+
+private:
+    std::vector<uint64_t> m_words;
+    int32_t m_size;
+};
+
+// a dom tree flattened into arrays in document (pre)order, node i is described by
+// the i-th entry of every array, so a traversal is a linear scan instead of chasing pointers.
+// the subtree of node i is the index range [i, get_subtree_end(i)), so the reverse scan
+// visits children before their parents, like a postorder traversal.
+// tags, class, id and text are views into the source tree, which should outlive the flat tree.
+class FlatDom
+{
+public:
+    FlatDom()
+    {
+    }
+
+    // flatten the tree of root, previous content is cleared.
+    void build(const DomNode* root);
+
+    void clear();
+
+    int32_t size() const
+    {
+        return static_cast<int32_t>(this->m_parents.size());
+    }
+
+    // -1 if node has no parent, first child or next sibling.
+    int32_t get_parent(int32_t node) const
+    {
+        return this->m_parents[node];
+    }
+
+    int32_t get_first_child(int32_t node) const
+    {
+        return this->m_first_children[node];
+    }
+
+    int32_t get_next_sibling(int32_t node) const
+    {
+        return this->m_next_siblings[node];
+    }
+
+    // one after the last node of the subtree.
+    int32_t get_subtree_end(int32_t node) const
+    {
+        return this->m_subtree_ends[node];
+    }
+
+    int32_t get_depth(int32_t node) const
+    {
+        return this->m_depths[node];
+    }
+
+    // tag ids are given in the order tags first appear in the document.
+    int32_t get_tag_id(int32_t node) const
+    {
+        return this->m_tag_ids[node];
+    }
+
+    HtmlTag get_tag_atom(int32_t node) const
+    {
+        return this->m_tag_atoms[node];
+    }
+
+    const char* get_tag(int32_t node) const
+    {
+        return this->m_tag_names[this->m_tag_ids[node]];
+    }
+
+    int32_t get_tag_count() const
+    {
+        return static_cast<int32_t>(this->m_tag_names.size());
+    }
+
+    const char* get_tag_name(int32_t tag_id) const
+    {
+        return this->m_tag_names[tag_id];
+    }
+
+    // empty if the source node has no such attribute.
+    const char* get_class(int32_t node) const
+    {
+        return this->m_classes[node];
+    }
+
+    const char* get_id(int32_t node) const
+    {
+        return this->m_ids[node];
+    }
+
+    size_t get_text_length(int32_t node) const
+    {
+        return this->m_text_lengths[node];
+    }
+
+    size_t get_text_piece_count(int32_t node) const
+    {
+        return static_cast<size_t>(this->m_text_begins[node + 1] - this->m_text_begins[node]);
+    }
+
+    StringPiece get_text_piece(int32_t node, size_t i) const
+    {
+        return this->m_text_pieces[static_cast<size_t>(this->m_text_begins[node]) + i];
+    }
+
+    // concatenated text of node.
+    void get_text(int32_t node, std::string& text) const;
+
+    const DomNode* get_node(int32_t node) const
+    {
+        return this->m_nodes[node];
+    }
+
+private:
+    // not copyable, the views are shared.
+    FlatDom(const FlatDom&);
+    FlatDom& operator=(const FlatDom&);
+
+    std::vector<int32_t> m_parents;
+    std::vector<int32_t> m_first_children;
+    std::vector<int32_t> m_next_siblings;
+    std::vector<int32_t> m_subtree_ends;
+    std::vector<int32_t> m_depths;
+    std::vector<int32_t> m_tag_ids;
+    std::vector<HtmlTag> m_tag_atoms;
+    std::vector<const char*> m_classes;
+    std::vector<const char*> m_ids;
+    std::vector<size_t> m_text_lengths;
+    // pieces of node i are [m_text_begins[i], m_text_begins[i + 1]).
+    std::vector<int32_t> m_text_begins;
+    std::vector<StringPiece> m_text_pieces;
+    std::vector<const char*> m_tag_names;
+    std::vector<const DomNode*> m_nodes;
+};
+
+#endif
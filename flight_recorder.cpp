@@ -0,0 +1,255 @@
+#include "flight_recorder.h"
+
+#include <assert.h>
+#include <cstring>
+#include <pthread.h>
+
+using namespace std;
+
+typedef char flight_event_size_check[sizeof(FlightEvent) == 32 ? 1 : -1];
+
+static const char* c_event_type_names[] =
+{
+    "document",
+    "drop",
+    "candidate",
+    "best",
+    "sibling_drop",
+    "body",
+    "sanitize_drop",
+    "done"
+};
+
+typedef char flight_event_name_check[sizeof(c_event_type_names) / sizeof(c_event_type_names[0]) == FLIGHT_EVENT_TYPE_COUNT ? 1 : -1];
+
+// header of a saved file, then for every thread its index, its event count and the events.
+static const char c_file_magic[8] = {'F', 'L', 'I', 'G', 'H', 'T', '0', '1'};
+
+// the recorders of every thread which recorded, they are kept after the thread exits
+// so their events can still be saved, and given to the next new thread.
+static pthread_mutex_t s_recorders_mutex = PTHREAD_MUTEX_INITIALIZER;
+static vector<FlightRecorder*>* s_all_recorders = NULL;
+static vector<FlightRecorder*>* s_free_recorders = NULL;
+static pthread_key_t s_thread_recorder_key;
+static pthread_once_t s_thread_recorder_once = PTHREAD_ONCE_INIT;
+
+static void release_thread_recorder(void* recorder)
+{
+    pthread_mutex_lock(&s_recorders_mutex);
+    s_free_recorders->push_back(static_cast<FlightRecorder*>(recorder));
+    pthread_mutex_unlock(&s_recorders_mutex);
+}
+
+static void create_thread_recorder_key()
+{
+    // never deleted, threads may still record while the process exits.
+    s_all_recorders = new vector<FlightRecorder*>();
+    s_free_recorders = new vector<FlightRecorder*>();
+    int result = pthread_key_create(&s_thread_recorder_key, release_thread_recorder);
+    assert(result == 0);
+    (void)result;
+}
+
+const size_t FlightRecorder::c_capacity;
+
+FlightRecorder::FlightRecorder(uint32_t thread_index) :
+    m_thread_index(thread_index),
+    m_document(0),
+    m_next(0),
+    m_claimed(0)
+{
+}
+
+FlightRecorder& FlightRecorder::get_thread_recorder()
+{
+    pthread_once(&s_thread_recorder_once, create_thread_recorder_key);
+    FlightRecorder* recorder = static_cast<FlightRecorder*>(pthread_getspecific(s_thread_recorder_key));
+    if (recorder == NULL)
+    {
+        pthread_mutex_lock(&s_recorders_mutex);
+        if (!s_free_recorders->empty())
+        {
+            recorder = s_free_recorders->back();
+            s_free_recorders->pop_back();
+        }
+        else
+        {
+            recorder = new FlightRecorder(static_cast<uint32_t>(s_all_recorders->size()));
+            s_all_recorders->push_back(recorder);
+        }
+
+        pthread_mutex_unlock(&s_recorders_mutex);
+        pthread_setspecific(s_thread_recorder_key, recorder);
+    }
+
+    return *recorder;
+}
+
+void FlightRecorder::begin_document(int detail)
+{
+    ++this->m_document;
+    this->record(FLIGHT_DOCUMENT, TAG_UNKNOWN, NULL, NULL, detail, 0);
+}
+
+void FlightRecorder::record(FlightEventType type, HtmlTag tag, const char* class_attrib, const char* id_attrib, int detail, double value)
+{
+    FlightEvent event;
+    event.document = this->m_document;
+    event.type = static_cast<uint8_t>(type);
+    event.detail = static_cast<uint8_t>(detail);
+    event.tag = static_cast<uint16_t>(tag);
+    event.value = static_cast<float>(value);
+    memset(event.name, 0, sizeof(event.name));
+    if (class_attrib != NULL && class_attrib[0] != '\0')
+    {
+        memcpy(event.name, class_attrib, strnlen(class_attrib, sizeof(event.name)));
+    }
+    else if (id_attrib != NULL && id_attrib[0] != '\0')
+    {
+        event.name[0] = '#';
+        memcpy(event.name + 1, id_attrib, strnlen(id_attrib, sizeof(event.name) - 1));
+    }
+
+    uint64_t words[c_event_words];
+    memcpy(words, &event, sizeof(event));
+
+    // the slot is claimed before it is written, the fence keeps a reader which sees the
+    // new words from missing the claim. the words are published by the store of m_next.
+    uint64_t next = __atomic_load_n(&this->m_next, __ATOMIC_RELAXED);
+    __atomic_store_n(&this->m_claimed, next + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    uint64_t* slot = &this->m_words[(next % c_capacity) * c_event_words];
+    for (size_t i = 0; i < c_event_words; ++i)
+    {
+        __atomic_store_n(&slot[i], words[i], __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&this->m_next, next + 1, __ATOMIC_RELEASE);
+}
+
+void FlightRecorder::get_events(vector<FlightEvent>& events) const
+{
+    events.clear();
+    uint64_t end = __atomic_load_n(&this->m_next, __ATOMIC_ACQUIRE);
+    uint64_t begin = end > c_capacity ? end - c_capacity : 0;
+    vector<uint64_t> words(static_cast<size_t>(end - begin) * c_event_words);
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        const uint64_t* slot = &this->m_words[(i % c_capacity) * c_event_words];
+        for (size_t j = 0; j < c_event_words; ++j)
+        {
+            words[static_cast<size_t>(i - begin) * c_event_words + j] = __atomic_load_n(&slot[j], __ATOMIC_RELAXED);
+        }
+    }
+
+    // the events before the last claimed one - c_capacity may have been written over
+    // while they were copied.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t claimed = __atomic_load_n(&this->m_claimed, __ATOMIC_RELAXED);
+    uint64_t first_valid = claimed > c_capacity ? claimed - c_capacity : 0;
+    for (uint64_t i = begin > first_valid ? begin : first_valid; i < end; ++i)
+    {
+        FlightEvent event;
+        memcpy(&event, &words[static_cast<size_t>(i - begin) * c_event_words], sizeof(event));
+        events.push_back(event);
+    }
+}
+
+bool FlightRecorder::save_all(FILE* file)
+{
+    pthread_once(&s_thread_recorder_once, create_thread_recorder_key);
+    pthread_mutex_lock(&s_recorders_mutex);
+    vector<FlightRecorder*> recorders(*s_all_recorders);
+    pthread_mutex_unlock(&s_recorders_mutex);
+
+    bool success = fwrite(c_file_magic, sizeof(c_file_magic), 1, file) == 1;
+    vector<FlightEvent> events;
+    for (size_t i = 0; i < recorders.size() && success; ++i)
+    {
+        recorders[i]->get_events(events);
+        uint32_t header[2] = {recorders[i]->get_thread_index(), static_cast<uint32_t>(events.size())};
+        success = fwrite(header, sizeof(header), 1, file) == 1;
+        if (success && !events.empty())
+        {
+            success = fwrite(&events[0], sizeof(FlightEvent), events.size(), file) == events.size();
+        }
+    }
+
+    return success;
+}
+
+bool FlightRecorder::load(FILE* file, vector<FlightThreadEvents>& threads)
+{
+    threads.clear();
+    char magic[sizeof(c_file_magic)];
+    if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, c_file_magic, sizeof(magic)) != 0)
+    {
+        return false;
+    }
+
+    uint32_t header[2];
+    while (fread(header, sizeof(header), 1, file) == 1)
+    {
+        if (header[1] > c_capacity)
+        {
+            return false;
+        }
+
+        threads.push_back(FlightThreadEvents());
+        threads.back().thread = header[0];
+        vector<FlightEvent>& events = threads.back().events;
+        events.resize(header[1]);
+        if (!events.empty() && fread(&events[0], sizeof(FlightEvent), events.size(), file) != events.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FlightRecorder::format_event(const FlightEvent& event, string& text)
+{
+    char line[160];
+    string name(event.name, strnlen(event.name, sizeof(event.name)));
+    const char* tag_name = event.tag < TAG_COUNT ? get_html_tag_name(static_cast<HtmlTag>(event.tag)) : NULL;
+    string node = tag_name != NULL ? tag_name : "?";
+    if (!name.empty())
+    {
+        node += name[0] == '#' ? "" : ".";
+        node += name;
+    }
+
+    const char* type_name = event.type < FLIGHT_EVENT_TYPE_COUNT ? c_event_type_names[event.type] : "unknown";
+    switch (event.type)
+    {
+    case FLIGHT_DOCUMENT:
+        snprintf(line, sizeof(line), "%u %s %s", event.document, type_name, event.detail == 0 ? "tree" : "flat");
+        break;
+    case FLIGHT_CANDIDATE:
+        snprintf(line, sizeof(line), "%u %s %s source %d %s %g", event.document, type_name, node.c_str(), event.detail & 3,
+            (event.detail & 4) != 0 ? "passed" : "failed", event.value);
+        break;
+    case FLIGHT_BEST:
+    case FLIGHT_SANITIZE_DROP:
+        snprintf(line, sizeof(line), "%u %s %s score %g", event.document, type_name, node.c_str(), event.value);
+        break;
+    case FLIGHT_BODY:
+        snprintf(line, sizeof(line), "%u %s %s text %g", event.document, type_name, node.c_str(), event.value);
+        break;
+    case FLIGHT_DONE:
+        snprintf(line, sizeof(line), "%u %s %s %g us", event.document, type_name, event.detail != 0 ? "body" : "no_body", event.value);
+        break;
+    default:
+        snprintf(line, sizeof(line), "%u %s %s", event.document, type_name, node.c_str());
+        break;
+    }
+
+    text = line;
+}
+
+const char* FlightRecorder::get_event_type_name(FlightEventType type)
+{
+    assert(type >= 0 && type < FLIGHT_EVENT_TYPE_COUNT);
+    return c_event_type_names[type];
+}
@@ -0,0 +1,105 @@
+#ifndef _FLIGHT_RECORDER_H_
+#define _FLIGHT_RECORDER_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "html_tags.h"
+
+// the decisions of an extraction, in the order they are made.
+enum FlightEventType
+{
+    // an extraction starts, detail is 0 for a tree and 1 for a flat tree.
+    FLIGHT_DOCUMENT,
+    // a negative node is dropped with its subtree.
+    FLIGHT_DROP,
+    // a candidate is scored, detail is its source, plus 4 if the score passed the threshold.
+    FLIGHT_CANDIDATE,
+    // the best candidate, value is its score.
+    FLIGHT_BEST,
+    // a sibling of the best candidate is dropped by get_body.
+    FLIGHT_SIBLING_DROP,
+    // the body before sanitize, value is its text length.
+    FLIGHT_BODY,
+    // a node of the body is dropped by sanitize, value is its score.
+    FLIGHT_SANITIZE_DROP,
+    // the extraction is done, detail is 1 if a body was returned, value is the time in microseconds.
+    FLIGHT_DONE,
+    FLIGHT_EVENT_TYPE_COUNT
+};
+
+// an event as it is kept and saved, the node is told by its tag and the start of its
+// class, or # and its id if it has no class.
+struct FlightEvent
+{
+    // number of the document in its thread, from 1.
+    uint32_t document;
+    uint8_t type;
+    uint8_t detail;
+    uint16_t tag;
+    float value;
+    // not terminated if it is full.
+    char name[20];
+};
+
+// the events saved of a thread.
+struct FlightThreadEvents
+{
+    uint32_t thread;
+    std::vector<FlightEvent> events;
+};
+
+// ring of the last events of a thread, older ones are overwritten. recording is a few
+// stores without a lock or a call to the kernel, so it can stay on under load. other
+// threads can copy the events meanwhile, the ones overwritten while copying are left out.
+class FlightRecorder
+{
+public:
+    static const size_t c_capacity = 4096;
+
+    // the recorder of the calling thread, kept for the next thread when it exits.
+    static FlightRecorder& get_thread_recorder();
+
+    void begin_document(int detail);
+    void record(FlightEventType type, HtmlTag tag, const char* class_attrib, const char* id_attrib, int detail, double value);
+
+    // the events in the ring, oldest first.
+    void get_events(std::vector<FlightEvent>& events) const;
+
+    uint32_t get_thread_index() const
+    {
+        return this->m_thread_index;
+    }
+
+    // writes the events of every recorder to file, false if writing failed.
+    static bool save_all(FILE* file);
+    // reads what save_all wrote, false if it is not a flight recorder file.
+    static bool load(FILE* file, std::vector<FlightThreadEvents>& threads);
+    // a line of text for event, without the end of line.
+    static void format_event(const FlightEvent& event, std::string& text);
+    static const char* get_event_type_name(FlightEventType type);
+
+private:
+    FlightRecorder(uint32_t thread_index);
+
+    // not copyable.
+    FlightRecorder(const FlightRecorder&);
+    FlightRecorder& operator=(const FlightRecorder&);
+
+    static const size_t c_event_words = sizeof(FlightEvent) / sizeof(uint64_t);
+
+    uint32_t m_thread_index;
+    // only written by the thread of the recorder.
+    uint32_t m_document;
+    // events recorded so far, the next one goes to m_next % c_capacity.
+    uint64_t m_next;
+    // events whose slots were taken, one more than m_next while an event is written.
+    uint64_t m_claimed;
+    // the events as words, which are copied atomically.
+    uint64_t m_words[c_capacity * c_event_words];
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef HTML_ATTRIBUTE
+#error HTML_ATTRIBUTE should be defined first
+#endif
+
+// common attribute names, sorted by name for binary search.
+HTML_ATTRIBUTE(ACCEPT_CHARSET, "accept-charset")
+HTML_ATTRIBUTE(ACTION, "action")
+HTML_ATTRIBUTE(ALIGN, "align")
+HTML_ATTRIBUTE(ALT, "alt")
+HTML_ATTRIBUTE(BORDER, "border")
+HTML_ATTRIBUTE(CHARSET, "charset")
+HTML_ATTRIBUTE(CLASS, "class")
+HTML_ATTRIBUTE(COLSPAN, "colspan")
+HTML_ATTRIBUTE(CONTENT, "content")
+HTML_ATTRIBUTE(DATA, "data")
+HTML_ATTRIBUTE(DIR, "dir")
+HTML_ATTRIBUTE(FOR, "for")
+HTML_ATTRIBUTE(HEIGHT, "height")
+HTML_ATTRIBUTE(HREF, "href")
+HTML_ATTRIBUTE(HTTP_EQUIV, "http-equiv")
+HTML_ATTRIBUTE(ID, "id")
+HTML_ATTRIBUTE(LANG, "lang")
+HTML_ATTRIBUTE(MEDIA, "media")
+HTML_ATTRIBUTE(METHOD, "method")
+HTML_ATTRIBUTE(NAME, "name")
+HTML_ATTRIBUTE(ONCLICK, "onclick")
+HTML_ATTRIBUTE(PROPERTY, "property")
+HTML_ATTRIBUTE(REL, "rel")
+HTML_ATTRIBUTE(ROWSPAN, "rowspan")
+HTML_ATTRIBUTE(SRC, "src")
+HTML_ATTRIBUTE(STYLE, "style")
+HTML_ATTRIBUTE(TABINDEX, "tabindex")
+HTML_ATTRIBUTE(TARGET, "target")
+HTML_ATTRIBUTE(TITLE, "title")
+HTML_ATTRIBUTE(TYPE, "type")
+HTML_ATTRIBUTE(VALUE, "value")
+HTML_ATTRIBUTE(WIDTH, "width")
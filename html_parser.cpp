@@ -0,0 +1,1007 @@
+#include "html_parser.h"
+
+#include <assert.h>
+#include <cstring>
+#include <strings.h>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+
+#include "charset.h"
+#include "dom_tree.h"
+#include "flat_dom.h"
+#include "utils.h"
+
+using namespace std;
+
+// content of these tags is not parsed as html.
+static const HtmlTag _raw_text_tags[] = {TAG_SCRIPT, TAG_STYLE};
+// content of these tags is not parsed as html, but entities are decoded.
+static const HtmlTag _rcdata_tags[] = {TAG_TEXTAREA, TAG_TITLE};
+// tags never have children.
+static const HtmlTag _void_tags[] = {TAG_AREA, TAG_BASE, TAG_BASEFONT, TAG_BGSOUND, TAG_BR, TAG_COL, TAG_EMBED, TAG_FRAME, TAG_HR, TAG_IMG, TAG_INPUT, TAG_KEYGEN, TAG_LINK, TAG_META, TAG_PARAM, TAG_SOURCE, TAG_TRACK, TAG_WBR};
+// tags allowed in head, any other tag closes head.
+static const HtmlTag _head_tags[] = {TAG_BASE, TAG_LINK, TAG_META, TAG_NOSCRIPT, TAG_OBJECT, TAG_SCRIPT, TAG_STYLE, TAG_TITLE};
+// block tags close an open p.
+static const HtmlTag _p_closing_tags[] = {TAG_ADDRESS, TAG_ARTICLE, TAG_ASIDE, TAG_BLOCKQUOTE, TAG_DD, TAG_DIV, TAG_DL, TAG_DT, TAG_FIELDSET, TAG_FOOTER, TAG_FORM, TAG_H1, TAG_H2, TAG_H3, TAG_H4, TAG_H5, TAG_H6, TAG_HEADER, TAG_HR, TAG_LI, TAG_MENU, TAG_NAV, TAG_OL, TAG_P, TAG_PRE, TAG_SECTION, TAG_TABLE, TAG_UL};
+
+static const HtmlTagSet c_raw_text_tags(_raw_text_tags, sizeof(_raw_text_tags) / sizeof(_raw_text_tags[0]));
+static const HtmlTagSet c_rcdata_tags(_rcdata_tags, sizeof(_rcdata_tags) / sizeof(_rcdata_tags[0]));
+static const HtmlTagSet c_void_tags(_void_tags, sizeof(_void_tags) / sizeof(_void_tags[0]));
+static const HtmlTagSet c_head_tags(_head_tags, sizeof(_head_tags) / sizeof(_head_tags[0]));
+static const HtmlTagSet c_p_closing_tags(_p_closing_tags, sizeof(_p_closing_tags) / sizeof(_p_closing_tags[0]));
+
+// named entities, sorted by name for binary search.
+struct NamedEntity
+{
+    const char* name;
+    const char* value;
+};
+
+static const NamedEntity c_named_entities[] =
+{
+    {"amp", "&"},
+    {"apos", "'"},
+    {"bull", "\xe2\x80\xa2"},
+    {"cent", "\xc2\xa2"},
+    {"copy", "\xc2\xa9"},
+    {"deg", "\xc2\xb0"},
+    {"divide", "\xc3\xb7"},
+    {"euro", "\xe2\x82\xac"},
+    {"gt", ">"},
+    {"hellip", "\xe2\x80\xa6"},
+    {"laquo", "\xc2\xab"},
+    {"ldquo", "\xe2\x80\x9c"},
+    {"lsquo", "\xe2\x80\x98"},
+    {"lt", "<"},
+    {"mdash", "\xe2\x80\x94"},
+    {"middot", "\xc2\xb7"},
+    {"nbsp", "\xc2\xa0"},
+    {"ndash", "\xe2\x80\x93"},
+    {"para", "\xc2\xb6"},
+    {"plusmn", "\xc2\xb1"},
+    {"pound", "\xc2\xa3"},
+    {"quot", "\""},
+    {"raquo", "\xc2\xbb"},
+    {"rdquo", "\xe2\x80\x9d"},
+    {"reg", "\xc2\xae"},
+    {"rsquo", "\xe2\x80\x99"},
+    {"sect", "\xc2\xa7"},
+    {"times", "\xc3\x97"},
+    {"trade", "\xe2\x84\xa2"},
+    {"yen", "\xc2\xa5"},
+};
+
+static const char* find_named_entity(const char* name, size_t length)
+{
+    int low = 0;
+    int high = static_cast<int>(sizeof(c_named_entities) / sizeof(c_named_entities[0])) - 1;
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        const char* entity = c_named_entities[middle].name;
+        int result = strncmp(entity, name, length);
+        if (result == 0 && entity[length] != '\0')
+        {
+            result = 1;
+        }
+
+        if (result == 0)
+        {
+            return c_named_entities[middle].value;
+        }
+        else if (result < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return NULL;
+}
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static inline bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline bool is_alnum(char c)
+{
+    return is_alpha(c) || (c >= '0' && c <= '9');
+}
+
+static inline char to_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// write code_point as utf-8 into output, returns the length.
+static size_t encode_utf8(unsigned long code_point, char* output)
+{
+    if (code_point == 0 || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+    {
+        code_point = 0xFFFD;
+    }
+
+    if (code_point < 0x80)
+    {
+        output[0] = static_cast<char>(code_point);
+        return 1;
+    }
+    else if (code_point < 0x800)
+    {
+        output[0] = static_cast<char>(0xC0 | (code_point >> 6));
+        output[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    else if (code_point < 0x10000)
+    {
+        output[0] = static_cast<char>(0xE0 | (code_point >> 12));
+        output[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        output[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    else
+    {
+        output[0] = static_cast<char>(0xF0 | (code_point >> 18));
+        output[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        output[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        output[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 4;
+    }
+}
+
+// decode the entity starting at p ('&') into output, which has room for 4 chars.
+// returns the position after the entity, or p + 1 with a single '&' if it is not a valid entity.
+// the decoded value is never longer than the entity, so it can be written in place.
+static const char* decode_entity(const char* p, const char* end, char* output, size_t& output_length)
+{
+    assert(*p == '&');
+    const char* q = p + 1;
+    if (q < end && *q == '#')
+    {
+        ++q;
+        bool hex = q < end && (*q == 'x' || *q == 'X');
+        if (hex)
+        {
+            ++q;
+        }
+
+        const char* digits = q;
+        unsigned long code_point = 0;
+        while (q < end)
+        {
+            char c = *q;
+            unsigned long digit;
+            if (c >= '0' && c <= '9')
+            {
+                digit = static_cast<unsigned long>(c - '0');
+            }
+            else if (hex && to_lower(c) >= 'a' && to_lower(c) <= 'f')
+            {
+                digit = static_cast<unsigned long>(to_lower(c) - 'a' + 10);
+            }
+            else
+            {
+                break;
+            }
+
+            if (code_point <= 0x10FFFF)
+            {
+                code_point = code_point * (hex ? 16 : 10) + digit;
+            }
+
+            ++q;
+        }
+
+        if (q == digits)
+        {
+            output[0] = '&';
+            output_length = 1;
+            return p + 1;
+        }
+
+        output_length = encode_utf8(code_point, output);
+        return (q < end && *q == ';') ? q + 1 : q;
+    }
+
+    const char* name = q;
+    while (q < end && is_alnum(*q) && q - name < 8)
+    {
+        ++q;
+    }
+
+    const char* value = find_named_entity(name, static_cast<size_t>(q - name));
+    if (value == NULL)
+    {
+        output[0] = '&';
+        output_length = 1;
+        return p + 1;
+    }
+
+    output_length = strlen(value);
+    memcpy(output, value, output_length);
+    return (q < end && *q == ';') ? q + 1 : q;
+}
+
+void HtmlTokenizer::tokenize(char* html, size_t length)
+{
+    assert(html != NULL);
+    this->m_begin = html;
+    this->m_end = html + length;
+    *this->m_end = '\0';
+    this->m_index.build(html, length, this->m_isa);
+
+    char* p = this->m_begin;
+    while (p < this->m_end)
+    {
+        if (*p == '<')
+        {
+            p = this->parse_markup(p);
+        }
+        else
+        {
+            p = this->parse_text(p);
+        }
+    }
+}
+
+// decode entities in [amp, end) in place, amp points to the first '&'.
+// returns the new end of the decoded chars.
+char* HtmlTokenizer::decode_in_place(char* amp, char* end) const
+{
+    char* output = amp;
+    const char* p = amp;
+    while (p < end)
+    {
+        if (*p == '&')
+        {
+            char decoded[4];
+            size_t length;
+            const char* next = decode_entity(p, end, decoded, length);
+            assert(output + length <= next);
+            memcpy(output, decoded, length);
+            output += length;
+            p = next;
+        }
+        else
+        {
+            // move the run up to the next entity at once.
+            const char* next = this->find_text_stop(p, end, '&');
+            size_t length = static_cast<size_t>(next - p);
+            memmove(output, p, length);
+            output += length;
+            p = next;
+        }
+    }
+
+    return output;
+}
+
+// emit [begin, end) as a text token, end is overwritten by NUL.
+void HtmlTokenizer::emit_text(char* begin, char* end, bool decode)
+{
+    if (begin == end)
+    {
+        return;
+    }
+
+    char* amp = decode ? this->find_text_stop(begin, end, '&') : end;
+    if (amp != end)
+    {
+        end = this->decode_in_place(amp, end);
+    }
+
+    *end = '\0';
+    this->m_handler.on_text(StringPiece(begin, static_cast<size_t>(end - begin)));
+}
+
+// the '<' ending the text is overwritten by NUL, so the markup is parsed right here.
+char* HtmlTokenizer::parse_text(char* p)
+{
+    char* lt = this->find_text_stop(p, this->m_end, '<');
+    this->emit_text(p, lt, true);
+    return lt < this->m_end ? this->parse_markup(lt) : lt;
+}
+
+// p points to '<', which may have been overwritten already.
+char* HtmlTokenizer::parse_markup(char* p)
+{
+    char* q = p + 1;
+    if (q >= this->m_end)
+    {
+        this->m_handler.on_text(StringPiece("<", 1));
+        return q;
+    }
+
+    if (*q == '!')
+    {
+        if (q + 2 < this->m_end && q[1] == '-' && q[2] == '-')
+        {
+            return this->skip_comment(q + 3);
+        }
+
+        // doctype, cdata and other declarations.
+        return this->skip_tag(q);
+    }
+    else if (*q == '?')
+    {
+        return this->skip_tag(q);
+    }
+    else if (*q == '/')
+    {
+        if (q + 1 < this->m_end && is_alpha(q[1]))
+        {
+            return this->parse_end_tag(q + 1);
+        }
+
+        // "</>" or "</ ..." is dropped as a bogus comment.
+        return this->skip_tag(q);
+    }
+    else if (is_alpha(*q))
+    {
+        return this->parse_start_tag(q);
+    }
+    else
+    {
+        // a single '<' in text.
+        this->m_handler.on_text(StringPiece("<", 1));
+        return q;
+    }
+}
+
+// first text stop c in [p, end), or end if not found.
+char* HtmlTokenizer::find_text_stop(const char* p, char* end, char c) const
+{
+    const HtmlStructuralIndex& index = this->m_index;
+    char* stop = this->m_begin + index.next_text_stop(static_cast<size_t>(p - this->m_begin));
+    while (stop < end && *stop != c)
+    {
+        stop = this->m_begin + index.next_text_stop(static_cast<size_t>(stop + 1 - this->m_begin));
+    }
+
+    return stop < end ? stop : end;
+}
+
+// first position at or after p which ends a name: space, '/', '>' and also '=' for attribute names.
+char* HtmlTokenizer::find_name_end(const char* p, bool attribute) const
+{
+    const HtmlStructuralIndex& index = this->m_index;
+    char* stop = this->m_begin + index.next_tag_stop(static_cast<size_t>(p - this->m_begin));
+    while (stop < this->m_end && !is_space(*stop) && *stop != '/' && *stop != '>' && (!attribute || *stop != '='))
+    {
+        stop = this->m_begin + index.next_tag_stop(static_cast<size_t>(stop + 1 - this->m_begin));
+    }
+
+    return stop;
+}
+
+// first position at or after p where *p == c, c should be a tag stop.
+char* HtmlTokenizer::find_tag_stop(const char* p, char c) const
+{
+    const HtmlStructuralIndex& index = this->m_index;
+    char* stop = this->m_begin + index.next_tag_stop(static_cast<size_t>(p - this->m_begin));
+    while (stop < this->m_end && *stop != c)
+    {
+        stop = this->m_begin + index.next_tag_stop(static_cast<size_t>(stop + 1 - this->m_begin));
+    }
+
+    return stop;
+}
+
+// skip to the position after the next '>'.
+char* HtmlTokenizer::skip_tag(char* p)
+{
+    char* gt = this->find_tag_stop(p, '>');
+    return gt < this->m_end ? gt + 1 : this->m_end;
+}
+
+// p points after "<!--"
+char* HtmlTokenizer::skip_comment(char* p)
+{
+    while (p < this->m_end)
+    {
+        char* dash = static_cast<char*>(memchr(p, '-', static_cast<size_t>(this->m_end - p)));
+        if (dash == NULL || dash + 2 >= this->m_end)
+        {
+            break;
+        }
+
+        if (dash[1] == '-' && dash[2] == '>')
+        {
+            return dash + 3;
+        }
+
+        p = dash + 1;
+    }
+
+    return this->m_end;
+}
+
+// lower case a tag or attribute name in place, the first char always belongs to the name.
+// returns the end of the name.
+char* HtmlTokenizer::parse_name(char* p, bool attribute) const
+{
+    char* end = this->find_name_end(p + 1, attribute);
+    for (char* c = p; c < end; ++c)
+    {
+        *c = to_lower(*c);
+    }
+
+    return end;
+}
+
+// p points to the first letter of the tag name.
+// names and values are NUL terminated once the whole tag is read,
+// the chars overwritten by NUL are spaces, quotes and other delimiters already passed.
+char* HtmlTokenizer::parse_start_tag(char* p)
+{
+    char* name_end = this->parse_name(p, false);
+    StringPiece name(p, static_cast<size_t>(name_end - p));
+    p = name_end;
+
+    this->m_attributes.clear();
+    bool self_closing = false;
+    while (p < this->m_end)
+    {
+        char c = *p;
+        if (is_space(c))
+        {
+            ++p;
+        }
+        else if (c == '>')
+        {
+            ++p;
+            break;
+        }
+        else if (c == '/')
+        {
+            ++p;
+            if (p < this->m_end && *p == '>')
+            {
+                self_closing = true;
+                ++p;
+                break;
+            }
+        }
+        else
+        {
+            p = this->parse_attribute(p);
+        }
+    }
+
+    *name_end = '\0';
+    for (HtmlAttributes::iterator iter = this->m_attributes.begin(); iter != this->m_attributes.end(); ++iter)
+    {
+        const_cast<char*>(iter->first.data())[iter->first.size()] = '\0';
+        if (!iter->second.empty())
+        {
+            const_cast<char*>(iter->second.data())[iter->second.size()] = '\0';
+        }
+    }
+
+    this->m_handler.on_start_tag(name, this->m_attributes, self_closing);
+
+    if (!self_closing)
+    {
+        HtmlTag tag = lookup_html_tag(name.data(), name.size());
+        if (c_raw_text_tags.contains(tag))
+        {
+            return this->parse_raw_text(p, name, false);
+        }
+        else if (c_rcdata_tags.contains(tag))
+        {
+            return this->parse_raw_text(p, name, true);
+        }
+    }
+
+    return p;
+}
+
+// p points to the first char of the attribute name.
+char* HtmlTokenizer::parse_attribute(char* p)
+{
+    char* name_end = this->parse_name(p, true);
+    StringPiece name(p, static_cast<size_t>(name_end - p));
+    p = name_end;
+
+    char* q = p;
+    while (q < this->m_end && is_space(*q))
+    {
+        ++q;
+    }
+
+    if (q >= this->m_end || *q != '=')
+    {
+        this->m_attributes.push_back(make_pair(name, StringPiece("", 0)));
+        return p;
+    }
+
+    ++q;
+    while (q < this->m_end && is_space(*q))
+    {
+        ++q;
+    }
+
+    char* value_begin;
+    char* value_end;
+    if (q < this->m_end && (*q == '"' || *q == '\''))
+    {
+        value_begin = q + 1;
+        value_end = this->find_tag_stop(value_begin, *q);
+        p = value_end < this->m_end ? value_end + 1 : this->m_end;
+    }
+    else
+    {
+        value_begin = q;
+        const HtmlStructuralIndex& index = this->m_index;
+        while (q < this->m_end && !is_space(*q) && *q != '>')
+        {
+            q = this->m_begin + index.next_tag_stop(static_cast<size_t>(q + 1 - this->m_begin));
+        }
+
+        value_end = q;
+        p = q;
+    }
+
+    char* amp = this->find_text_stop(value_begin, value_end, '&');
+    char* decoded_end = amp != value_end ? this->decode_in_place(amp, value_end) : value_end;
+
+    // empty values are not terminated in the buffer, "" is used instead.
+    StringPiece value = decoded_end != value_begin ? StringPiece(value_begin, static_cast<size_t>(decoded_end - value_begin)) : StringPiece("", 0);
+    this->m_attributes.push_back(make_pair(name, value));
+    return p;
+}
+
+// p points to the first letter of the tag name.
+char* HtmlTokenizer::parse_end_tag(char* p)
+{
+    char* name_end = this->parse_name(p, false);
+    char* next = this->skip_tag(name_end);
+    *name_end = '\0';
+    this->m_handler.on_end_tag(StringPiece(p, static_cast<size_t>(name_end - p)));
+    return next;
+}
+
+// p points after the start tag, content ends at the matching end tag.
+char* HtmlTokenizer::parse_raw_text(char* p, const StringPiece& tag_name, bool decode)
+{
+    char* q = p;
+    const size_t name_length = tag_name.size();
+    while (q < this->m_end)
+    {
+        char* lt = this->find_text_stop(q, this->m_end, '<');
+        if (lt == this->m_end)
+        {
+            break;
+        }
+
+        if (lt + 2 + name_length <= this->m_end && lt[1] == '/' && strncasecmp(lt + 2, tag_name.data(), name_length) == 0)
+        {
+            char* after = lt + 2 + name_length;
+            if (after == this->m_end || is_space(*after) || *after == '>' || *after == '/')
+            {
+                this->emit_text(p, lt, decode);
+                return this->parse_end_tag(lt + 2);
+            }
+        }
+
+        q = lt + 1;
+    }
+
+    this->emit_text(p, this->m_end, decode);
+    return this->m_end;
+}
+
+DomTreeBuilder::~DomTreeBuilder()
+{
+    if (this->m_arena == NULL)
+    {
+        delete this->m_root;
+    }
+}
+
+DomNode* DomTreeBuilder::release()
+{
+    DomNode* root = this->m_root;
+    this->m_root = NULL;
+    this->m_open_nodes.clear();
+    return root;
+}
+
+DomNode* DomTreeBuilder::create_node(const StringPiece& name, const HtmlAttributes& attributes) const
+{
+    DomNode* node;
+    if (this->m_arena != NULL)
+    {
+        node = DomNode::create(*this->m_arena, name.data());
+    }
+    else if (this->m_views)
+    {
+        node = new DomNode(name.data());
+    }
+    else
+    {
+        node = new DomNode(name.as_string(), "");
+    }
+
+    for (HtmlAttributes::const_iterator iter = attributes.begin(); iter != attributes.end(); ++iter)
+    {
+        // the first one wins on duplicated attributes.
+        if (node->has_attribute(iter->first.data()))
+        {
+            continue;
+        }
+
+        if (this->m_views)
+        {
+            node->add_attribute_view(iter->first.data(), iter->second.data());
+        }
+        else
+        {
+            node->add_attribute(iter->first.data(), iter->second.data());
+        }
+    }
+
+    return node;
+}
+
+void DomTreeBuilder::ensure_root()
+{
+    if (this->m_root == NULL)
+    {
+        this->m_root = this->create_node(StringPiece("html", 4), HtmlAttributes());
+        this->m_open_nodes.push_back(this->m_root);
+    }
+}
+
+// pop open nodes which are closed implicitly by the start of tag name.
+void DomTreeBuilder::close_implied(HtmlTag tag)
+{
+    while (this->m_open_nodes.size() > 1)
+    {
+        bool closed = false;
+        switch (this->m_open_nodes.back()->get_tag_atom())
+        {
+        case TAG_P:
+            closed = c_p_closing_tags.contains(tag);
+            break;
+        case TAG_LI:
+            closed = tag == TAG_LI;
+            break;
+        case TAG_DT:
+        case TAG_DD:
+            closed = tag == TAG_DT || tag == TAG_DD;
+            break;
+        case TAG_OPTION:
+            closed = tag == TAG_OPTION || tag == TAG_OPTGROUP;
+            break;
+        case TAG_TD:
+        case TAG_TH:
+            closed = tag == TAG_TD || tag == TAG_TH || tag == TAG_TR || tag == TAG_TBODY || tag == TAG_THEAD || tag == TAG_TFOOT;
+            break;
+        case TAG_TR:
+            closed = tag == TAG_TR || tag == TAG_TBODY || tag == TAG_THEAD || tag == TAG_TFOOT;
+            break;
+        case TAG_THEAD:
+        case TAG_TBODY:
+        case TAG_TFOOT:
+            closed = tag == TAG_TBODY || tag == TAG_THEAD || tag == TAG_TFOOT;
+            break;
+        case TAG_HEAD:
+            closed = !c_head_tags.contains(tag);
+            break;
+        default:
+            break;
+        }
+
+        if (!closed)
+        {
+            break;
+        }
+
+        this->m_open_nodes.pop_back();
+    }
+}
+
+void DomTreeBuilder::on_start_tag(const StringPiece& name, const HtmlAttributes& attributes, bool self_closing)
+{
+    HtmlTag tag = lookup_html_tag(name.data(), name.size());
+    if (tag == TAG_HTML)
+    {
+        if (this->m_root == NULL)
+        {
+            this->m_root = this->create_node(name, attributes);
+            this->m_open_nodes.push_back(this->m_root);
+        }
+
+        return;
+    }
+
+    this->ensure_root();
+    this->close_implied(tag);
+
+    DomNode* node = this->create_node(name, attributes);
+    this->m_open_nodes.back()->append_child(node);
+
+    if (!self_closing && !c_void_tags.contains(tag))
+    {
+        this->m_open_nodes.push_back(node);
+    }
+}
+
+void DomTreeBuilder::on_end_tag(const StringPiece& name)
+{
+    // html and body are kept open, content after them still belongs to the document.
+    HtmlTag tag = lookup_html_tag(name.data(), name.size());
+    if (tag == TAG_HTML || tag == TAG_BODY)
+    {
+        return;
+    }
+
+    // close the nearest open node with the same tag, end tags without open node are ignored.
+    // unknown tags are compared by name.
+    for (size_t i = this->m_open_nodes.size(); i > 1; --i)
+    {
+        const DomNode* node = this->m_open_nodes[i - 1];
+        if (tag != TAG_UNKNOWN ? node->get_tag_atom() == tag : name.equals(node->get_tag()))
+        {
+            this->m_open_nodes.resize(i - 1);
+            break;
+        }
+    }
+}
+
+void DomTreeBuilder::on_text(const StringPiece& text)
+{
+    bool blank = true;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (!is_space(text[i]))
+        {
+            blank = false;
+            break;
+        }
+    }
+
+    if (this->m_open_nodes.empty())
+    {
+        if (blank)
+        {
+            return;
+        }
+
+        this->ensure_root();
+    }
+
+    // like libxml2, blank text directly in html or head is ignored.
+    DomNode* current = this->m_open_nodes.back();
+    if (blank && (current->get_tag_atom() == TAG_HTML || current->get_tag_atom() == TAG_HEAD))
+    {
+        return;
+    }
+
+    if (this->m_views)
+    {
+        current->append_text(text.data(), text.size());
+    }
+    else
+    {
+        current->append_text(text.as_string());
+    }
+}
+
+DomNode* HtmlParser::parse(const char* html, size_t length) const
+{
+    // the tokenizer works in place, parse a copy and copy the tokens into the tree.
+    vector<char> buffer;
+    if (this->m_to_utf8)
+    {
+        buffer.resize(get_max_utf8_length(length) + 1);
+        length = convert_to_utf8(html, length, detect_charset(html, length), &buffer[0]);
+        buffer.resize(length + 1);
+    }
+    else
+    {
+        buffer.assign(html, html + length);
+        buffer.push_back('\0');
+    }
+
+    DomTreeBuilder builder(false);
+    HtmlTokenizer tokenizer(builder, this->m_isa);
+    tokenizer.tokenize(&buffer[0], length);
+    return builder.release();
+}
+
+DomNode* HtmlParser::parse(const string& html) const
+{
+    return this->parse(html.data(), html.size());
+}
+
+DomNode* HtmlParser::parse_in_place(char* html, size_t length) const
+{
+    DomTreeBuilder builder(true);
+    HtmlTokenizer tokenizer(builder, this->m_isa);
+    tokenizer.tokenize(html, length);
+    return builder.release();
+}
+
+DomNode* HtmlParser::parse(const char* html, size_t length, DomArena& arena) const
+{
+    char* buffer;
+    if (this->m_to_utf8)
+    {
+        // the arena is reset between pages, the bytes left over are not kept long.
+        buffer = static_cast<char*>(arena.allocate(get_max_utf8_length(length) + 1));
+        length = convert_to_utf8(html, length, detect_charset(html, length), buffer);
+    }
+    else
+    {
+        buffer = static_cast<char*>(arena.allocate(length + 1));
+        memcpy(buffer, html, length);
+    }
+
+    DomTreeBuilder builder(true, &arena);
+    HtmlTokenizer tokenizer(builder, this->m_isa);
+    tokenizer.tokenize(buffer, length);
+    return builder.release();
+}
+
+bool is_void_tag(const char* tag)
+{
+    return c_void_tags.contains(lookup_html_tag(tag));
+}
+
+static void escape_html(const StringPiece& text, bool attribute, string& html)
+{
+    for (const char* p = text.data(); p < text.data() + text.size(); ++p)
+    {
+        switch (*p)
+        {
+        case '&':
+            html.append("&amp;");
+            break;
+        case '<':
+            html.append("&lt;");
+            break;
+        case '>':
+            html.append("&gt;");
+            break;
+        case '"':
+            if (attribute)
+            {
+                html.append("&quot;");
+                break;
+            }
+            // fall through
+        default:
+            html.push_back(*p);
+        }
+    }
+}
+
+static bool attribute_name_less(const pair<const char*, const char*>& a, const pair<const char*, const char*>& b)
+{
+    return strcmp(a.first, b.first) < 0;
+}
+
+// start tag, attributes and text of node, returns false for a void tag which has no end tag.
+static bool serialize_start_tag(const DomNode* node, string& html)
+{
+    html.push_back('<');
+    html.append(node->get_tag());
+    vector<pair<const char*, const char*> > attributes;
+    node->get_attributes(attributes);
+    // same order for copied and viewed attributes.
+    sort(attributes.begin(), attributes.end(), attribute_name_less);
+    for (vector<pair<const char*, const char*> >::const_iterator iter = attributes.begin(); iter != attributes.end(); ++iter)
+    {
+        // class and id read empty on every node.
+        if (iter->second[0] == '\0' && (strcmp(iter->first, "class") == 0 || strcmp(iter->first, "id") == 0))
+        {
+            continue;
+        }
+
+        html.push_back(' ');
+        html.append(iter->first);
+        html.append("=\"");
+        escape_html(StringPiece(iter->second, strlen(iter->second)), true, html);
+        html.push_back('"');
+    }
+
+    html.push_back('>');
+    if (is_void_tag(node->get_tag()))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < node->get_text_piece_count(); ++i)
+    {
+        escape_html(node->get_text_piece(i), false, html);
+    }
+
+    return true;
+}
+
+void serialize_html(const DomNode* node, string& html)
+{
+    assert(node != NULL);
+
+    // explicit stack of (node, end tag pending), deep trees would overflow a recursion.
+    vector<pair<const DomNode*, bool> > nodes(1, make_pair(node, false));
+    while (!nodes.empty())
+    {
+        const DomNode* current = nodes.back().first;
+        bool closing = nodes.back().second;
+        nodes.pop_back();
+        if (closing)
+        {
+            html.append("</");
+            html.append(current->get_tag());
+            html.push_back('>');
+            continue;
+        }
+
+        if (!serialize_start_tag(current, html))
+        {
+            continue;
+        }
+
+        nodes.push_back(make_pair(current, true));
+        const DomNodeList* children = current->get_children();
+        for (size_t i = children->size(); i > 0; --i)
+        {
+            nodes.push_back(make_pair(static_cast<const DomNode*>((*children)[i - 1]), false));
+        }
+    }
+}
+
+void serialize_html(const FlatDom& dom, int32_t node, const FlatDomMask& kept, string& html)
+{
+    assert(node >= 0 && node < dom.size());
+    assert(kept.size() == dom.size());
+
+    // the subtree is a range in document order, elements are closed once the range of
+    // their subtree is passed.
+    vector<int32_t> open_nodes;
+    int32_t end = dom.get_subtree_end(node);
+    for (int32_t i = node; i < end; )
+    {
+        while (!open_nodes.empty() && dom.get_subtree_end(open_nodes.back()) <= i)
+        {
+            html.append("</");
+            html.append(dom.get_node(open_nodes.back())->get_tag());
+            html.push_back('>');
+            open_nodes.pop_back();
+        }
+
+        if (!kept.contains(i))
+        {
+            i = dom.get_subtree_end(i);
+            continue;
+        }
+
+        if (serialize_start_tag(dom.get_node(i), html))
+        {
+            open_nodes.push_back(i);
+        }
+
+        ++i;
+    }
+
+    while (!open_nodes.empty())
+    {
+        html.append("</");
+        html.append(dom.get_node(open_nodes.back())->get_tag());
+        html.push_back('>');
+        open_nodes.pop_back();
+    }
+}
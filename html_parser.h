@@ -0,0 +1,157 @@
+#ifndef _HTML_PARSER_H_
+#define _HTML_PARSER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "html_scanner.h"
+#include "html_tags.h"
+#include "string_piece.h"
+
+class DomNode;
+class DomArena;
+class FlatDom;
+class FlatDomMask;
+
+typedef std::vector<std::pair<StringPiece, StringPiece> > HtmlAttributes;
+
+// receives tokens from HtmlTokenizer in document order.
+class HtmlTokenHandler
+{
+public:
+    // tokens point into the html buffer and are NUL terminated, they stay valid as long as the buffer.
+    // tag and attribute names are lower case, attribute values are entity decoded.
+    virtual void on_start_tag(const StringPiece& name, const HtmlAttributes& attributes, bool self_closing) = 0;
+
+    virtual void on_end_tag(const StringPiece& name) = 0;
+
+    // text is entity decoded, except for the content of script and style.
+    virtual void on_text(const StringPiece& text) = 0;
+
+    virtual ~HtmlTokenHandler()
+    {
+    }
+};
+
+// splits a raw html buffer into start tag, end tag and text tokens in one pass,
+// tokens are pushed into the handler as soon as they are complete.
+// comments, doctype and processing instructions are skipped.
+// the buffer is indexed by HtmlStructuralIndex first, the tokenizer jumps
+// between structural chars instead of testing every byte.
+// tokens are cut from the buffer in place: names are lower cased, entities are decoded
+// and token ends are overwritten by NUL, so no token is copied.
+class HtmlTokenizer
+{
+public:
+    HtmlTokenizer(HtmlTokenHandler& handler, int isa = SI_AUTO) :
+        m_handler(handler), m_isa(isa), m_begin(NULL), m_end(NULL)
+    {
+    }
+
+    // html is modified, html[length] is written and should be allocated.
+    void tokenize(char* html, size_t length);
+
+private:
+    char* parse_text(char* p);
+    char* parse_markup(char* p);
+    char* parse_start_tag(char* p);
+    char* parse_end_tag(char* p);
+    char* parse_attribute(char* p);
+    char* parse_name(char* p, bool attribute) const;
+    char* skip_comment(char* p);
+    char* skip_tag(char* p);
+    char* find_text_stop(const char* p, char* end, char c) const;
+    char* find_tag_stop(const char* p, char c) const;
+    char* find_name_end(const char* p, bool attribute) const;
+    char* parse_raw_text(char* p, const StringPiece& tag_name, bool decode);
+    char* decode_in_place(char* amp, char* end) const;
+    void emit_text(char* begin, char* end, bool decode);
+
+    HtmlTokenHandler& m_handler;
+    int m_isa;
+    HtmlStructuralIndex m_index;
+    char* m_begin;
+    char* m_end;
+
+    // reused between tags to avoid allocations.
+    HtmlAttributes m_attributes;
+};
+
+// builds DomNode tree from tokens, with the same conventions as the old lxml bridge:
+// the text of an element and the tails of its children are merged into the element's text,
+// and every element carries class and id attributes (empty when absent in html).
+// with views, nodes point to the tokens instead of copying them, see DomNode.
+// with an arena, nodes are views created in the arena.
+class DomTreeBuilder : public HtmlTokenHandler
+{
+public:
+    DomTreeBuilder(bool views = false, DomArena* arena = NULL) :
+        m_views(views || arena != NULL), m_arena(arena), m_root(NULL)
+    {
+    }
+
+    // deletes the tree if it has not been released and is not in an arena.
+    virtual ~DomTreeBuilder();
+
+    virtual void on_start_tag(const StringPiece& name, const HtmlAttributes& attributes, bool self_closing);
+    virtual void on_end_tag(const StringPiece& name);
+    virtual void on_text(const StringPiece& text);
+
+    // returns the root node and gives up the ownership, the caller should delete it.
+    DomNode* release();
+
+private:
+    DomNode* create_node(const StringPiece& name, const HtmlAttributes& attributes) const;
+    void ensure_root();
+    void close_implied(HtmlTag tag);
+
+    bool m_views;
+    DomArena* m_arena;
+    DomNode* m_root;
+    std::vector<DomNode*> m_open_nodes;
+};
+
+class HtmlParser
+{
+public:
+    // isa is the instruction set of the structural scanner, SI_AUTO picks the best one.
+    // with to_utf8, html is converted to utf-8 from the charset detect_charset finds while
+    // it is copied, so the tree is in utf-8 whatever the charset of the page.
+    HtmlParser(int isa = SI_AUTO, bool to_utf8 = false) :
+        m_isa(isa), m_to_utf8(to_utf8)
+    {
+    }
+
+    // parse raw html into a dom tree. the caller owns the returned root node
+    // and should delete it, returns NULL if the html contains no element.
+    DomNode* parse(const char* html, size_t length) const;
+
+    DomNode* parse(const std::string& html) const;
+
+    // parse without copying: tags, attributes and text of the returned tree point into html,
+    // which is modified and should outlive the tree. html[length] is written, so the buffer
+    // should hold at least length + 1 chars. html is never converted to utf-8.
+    DomNode* parse_in_place(char* html, size_t length) const;
+
+    // parse a copy of html in the arena, the nodes are created in the arena as well.
+    // the tree is only freed by arena.reset() and should not be deleted.
+    DomNode* parse(const char* html, size_t length, DomArena& arena) const;
+
+private:
+    int m_isa;
+    bool m_to_utf8;
+};
+
+// is tag a void element, which never has children or end tag.
+bool is_void_tag(const char* tag);
+
+// write dom tree back into html. text of a node is written before its children,
+// since tails are merged into the parent's text while building.
+void serialize_html(const DomNode* node, std::string& html);
+// the same for the subtree of node in a flat tree, without the nodes which are not in kept.
+void serialize_html(const FlatDom& dom, int32_t node, const FlatDomMask& kept, std::string& html);
+
+#endif
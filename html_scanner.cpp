@@ -0,0 +1,239 @@
+#include "html_scanner.h"
+
+#include <assert.h>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HTML_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// scans one block of 64 bytes, sets the bits of text and tag stops.
+typedef void (*BlockScanner)(const unsigned char* block, uint64_t& text_stops, uint64_t& tag_stops);
+
+enum CharClass
+{
+    CC_TEXT_STOP = 1,
+    CC_TAG_STOP = 2,
+};
+
+static unsigned char s_char_classes[256];
+
+static bool init_char_classes()
+{
+    for (int c = 0; c <= 0x20; ++c)
+    {
+        s_char_classes[c] = CC_TAG_STOP;
+    }
+
+    const char* tag_stops = "<>/=\"'&";
+    for (const char* p = tag_stops; *p != '\0'; ++p)
+    {
+        s_char_classes[static_cast<unsigned char>(*p)] = CC_TAG_STOP;
+    }
+
+    s_char_classes[static_cast<unsigned char>('<')] |= CC_TEXT_STOP;
+    s_char_classes[static_cast<unsigned char>('&')] |= CC_TEXT_STOP;
+    return true;
+}
+
+static const bool s_char_classes_initialized = init_char_classes();
+
+static void scan_block_scalar(const unsigned char* block, uint64_t& text_stops, uint64_t& tag_stops)
+{
+    uint64_t text = 0;
+    uint64_t tag = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        unsigned char char_class = s_char_classes[block[i]];
+        text |= static_cast<uint64_t>(char_class & CC_TEXT_STOP) << i;
+        tag |= static_cast<uint64_t>((char_class & CC_TAG_STOP) >> 1) << i;
+    }
+
+    text_stops = text;
+    tag_stops = tag;
+}
+
+#ifdef HTML_SCANNER_X86
+
+__attribute__((target("sse2")))
+static void scan_block_sse2(const unsigned char* block, uint64_t& text_stops, uint64_t& tag_stops)
+{
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i equal = _mm_set1_epi8('=');
+    const __m128i double_quote = _mm_set1_epi8('"');
+    const __m128i single_quote = _mm_set1_epi8('\'');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    uint64_t text = 0;
+    uint64_t tag = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        __m128i text_mask = _mm_or_si128(_mm_cmpeq_epi8(chars, lt), _mm_cmpeq_epi8(chars, amp));
+        // unsigned chars <= 0x20: max(c, 0x20) == 0x20
+        __m128i tag_mask = _mm_cmpeq_epi8(_mm_max_epu8(chars, space), space);
+        tag_mask = _mm_or_si128(tag_mask, text_mask);
+        tag_mask = _mm_or_si128(tag_mask, _mm_cmpeq_epi8(chars, gt));
+        tag_mask = _mm_or_si128(tag_mask, _mm_cmpeq_epi8(chars, slash));
+        tag_mask = _mm_or_si128(tag_mask, _mm_cmpeq_epi8(chars, equal));
+        tag_mask = _mm_or_si128(tag_mask, _mm_cmpeq_epi8(chars, double_quote));
+        tag_mask = _mm_or_si128(tag_mask, _mm_cmpeq_epi8(chars, single_quote));
+
+        text |= static_cast<uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(text_mask))) << (i * 16);
+        tag |= static_cast<uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(tag_mask))) << (i * 16);
+    }
+
+    text_stops = text;
+    tag_stops = tag;
+}
+
+__attribute__((target("avx2")))
+static void scan_block_avx2(const unsigned char* block, uint64_t& text_stops, uint64_t& tag_stops)
+{
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i equal = _mm256_set1_epi8('=');
+    const __m256i double_quote = _mm256_set1_epi8('"');
+    const __m256i single_quote = _mm256_set1_epi8('\'');
+    const __m256i space = _mm256_set1_epi8(0x20);
+
+    uint64_t text = 0;
+    uint64_t tag = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i * 32));
+        __m256i text_mask = _mm256_or_si256(_mm256_cmpeq_epi8(chars, lt), _mm256_cmpeq_epi8(chars, amp));
+        __m256i tag_mask = _mm256_cmpeq_epi8(_mm256_max_epu8(chars, space), space);
+        tag_mask = _mm256_or_si256(tag_mask, text_mask);
+        tag_mask = _mm256_or_si256(tag_mask, _mm256_cmpeq_epi8(chars, gt));
+        tag_mask = _mm256_or_si256(tag_mask, _mm256_cmpeq_epi8(chars, slash));
+        tag_mask = _mm256_or_si256(tag_mask, _mm256_cmpeq_epi8(chars, equal));
+        tag_mask = _mm256_or_si256(tag_mask, _mm256_cmpeq_epi8(chars, double_quote));
+        tag_mask = _mm256_or_si256(tag_mask, _mm256_cmpeq_epi8(chars, single_quote));
+
+        text |= static_cast<uint64_t>(static_cast<unsigned int>(_mm256_movemask_epi8(text_mask))) << (i * 32);
+        tag |= static_cast<uint64_t>(static_cast<unsigned int>(_mm256_movemask_epi8(tag_mask))) << (i * 32);
+    }
+
+    text_stops = text;
+    tag_stops = tag;
+}
+
+#endif
+
+static BlockScanner get_block_scanner(int isa)
+{
+    switch (isa)
+    {
+#ifdef HTML_SCANNER_X86
+    case SI_SSE2:
+        return scan_block_sse2;
+    case SI_AVX2:
+        return scan_block_avx2;
+#endif
+    default:
+        return scan_block_scalar;
+    }
+}
+
+bool HtmlStructuralIndex::isa_supported(int isa)
+{
+#ifdef HTML_SCANNER_X86
+    // may be called before the constructors which initialize cpu features.
+    __builtin_cpu_init();
+#endif
+
+    switch (isa)
+    {
+    case SI_SCALAR:
+        return true;
+#ifdef HTML_SCANNER_X86
+    case SI_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SI_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+static int detect_best_isa()
+{
+    int best = SI_SCALAR;
+    for (int isa = SI_SCALAR; isa < SI_TOTAL_ISA_COUNT; ++isa)
+    {
+        if (HtmlStructuralIndex::isa_supported(isa))
+        {
+            best = isa;
+        }
+    }
+
+    return best;
+}
+
+int HtmlStructuralIndex::best_isa()
+{
+    // cpu features don't change, detect once. the initialization of a local static
+    // is guarded, so threads may race on the first call.
+    static const int s_best_isa = detect_best_isa();
+    return s_best_isa;
+}
+
+const char* HtmlStructuralIndex::isa_name(int isa)
+{
+    static const char* c_isa_names[] = {"scalar", "sse2", "avx2"};
+    if (isa == SI_AUTO)
+    {
+        isa = HtmlStructuralIndex::best_isa();
+    }
+
+    assert(isa >= 0 && isa < SI_TOTAL_ISA_COUNT);
+    return c_isa_names[isa];
+}
+
+void HtmlStructuralIndex::build(const char* data, size_t length, int isa)
+{
+    assert(data != NULL || length == 0);
+    if (isa == SI_AUTO)
+    {
+        isa = HtmlStructuralIndex::best_isa();
+    }
+
+    assert(HtmlStructuralIndex::isa_supported(isa));
+    BlockScanner scan_block = get_block_scanner(isa);
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const size_t block_count = (length + 63) / 64;
+    this->m_length = length;
+    this->m_text_stops.resize(block_count);
+    this->m_tag_stops.resize(block_count);
+
+    size_t full_blocks = length / 64;
+    for (size_t i = 0; i < full_blocks; ++i)
+    {
+        scan_block(bytes + i * 64, this->m_text_stops[i], this->m_tag_stops[i]);
+    }
+
+    // the last partial block is scanned from a padded copy, bits beyond length are cleared.
+    size_t rest = length - full_blocks * 64;
+    if (rest > 0)
+    {
+        unsigned char block[64];
+        memset(block, 'a', sizeof(block));
+        memcpy(block, bytes + full_blocks * 64, rest);
+        scan_block(block, this->m_text_stops[full_blocks], this->m_tag_stops[full_blocks]);
+
+        uint64_t mask = (static_cast<uint64_t>(1) << rest) - 1;
+        this->m_text_stops[full_blocks] &= mask;
+        this->m_tag_stops[full_blocks] &= mask;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef _HTML_SCANNER_H_
+#define _HTML_SCANNER_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+// instruction sets of the structural scanner.
+enum ScannerIsa
+{
+    SI_AUTO = -1,
+    SI_SCALAR = 0,
+    SI_SSE2,
+    SI_AVX2,
+    SI_TOTAL_ISA_COUNT,
+};
+
+// positions of the structural chars of a html buffer, one bit per byte.
+// text stops are '<' and '&', where text tokens end or need decoding.
+// tag stops are '<', '>', '/', '=', '"', '\'', '&' and every byte <= 0x20,
+// so a tag stop is not always a space, callers should check the char.
+class HtmlStructuralIndex
+{
+public:
+    HtmlStructuralIndex() :
+        m_length(0)
+    {
+    }
+
+    // index the buffer with the best instruction set of the running cpu.
+    void build(const char* data, size_t length)
+    {
+        this->build(data, length, SI_AUTO);
+    }
+
+    void build(const char* data, size_t length, int isa);
+
+    size_t length() const
+    {
+        return this->m_length;
+    }
+
+    // position of the first text stop at or after pos, length() if not found.
+    size_t next_text_stop(size_t pos) const
+    {
+        return this->next(this->m_text_stops, pos);
+    }
+
+    // position of the first tag stop at or after pos, length() if not found.
+    size_t next_tag_stop(size_t pos) const
+    {
+        return this->next(this->m_tag_stops, pos);
+    }
+
+    const std::vector<uint64_t>& get_text_stops() const
+    {
+        return this->m_text_stops;
+    }
+
+    const std::vector<uint64_t>& get_tag_stops() const
+    {
+        return this->m_tag_stops;
+    }
+
+    static bool isa_supported(int isa);
+    static int best_isa();
+    static const char* isa_name(int isa);
+
+private:
+    size_t next(const std::vector<uint64_t>& bits, size_t pos) const
+    {
+        size_t word = pos >> 6;
+        if (word >= bits.size())
+        {
+            return this->m_length;
+        }
+
+        uint64_t current = bits[word] & (~static_cast<uint64_t>(0) << (pos & 63));
+        while (current == 0)
+        {
+            ++word;
+            if (word == bits.size())
+            {
+                return this->m_length;
+            }
+
+            current = bits[word];
+        }
+
+        return (word << 6) + static_cast<size_t>(__builtin_ctzll(current));
+    }
+
+    size_t m_length;
+    std::vector<uint64_t> m_text_stops;
+    std::vector<uint64_t> m_tag_stops;
+};
+
+#endif
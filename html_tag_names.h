@@ -0,0 +1,135 @@
+#ifndef HTML_TAG
+#error HTML_TAG should be defined first
+#endif
+
+// known html tags in atom order, html_tag_tables.h is generated from this list by
+// make html_tag_tables.h.
+HTML_TAG(A, "a")
+HTML_TAG(ABBR, "abbr")
+HTML_TAG(ACRONYM, "acronym")
+HTML_TAG(ADDRESS, "address")
+HTML_TAG(APPLET, "applet")
+HTML_TAG(AREA, "area")
+HTML_TAG(ARTICLE, "article")
+HTML_TAG(ASIDE, "aside")
+HTML_TAG(AUDIO, "audio")
+HTML_TAG(B, "b")
+HTML_TAG(BASE, "base")
+HTML_TAG(BASEFONT, "basefont")
+HTML_TAG(BDI, "bdi")
+HTML_TAG(BDO, "bdo")
+HTML_TAG(BIG, "big")
+HTML_TAG(BLINK, "blink")
+HTML_TAG(BLOCKQUOTE, "blockquote")
+HTML_TAG(BGSOUND, "bgsound")
+HTML_TAG(BODY, "body")
+HTML_TAG(BR, "br")
+HTML_TAG(BUTTON, "button")
+HTML_TAG(CANVAS, "canvas")
+HTML_TAG(CAPTION, "caption")
+HTML_TAG(CENTER, "center")
+HTML_TAG(CITE, "cite")
+HTML_TAG(CODE, "code")
+HTML_TAG(COL, "col")
+HTML_TAG(COLGROUP, "colgroup")
+HTML_TAG(DATA, "data")
+HTML_TAG(DATALIST, "datalist")
+HTML_TAG(DD, "dd")
+HTML_TAG(DEL, "del")
+HTML_TAG(DETAILS, "details")
+HTML_TAG(DFN, "dfn")
+HTML_TAG(DIALOG, "dialog")
+HTML_TAG(DIR, "dir")
+HTML_TAG(DIV, "div")
+HTML_TAG(DL, "dl")
+HTML_TAG(DT, "dt")
+HTML_TAG(EM, "em")
+HTML_TAG(EMBED, "embed")
+HTML_TAG(FIELDSET, "fieldset")
+HTML_TAG(FIGCAPTION, "figcaption")
+HTML_TAG(FIGURE, "figure")
+HTML_TAG(FONT, "font")
+HTML_TAG(FOOTER, "footer")
+HTML_TAG(FORM, "form")
+HTML_TAG(FRAME, "frame")
+HTML_TAG(FRAMESET, "frameset")
+HTML_TAG(H1, "h1")
+HTML_TAG(H2, "h2")
+HTML_TAG(H3, "h3")
+HTML_TAG(H4, "h4")
+HTML_TAG(H5, "h5")
+HTML_TAG(H6, "h6")
+HTML_TAG(HEAD, "head")
+HTML_TAG(HEADER, "header")
+HTML_TAG(HGROUP, "hgroup")
+HTML_TAG(HR, "hr")
+HTML_TAG(HTML, "html")
+HTML_TAG(I, "i")
+HTML_TAG(IFRAME, "iframe")
+HTML_TAG(IMG, "img")
+HTML_TAG(INPUT, "input")
+HTML_TAG(INS, "ins")
+HTML_TAG(KBD, "kbd")
+HTML_TAG(KEYGEN, "keygen")
+HTML_TAG(LABEL, "label")
+HTML_TAG(LEGEND, "legend")
+HTML_TAG(LI, "li")
+HTML_TAG(LINK, "link")
+HTML_TAG(MAIN, "main")
+HTML_TAG(MAP, "map")
+HTML_TAG(MARK, "mark")
+HTML_TAG(MARQUEE, "marquee")
+HTML_TAG(MENU, "menu")
+HTML_TAG(META, "meta")
+HTML_TAG(METER, "meter")
+HTML_TAG(NAV, "nav")
+HTML_TAG(NOBR, "nobr")
+HTML_TAG(NOFRAMES, "noframes")
+HTML_TAG(NOSCRIPT, "noscript")
+HTML_TAG(OBJECT, "object")
+HTML_TAG(OL, "ol")
+HTML_TAG(OPTGROUP, "optgroup")
+HTML_TAG(OPTION, "option")
+HTML_TAG(OUTPUT, "output")
+HTML_TAG(P, "p")
+HTML_TAG(PARAM, "param")
+HTML_TAG(PICTURE, "picture")
+HTML_TAG(PRE, "pre")
+HTML_TAG(PROGRESS, "progress")
+HTML_TAG(Q, "q")
+HTML_TAG(RP, "rp")
+HTML_TAG(RT, "rt")
+HTML_TAG(RUBY, "ruby")
+HTML_TAG(S, "s")
+HTML_TAG(SAMP, "samp")
+HTML_TAG(SCRIPT, "script")
+HTML_TAG(SECTION, "section")
+HTML_TAG(SELECT, "select")
+HTML_TAG(SMALL, "small")
+HTML_TAG(SOURCE, "source")
+HTML_TAG(SPAN, "span")
+HTML_TAG(STRIKE, "strike")
+HTML_TAG(STRONG, "strong")
+HTML_TAG(STYLE, "style")
+HTML_TAG(SUB, "sub")
+HTML_TAG(SUMMARY, "summary")
+HTML_TAG(SUP, "sup")
+HTML_TAG(SVG, "svg")
+HTML_TAG(TABLE, "table")
+HTML_TAG(TBODY, "tbody")
+HTML_TAG(TD, "td")
+HTML_TAG(TEMPLATE, "template")
+HTML_TAG(TEXTAREA, "textarea")
+HTML_TAG(TFOOT, "tfoot")
+HTML_TAG(TH, "th")
+HTML_TAG(THEAD, "thead")
+HTML_TAG(TIME, "time")
+HTML_TAG(TITLE, "title")
+HTML_TAG(TR, "tr")
+HTML_TAG(TRACK, "track")
+HTML_TAG(TT, "tt")
+HTML_TAG(U, "u")
+HTML_TAG(UL, "ul")
+HTML_TAG(VAR, "var")
+HTML_TAG(VIDEO, "video")
+HTML_TAG(WBR, "wbr")
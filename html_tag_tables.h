@@ -0,0 +1,30 @@
+// generated by html_tags_generator from html_tag_names.h, don't edit.
+
+static const uint8_t c_tag_displacements[64] =
+{
+    0, 2, 0, 0, 1, 0, 4, 1, 1, 15, 2, 2, 1, 2, 2, 0,
+    0, 0, 1, 1, 0, 1, 2, 2, 0, 0, 0, 0, 0, 1, 2, 7,
+    4, 0, 0, 1, 2, 0, 0, 5, 0, 3, 5, 1, 0, 0, 0, 0,
+    0, 0, 4, 0, 1, 3, 1, 0, 0, 0, 0, 2, 5, 2, 7, 9,
+};
+
+// atom in each slot, 0 for an empty slot.
+static const uint8_t c_tag_slots[256] =
+{
+    58, 0, 71, 72, 111, 112, 29, 0, 25, 83, 3, 0, 99, 0, 81, 87,
+    38, 0, 0, 0, 0, 66, 100, 8, 11, 0, 69, 27, 0, 6, 0, 0,
+    124, 18, 122, 0, 94, 0, 75, 0, 0, 50, 0, 57, 73, 0, 4, 86,
+    0, 0, 30, 0, 0, 0, 0, 0, 0, 5, 0, 76, 39, 103, 46, 0,
+    40, 0, 0, 48, 0, 0, 78, 0, 0, 0, 62, 0, 128, 89, 0, 0,
+    60, 0, 31, 105, 0, 0, 0, 0, 121, 0, 0, 0, 0, 9, 0, 68,
+    123, 0, 0, 92, 41, 79, 0, 35, 0, 88, 101, 127, 49, 107, 0, 115,
+    117, 0, 0, 0, 0, 0, 24, 21, 0, 65, 0, 0, 54, 34, 0, 63,
+    0, 97, 23, 26, 0, 125, 22, 0, 64, 0, 118, 0, 0, 0, 85, 95,
+    102, 0, 0, 0, 37, 0, 52, 0, 0, 0, 13, 0, 90, 109, 2, 7,
+    15, 0, 0, 74, 0, 0, 10, 0, 42, 0, 108, 0, 12, 119, 0, 0,
+    0, 114, 56, 0, 91, 113, 0, 33, 55, 0, 0, 0, 110, 0, 0, 96,
+    0, 0, 0, 20, 0, 84, 0, 17, 0, 0, 0, 0, 116, 0, 0, 0,
+    0, 0, 53, 98, 51, 0, 0, 0, 82, 19, 0, 1, 0, 0, 44, 0,
+    0, 93, 0, 0, 77, 32, 0, 59, 129, 126, 14, 0, 0, 28, 80, 43,
+    36, 0, 0, 106, 0, 16, 67, 104, 120, 70, 47, 0, 61, 45, 0, 0,
+};
@@ -0,0 +1,104 @@
+#include "html_tags.h"
+
+#include <cstring>
+
+static const char* c_tag_names[] =
+{
+    NULL,
+#define HTML_TAG(atom, name) name,
+#include "html_tag_names.h"
+#undef HTML_TAG
+};
+
+static const char* c_attribute_names[] =
+{
+    NULL,
+#define HTML_ATTRIBUTE(atom, name) name,
+#include "html_attribute_names.h"
+#undef HTML_ATTRIBUTE
+};
+
+// perfect hash of the known tags: the key packs the first two chars, the last char
+// and the length, it picks one of 64 buckets, and the displacement of the bucket
+// spreads its keys into 256 slots without collisions. html_tags_generator searches
+// the tables over the names of html_tag_names.h, with the same key and hashes.
+#include "html_tag_tables.h"
+
+static inline uint32_t get_tag_key(const char* name, size_t length)
+{
+    uint32_t second = length > 1 ? static_cast<unsigned char>(name[1]) : 0;
+    return static_cast<unsigned char>(name[0]) | second << 8 |
+        static_cast<uint32_t>(static_cast<unsigned char>(name[length - 1])) << 16 | static_cast<uint32_t>(length) << 24;
+}
+
+HtmlTag lookup_html_tag(const char* name, size_t length)
+{
+    // the longest known tag is "blockquote" or "figcaption".
+    if (length == 0 || length > 10)
+    {
+        return TAG_UNKNOWN;
+    }
+
+    uint32_t key = get_tag_key(name, length);
+    uint32_t bucket = (key * 0x9E3779B1u) >> 26;
+    uint32_t slot = ((key ^ c_tag_displacements[bucket]) * 0x85EBCA6Bu) >> 24;
+    HtmlTag tag = static_cast<HtmlTag>(c_tag_slots[slot]);
+    if (tag != TAG_UNKNOWN && strncmp(c_tag_names[tag], name, length) == 0 && c_tag_names[tag][length] == '\0')
+    {
+        return tag;
+    }
+
+    return TAG_UNKNOWN;
+}
+
+HtmlTag lookup_html_tag(const char* name)
+{
+    return lookup_html_tag(name, strlen(name));
+}
+
+const char* get_html_tag_name(HtmlTag tag)
+{
+    return c_tag_names[tag];
+}
+
+HtmlAttribute lookup_html_attribute(const char* name, size_t length)
+{
+    // names are sorted, binary search over the ids.
+    int low = ATTR_UNKNOWN + 1;
+    int high = ATTR_COUNT - 1;
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        const char* candidate = c_attribute_names[middle];
+        int result = strncmp(candidate, name, length);
+        if (result == 0 && candidate[length] != '\0')
+        {
+            result = 1;
+        }
+
+        if (result == 0)
+        {
+            return static_cast<HtmlAttribute>(middle);
+        }
+        else if (result < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return ATTR_UNKNOWN;
+}
+
+HtmlAttribute lookup_html_attribute(const char* name)
+{
+    return lookup_html_attribute(name, strlen(name));
+}
+
+const char* get_html_attribute_name(HtmlAttribute attribute)
+{
+    return c_attribute_names[attribute];
+}
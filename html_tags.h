@@ -0,0 +1,95 @@
+#ifndef _HTML_TAGS_H_
+#define _HTML_TAGS_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+// atoms of known html tags, so a tag decision is an integer or bitmask test instead of string compares.
+enum HtmlTag
+{
+    TAG_UNKNOWN,
+#define HTML_TAG(atom, name) TAG_##atom,
+#include "html_tag_names.h"
+#undef HTML_TAG
+    TAG_COUNT,
+};
+
+// atom of a lower case tag name, TAG_UNKNOWN if it is not a known tag.
+HtmlTag lookup_html_tag(const char* name, size_t length);
+HtmlTag lookup_html_tag(const char* name);
+
+// name of a known atom, NULL for TAG_UNKNOWN.
+const char* get_html_tag_name(HtmlTag tag);
+
+// ids of common attribute names, interned like tags.
+enum HtmlAttribute
+{
+    ATTR_UNKNOWN,
+#define HTML_ATTRIBUTE(atom, name) ATTR_##atom,
+#include "html_attribute_names.h"
+#undef HTML_ATTRIBUTE
+    ATTR_COUNT,
+};
+
+// id of a lower case attribute name, ATTR_UNKNOWN if it is not a common one.
+HtmlAttribute lookup_html_attribute(const char* name, size_t length);
+HtmlAttribute lookup_html_attribute(const char* name);
+
+// name of a known id, NULL for ATTR_UNKNOWN.
+const char* get_html_attribute_name(HtmlAttribute attribute);
+
+// set of atoms as a bitmask.
+class HtmlTagSet
+{
+public:
+    HtmlTagSet()
+    {
+        for (size_t i = 0; i < c_word_count; ++i)
+        {
+            this->m_words[i] = 0;
+        }
+    }
+
+    HtmlTagSet(const HtmlTag* tags, size_t count)
+    {
+        for (size_t i = 0; i < c_word_count; ++i)
+        {
+            this->m_words[i] = 0;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            this->insert(tags[i]);
+        }
+    }
+
+    void insert(HtmlTag tag)
+    {
+        this->m_words[tag / 64] |= static_cast<uint64_t>(1) << (tag % 64);
+    }
+
+    bool contains(HtmlTag tag) const
+    {
+        return (this->m_words[tag / 64] >> (tag % 64)) & 1;
+    }
+
+    bool empty() const
+    {
+        for (size_t i = 0; i < c_word_count; ++i)
+        {
+            if (this->m_words[i] != 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static const size_t c_word_count = (TAG_COUNT + 63) / 64;
+
+    uint64_t m_words[c_word_count];
+};
+
+#endif
@@ -0,0 +1,135 @@
+// writes html_tag_tables.h, the perfect hash of the tags of html_tag_names.h used by
+// lookup_html_tag. run by make after the list is changed:
+//     make html_tag_tables.h
+// the key and the hash functions are the ones of html_tags.cpp.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "html_tags.h"
+
+using namespace std;
+
+static const char* c_tag_names[] =
+{
+    NULL,
+#define HTML_TAG(atom, name) name,
+#include "html_tag_names.h"
+#undef HTML_TAG
+};
+
+static const size_t c_bucket_count = 64;
+static const size_t c_slot_count = 256;
+
+static uint32_t get_tag_key(const char* name, size_t length)
+{
+    uint32_t second = length > 1 ? static_cast<unsigned char>(name[1]) : 0;
+    return static_cast<unsigned char>(name[0]) | second << 8 |
+        static_cast<uint32_t>(static_cast<unsigned char>(name[length - 1])) << 16 | static_cast<uint32_t>(length) << 24;
+}
+
+static uint32_t get_bucket(uint32_t key)
+{
+    return (key * 0x9E3779B1u) >> 26;
+}
+
+static uint32_t get_slot(uint32_t key, uint32_t displacement)
+{
+    return ((key ^ displacement) * 0x85EBCA6Bu) >> 24;
+}
+
+// larger buckets first, they are the hardest to place.
+static bool compare_bucket_size(const vector<int>* first, const vector<int>* second)
+{
+    return first->size() > second->size();
+}
+
+static void print_table(const char* declaration, const uint8_t* values, size_t count)
+{
+    printf("%s =\n{\n", declaration);
+    for (size_t i = 0; i < count; i += 16)
+    {
+        printf("   ");
+        for (size_t j = i; j < i + 16 && j < count; ++j)
+        {
+            printf(" %d,", values[j]);
+        }
+
+        printf("\n");
+    }
+
+    printf("};\n");
+}
+
+int main()
+{
+    vector<vector<int> > buckets(c_bucket_count);
+    vector<uint32_t> keys(TAG_COUNT, 0);
+    for (int tag = TAG_UNKNOWN + 1; tag < TAG_COUNT; ++tag)
+    {
+        size_t length = strlen(c_tag_names[tag]);
+        if (length > 10)
+        {
+            fprintf(stderr, "%s is longer than the 10 chars lookup_html_tag accepts\n", c_tag_names[tag]);
+            return 1;
+        }
+
+        keys[tag] = get_tag_key(c_tag_names[tag], length);
+        buckets[get_bucket(keys[tag])].push_back(tag);
+    }
+
+    vector<const vector<int>*> order;
+    for (size_t i = 0; i < c_bucket_count; ++i)
+    {
+        order.push_back(&buckets[i]);
+    }
+
+    stable_sort(order.begin(), order.end(), compare_bucket_size);
+
+    // the first displacement which puts every key of the bucket into a free slot.
+    uint8_t displacements[c_bucket_count] = {0};
+    uint8_t slots[c_slot_count] = {0};
+    for (size_t i = 0; i < c_bucket_count && !order[i]->empty(); ++i)
+    {
+        const vector<int>& bucket = *order[i];
+        bool placed = false;
+        for (uint32_t displacement = 0; displacement < 256 && !placed; ++displacement)
+        {
+            vector<uint32_t> taken;
+            for (size_t j = 0; j < bucket.size(); ++j)
+            {
+                uint32_t slot = get_slot(keys[bucket[j]], displacement);
+                if (slots[slot] != 0 || find(taken.begin(), taken.end(), slot) != taken.end())
+                {
+                    break;
+                }
+
+                taken.push_back(slot);
+            }
+
+            if (taken.size() == bucket.size())
+            {
+                for (size_t j = 0; j < bucket.size(); ++j)
+                {
+                    slots[taken[j]] = static_cast<uint8_t>(bucket[j]);
+                }
+
+                displacements[get_bucket(keys[bucket[0]])] = static_cast<uint8_t>(displacement);
+                placed = true;
+            }
+        }
+
+        if (!placed)
+        {
+            fprintf(stderr, "no displacement places the bucket of %s, change the hash of html_tags.cpp\n", c_tag_names[bucket[0]]);
+            return 1;
+        }
+    }
+
+    printf("// generated by html_tags_generator from html_tag_names.h, don't edit.\n\n");
+    print_table("static const uint8_t c_tag_displacements[64]", displacements, c_bucket_count);
+    printf("\n// atom in each slot, 0 for an empty slot.\n");
+    print_table("static const uint8_t c_tag_slots[256]", slots, c_slot_count);
+    return 0;
+}
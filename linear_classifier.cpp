@@ -16,9 +16,14 @@ bool LinearClassifier::init(const vector<double>& weights, double threshold)
 }
 
 bool LinearClassifier::classify(const vector<double>& features, double& score) const
+{
+    return this->classify(features.empty() ? NULL : &features[0], features.size(), score);
+}
+
+bool LinearClassifier::classify(const double* features, size_t size, double& score) const
 {
     // weights of features
-    assert(features.size() >= this->_weights.size());
+    assert(size >= this->_weights.size());
     score = 0.0;
     for (size_t i = 0; i < this->_weights.size(); ++i)
     {
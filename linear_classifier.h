@@ -1,6 +1,7 @@
 #ifndef _LINEAR_CLASSIFIER_H_
 #define _LINEAR_CLASSIFIER_H_
 
+#include <cstddef>
 #include <vector>
 
 class LinearClassifier
@@ -15,6 +16,9 @@ public:
 
     bool classify(const std::vector<double>& features, double& score) const;
 
+    // features is an array of size values.
+    bool classify(const double* features, size_t size, double& score) const;
+
     bool classify(const std::vector<double>& features) const;
 
 private:
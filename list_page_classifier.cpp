@@ -1,15 +1,14 @@
 #include <assert.h>
-#include <iostream>
 #include <cstring>
 
 #include "list_page_classifier.h"
+#include "log.h"
+#include "stage_stats.h"
 #include "utils.h"
 #include "config.h"
 
 using namespace std;
 
-const char* c_anchor_tag = "a";
-size_t c_anchor_tag_len = strlen(c_anchor_tag);
 const char* c_section_name = "listPageClassifier";
 int c_large_text_length_threshold = 80;
 int c_non_link_text_length_threshold = 600;
@@ -24,7 +23,7 @@ bool ListPageClassifier::init(const char* config_file_path)
     bool ret = config.Init(config_file_path);
     if (!ret)
     {
-        std::cout << "init config failed";
+        ERROR_LOG(LOG_CONFIG, "init config failed");
         return false;
     }
 
@@ -33,11 +32,12 @@ bool ListPageClassifier::init(const char* config_file_path)
     this->m_large_text_threshold = config.GetIntValue(c_section_name, "large_text_length_threshold", c_large_text_length_threshold);
     config.GetStringList(c_section_name, "url_filename_blacklist", this->m_filename_blacklist, "");
 
-    const char* model_file_path = config.GetValue(c_section_name, "model_file_path").c_str();
-    bool success = this->m_classifier.init(model_file_path);
+    // keep the string, the value returned is a temporary.
+    string model_file_path = config.GetValue(c_section_name, "model_file_path");
+    bool success = this->m_classifier.init(model_file_path.c_str());
     if (!success)
     {
-        std::cout << "init classifier failed";
+        ERROR_LOG(LOG_CONFIG, "init classifier failed");
         return false;
     }
 
@@ -51,9 +51,13 @@ bool ListPageClassifier::classify(DomNode* dom, const char* url) const
     assert(dom != NULL);
     assert(url != NULL);
 
+    uint64_t start = stage_now();
     std::vector<double> features(FN_TOTAL_FEATURE_COUNT, 0);
     this->extract_features(dom, url, features);
+    uint64_t time = record_stage(STAGE_CLASSIFY_FEATURES, start);
     double label = this->m_classifier.classify(features);
+    record_stage(STAGE_PREDICT, time);
+    record_stage(STAGE_CLASSIFY, start);
     if (label == 1.0)
     {
         return true;
@@ -64,6 +68,37 @@ bool ListPageClassifier::classify(DomNode* dom, const char* url) const
     }
 }
 
+bool ListPageClassifier::classify(const FlatDom& dom, const char* url) const
+{
+    assert(this->m_initialized);
+    assert(dom.size() > 0);
+    assert(url != NULL);
+
+    uint64_t start = stage_now();
+    std::vector<double> features(FN_TOTAL_FEATURE_COUNT, 0);
+    this->extract_features(dom, url, features);
+    uint64_t time = record_stage(STAGE_CLASSIFY_FEATURES, start);
+    double label = this->m_classifier.classify(features);
+    record_stage(STAGE_PREDICT, time);
+    record_stage(STAGE_CLASSIFY, start);
+    return label == 1.0;
+}
+
+bool ListPageClassifier::classify(const FeatureVisitor& visitor, const char* url) const
+{
+    assert(this->m_initialized);
+    assert(url != NULL);
+
+    uint64_t start = stage_now();
+    std::vector<double> features(FN_TOTAL_FEATURE_COUNT, 0);
+    this->calculate_features(url, visitor.get_features(), features);
+    uint64_t time = record_stage(STAGE_CLASSIFY_FEATURES, start);
+    double label = this->m_classifier.classify(features);
+    record_stage(STAGE_PREDICT, time);
+    record_stage(STAGE_CLASSIFY, start);
+    return label == 1.0;
+}
+
 void ListPageClassifier::extract_features(DomNode* dom, const char* url, std::vector<double>& features) const
 {
     std::vector<int> internal_features(IFN_TOTAL_FEATURE_COUNT, 0);
@@ -71,6 +106,13 @@ void ListPageClassifier::extract_features(DomNode* dom, const char* url, std::ve
     this->calculate_features(url, internal_features, features);
 }
 
+void ListPageClassifier::extract_features(const FlatDom& dom, const char* url, std::vector<double>& features) const
+{
+    std::vector<int> internal_features(IFN_TOTAL_FEATURE_COUNT, 0);
+    this->traverse(dom, internal_features);
+    this->calculate_features(url, internal_features, features);
+}
+
 void ListPageClassifier::calculate_features(const char* url, const std::vector<int>& internal_features, std::vector<double>& features) const
 {
     features[FN_LINK_TEXT_RATIO] = internal_features[IFN_TEXT_LENGTH] > 0 ? internal_features[IFN_LINK_TEXT_LENGTH] * 1.0 / internal_features[IFN_TEXT_LENGTH] : 0;
@@ -84,28 +126,48 @@ void ListPageClassifier::calculate_features(const char* url, const std::vector<i
 
 void ListPageClassifier::traverse(DomNode* node, std::vector<int>& features) const
 {
-    const std::vector<DomNode*>* children = node->get_children();
-    assert(children != NULL);
+    FeatureVisitor visitor(this);
+    DomTraversalStack stack;
+    DomTreeTraversal<FeatureVisitor>::preorder(node, visitor, stack);
+    for (size_t i = 0; i < features.size(); ++i)
+    {
+        features[i] += visitor.get_features()[i];
+    }
+}
 
-    this->process_node(node, features);
+void ListPageClassifier::traverse(const FlatDom& dom, std::vector<int>& features) const
+{
+    for (int32_t i = 0; i < dom.size(); ++i)
+    {
+        int text_length = 0;
+        for (size_t j = 0; j < dom.get_text_piece_count(i); ++j)
+        {
+            StringPiece piece = dom.get_text_piece(i, j);
+            text_length += count_without_spaces(piece.data(), piece.size());
+        }
+
+        this->process_node(dom.get_tag_atom(i), text_length, features);
+    }
+}
 
-    for (std::vector<DomNode*>::const_iterator i = children->begin(); i != children->end(); ++i)
+void ListPageClassifier::process_node(const DomNode* node, std::vector<int>& features) const
+{
+    // count over the text pieces, so the text of a view node is not concatenated.
+    int text_length = 0;
+    for (size_t i = 0; i < node->get_text_piece_count(); ++i)
     {
-        DomNode* child = *i;
-        assert(child != NULL);
-        this->traverse(child, features);
+        StringPiece piece = node->get_text_piece(i);
+        text_length += count_without_spaces(piece.data(), piece.size());
     }
+
+    this->process_node(node->get_tag_atom(), text_length, features);
 }
 
-void ListPageClassifier::process_node(DomNode* node, std::vector<int>& features) const
+void ListPageClassifier::process_node(HtmlTag tag, int text_length, std::vector<int>& features) const
 {
-    const char* text = node->get_text();
-    int text_length = count_without_spaces(text); 
     features[IFN_TEXT_LENGTH] += text_length;
 
-    const char* tag = node->get_tag();
-    assert(tag != NULL);
-    if (strncmp(tag, c_anchor_tag, c_anchor_tag_len) == 0)
+    if (tag == TAG_A)
     {
         features[IFN_LINK_TEXT_LENGTH] += text_length;
     }
@@ -2,13 +2,52 @@
 #define _LIST_PAGE_CLASSIFIER_H_
 
 #include "dom_tree.h"
+#include "flat_dom.h"
 #include "SvmClassifier.h"
 
+// init is not thread safe, the model loader of libsvm has a static buffer. once initialized,
+// a classifier can be shared by many threads, classify doesn't write it.
 class ListPageClassifier
 {
     friend class ListPageClassifierTest;
 
+    enum Internal_FeatureNames
+    {
+        IFN_LINK_TEXT_LENGTH,
+        IFN_TEXT_LENGTH,
+        IFN_LARGE_TEXT_COUNT,
+        IFN_TOTAL_FEATURE_COUNT,
+    };
+
 public:
+    // gathers the features of the nodes it enters, so a page can be classified from a
+    // traversal shared with other visitors, like BodyExtractor::extract(dom, visitor).
+    // the traversal should enter every node, a visitor fused before it must not drop any.
+    class FeatureVisitor : public DomTreeVisitor
+    {
+    public:
+        FeatureVisitor(const ListPageClassifier* classifier) :
+            m_classifier(classifier),
+            m_features(IFN_TOTAL_FEATURE_COUNT, 0)
+        {
+        }
+
+        virtual bool preprocess(DomNode* node)
+        {
+            this->m_classifier->process_node(node, this->m_features);
+            return true;
+        }
+
+        const std::vector<int>& get_features() const
+        {
+            return this->m_features;
+        }
+
+    private:
+        const ListPageClassifier* m_classifier;
+        std::vector<int> m_features;
+    };
+
     ListPageClassifier() :
         m_initialized(false)
     {
@@ -22,6 +61,10 @@ public:
 
     // assume preprocess is done
     bool classify(DomNode* dom, const char* url) const;
+    bool classify(const FlatDom& dom, const char* url) const;
+    // classify with the features visitor gathered.
+    bool classify(const FeatureVisitor& visitor, const char* url) const;
+
 private:
     enum FeatureNames
     {
@@ -32,18 +75,14 @@ private:
         FN_TOTAL_FEATURE_COUNT,
     };
 
-    enum Internal_FeatureNames
-    {
-        IFN_LINK_TEXT_LENGTH,
-        IFN_TEXT_LENGTH,
-        IFN_LARGE_TEXT_COUNT,
-        IFN_TOTAL_FEATURE_COUNT,
-    };
-
     void extract_features(DomNode* dom, const char* url, std::vector<double>& features) const;
+    void extract_features(const FlatDom& dom, const char* url, std::vector<double>& features) const;
     void calculate_features(const char* url, const std::vector<int>& internal_features, std::vector<double>& features) const;
     void traverse(DomNode* node, std::vector<int>& features) const;
-    void process_node(DomNode* node, std::vector<int>& features) const;
+    // a flat tree is in preorder already, so it is one linear scan.
+    void traverse(const FlatDom& dom, std::vector<int>& features) const;
+    void process_node(const DomNode* node, std::vector<int>& features) const;
+    void process_node(HtmlTag tag, int text_length, std::vector<int>& features) const;
     bool is_url_filename(const char* url) const;
 
     int m_non_link_text_length_threshold;
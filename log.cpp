@@ -0,0 +1,35 @@
+#include "log.h"
+
+using namespace std;
+
+int g_log_level = LOG_LEVEL_INFO;
+uint32_t g_log_categories = LOG_ALL_CATEGORIES;
+static FILE* s_log_file = NULL;
+
+static const char* c_level_names[] = {"none", "error", "warning", "info", "debug", "trace"};
+
+void set_log_level(int level)
+{
+    g_log_level = level;
+}
+
+void set_log_categories(uint32_t categories)
+{
+    g_log_categories = categories;
+}
+
+void set_log_file(FILE* file)
+{
+    s_log_file = file;
+}
+
+void log_write(int level, const string& message)
+{
+    string line = level >= LOG_LEVEL_NONE && level <= LOG_LEVEL_TRACE ? c_level_names[level] : "log";
+    line += ": ";
+    line += message;
+    line += '\n';
+    // one fwrite holds the lock of the file for the whole line.
+    FILE* file = s_log_file != NULL ? s_log_file : stderr;
+    fwrite(line.data(), 1, line.size(), file);
+}
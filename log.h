@@ -0,0 +1,106 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <stdint.h>
+
+// levels of the log, a message is kept if its level is at most the level set.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5
+
+// messages above it are not compiled at all, their arguments are not evaluated.
+// the per node messages of the traversals are at trace, build with
+// -DLOG_MAX_LEVEL=LOG_LEVEL_TRACE to get them.
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_LEVEL_INFO
+#endif
+
+// categories of messages, bits which can be selected together.
+enum LogCategory
+{
+    LOG_CONFIG = 1,
+    LOG_DOM = 2,
+    LOG_EXTRACT = 4,
+    LOG_CLASSIFY = 8,
+    LOG_ALL_CATEGORIES = 0xffffffff
+};
+
+// the level and categories logged at runtime, info and all categories by default.
+// they are read without a lock, set them before starting the threads which log.
+extern int g_log_level;
+extern uint32_t g_log_categories;
+
+void set_log_level(int level);
+void set_log_categories(uint32_t categories);
+// stderr by default, the file is not closed.
+void set_log_file(FILE* file);
+
+inline bool log_enabled(int level, uint32_t category)
+{
+    return level <= g_log_level && (category & g_log_categories) != 0;
+}
+
+// writes a line at once, lines of several threads don't mix.
+void log_write(int level, const std::string& message);
+
+// true if the messages of level and category would be written, false at compile time if
+// the level is compiled out, for debug output which needs more than a message.
+#define LOG_ENABLED(level, category) ((level) <= LOG_MAX_LEVEL && log_enabled((level), (category)))
+
+// message is a chain of <<, it is only formatted when it is written.
+#define LOG_MESSAGE(level, category, message) \
+    do \
+    { \
+        if (log_enabled((level), (category))) \
+        { \
+            std::ostringstream log_stream_; \
+            log_stream_ << message; \
+            log_write((level), log_stream_.str()); \
+        } \
+    } while (0)
+
+#define LOG_DISABLED() do {} while (0)
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_ERROR
+#define ERROR_LOG(category, message) LOG_MESSAGE(LOG_LEVEL_ERROR, category, message)
+#else
+#define ERROR_LOG(category, message) LOG_DISABLED()
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_WARNING
+#define WARNING_LOG(category, message) LOG_MESSAGE(LOG_LEVEL_WARNING, category, message)
+#else
+#define WARNING_LOG(category, message) LOG_DISABLED()
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_INFO
+#define INFO_LOG(category, message) LOG_MESSAGE(LOG_LEVEL_INFO, category, message)
+#else
+#define INFO_LOG(category, message) LOG_DISABLED()
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
+#define DEBUG_LOG(category, message) LOG_MESSAGE(LOG_LEVEL_DEBUG, category, message)
+#else
+#define DEBUG_LOG(category, message) LOG_DISABLED()
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_TRACE
+#define TRACE_LOG(category, message) LOG_MESSAGE(LOG_LEVEL_TRACE, category, message)
+#else
+#define TRACE_LOG(category, message) LOG_DISABLED()
+#endif
+
+// a NULL string streamed is undefined, attributes which may be missing go through it.
+inline const char* log_string(const char* text)
+{
+    return text != NULL ? text : "(null)";
+}
+
+#endif
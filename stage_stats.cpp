@@ -0,0 +1,253 @@
+#include "stage_stats.h"
+
+#include <assert.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+
+using namespace std;
+
+static const char* c_metric_names[] =
+{
+    "extract",
+    "flat_build",
+    "traverse",
+    "promote",
+    "score",
+    "get_body",
+    "sanitize",
+    "classify",
+    "classify_features",
+    "predict",
+    "nodes",
+    "candidates"
+};
+
+typedef char metric_name_check[sizeof(c_metric_names) / sizeof(c_metric_names[0]) == STAGE_METRIC_COUNT ? 1 : -1];
+
+// the histograms of a thread. only the thread writes them, the snapshots read them
+// meanwhile, so both sides use relaxed atomic loads and stores, which are plain moves.
+struct ThreadStageStats
+{
+    uint64_t counts[STAGE_METRIC_COUNT][StageSnapshot::c_bucket_count];
+    uint64_t sums[STAGE_METRIC_COUNT];
+};
+
+// the stats of every thread which recorded, they are kept after the thread exits so the
+// totals don't go down, and given to the next new thread.
+static pthread_mutex_t s_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static vector<ThreadStageStats*>* s_all_stats = NULL;
+static vector<ThreadStageStats*>* s_free_stats = NULL;
+static pthread_key_t s_thread_stats_key;
+static pthread_once_t s_thread_stats_once = PTHREAD_ONCE_INIT;
+
+static void release_thread_stats(void* stats)
+{
+    pthread_mutex_lock(&s_stats_mutex);
+    s_free_stats->push_back(static_cast<ThreadStageStats*>(stats));
+    pthread_mutex_unlock(&s_stats_mutex);
+}
+
+static void create_thread_stats_key()
+{
+    // never deleted, threads may still record while the process exits.
+    s_all_stats = new vector<ThreadStageStats*>();
+    s_free_stats = new vector<ThreadStageStats*>();
+    int result = pthread_key_create(&s_thread_stats_key, release_thread_stats);
+    assert(result == 0);
+    (void)result;
+}
+
+static ThreadStageStats* get_thread_stats()
+{
+    pthread_once(&s_thread_stats_once, create_thread_stats_key);
+    ThreadStageStats* stats = static_cast<ThreadStageStats*>(pthread_getspecific(s_thread_stats_key));
+    if (stats == NULL)
+    {
+        pthread_mutex_lock(&s_stats_mutex);
+        if (!s_free_stats->empty())
+        {
+            stats = s_free_stats->back();
+            s_free_stats->pop_back();
+        }
+        else
+        {
+            stats = new ThreadStageStats();
+            memset(stats, 0, sizeof(ThreadStageStats));
+            s_all_stats->push_back(stats);
+        }
+
+        pthread_mutex_unlock(&s_stats_mutex);
+        pthread_setspecific(s_thread_stats_key, stats);
+    }
+
+    return stats;
+}
+
+static inline void add_relaxed(uint64_t* value, uint64_t delta)
+{
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+uint64_t stage_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void record_value(StageMetric metric, uint64_t value)
+{
+    assert(metric >= 0 && metric < STAGE_METRIC_COUNT);
+    ThreadStageStats* stats = get_thread_stats();
+    add_relaxed(&stats->counts[metric][StageSnapshot::get_bucket(value)], 1);
+    add_relaxed(&stats->sums[metric], value);
+}
+
+StageSnapshot::StageSnapshot()
+{
+    memset(this->m_counts, 0, sizeof(this->m_counts));
+    memset(this->m_sums, 0, sizeof(this->m_sums));
+}
+
+void StageSnapshot::take()
+{
+    memset(this->m_counts, 0, sizeof(this->m_counts));
+    memset(this->m_sums, 0, sizeof(this->m_sums));
+    pthread_once(&s_thread_stats_once, create_thread_stats_key);
+    pthread_mutex_lock(&s_stats_mutex);
+    for (size_t i = 0; i < s_all_stats->size(); ++i)
+    {
+        ThreadStageStats* stats = (*s_all_stats)[i];
+        for (int metric = 0; metric < STAGE_METRIC_COUNT; ++metric)
+        {
+            for (int bucket = 0; bucket < c_bucket_count; ++bucket)
+            {
+                this->m_counts[metric][bucket] += __atomic_load_n(&stats->counts[metric][bucket], __ATOMIC_RELAXED);
+            }
+
+            this->m_sums[metric] += __atomic_load_n(&stats->sums[metric], __ATOMIC_RELAXED);
+        }
+    }
+
+    pthread_mutex_unlock(&s_stats_mutex);
+}
+
+void StageSnapshot::subtract(const StageSnapshot& earlier)
+{
+    for (int metric = 0; metric < STAGE_METRIC_COUNT; ++metric)
+    {
+        for (int bucket = 0; bucket < c_bucket_count; ++bucket)
+        {
+            this->m_counts[metric][bucket] -= earlier.m_counts[metric][bucket];
+        }
+
+        this->m_sums[metric] -= earlier.m_sums[metric];
+    }
+}
+
+uint64_t StageSnapshot::get_count(StageMetric metric) const
+{
+    uint64_t count = 0;
+    for (int bucket = 0; bucket < c_bucket_count; ++bucket)
+    {
+        count += this->m_counts[metric][bucket];
+    }
+
+    return count;
+}
+
+uint64_t StageSnapshot::get_sum(StageMetric metric) const
+{
+    return this->m_sums[metric];
+}
+
+uint64_t StageSnapshot::get_percentile(StageMetric metric, double fraction) const
+{
+    uint64_t count = this->get_count(metric);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // the rank of the value, from 1.
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count) + 0.999999);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < c_bucket_count; ++bucket)
+    {
+        seen += this->m_counts[metric][bucket];
+        if (seen >= rank)
+        {
+            uint64_t low = get_bucket_low(bucket);
+            return low + (get_bucket_high(bucket) - low) / 2;
+        }
+    }
+
+    return get_bucket_high(c_bucket_count - 1);
+}
+
+void StageSnapshot::write(string& text) const
+{
+    char line[256];
+    for (int metric = 0; metric < STAGE_METRIC_COUNT; ++metric)
+    {
+        StageMetric m = static_cast<StageMetric>(metric);
+        uint64_t count = this->get_count(m);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        // counts as they are, times in microseconds.
+        double scale = m >= COUNT_NODES ? 1.0 : 1e-3;
+        snprintf(line, sizeof(line), "%-18s count %10llu mean %12.2f p50 %12.2f p99 %12.2f\n", c_metric_names[metric],
+            static_cast<unsigned long long>(count), static_cast<double>(this->m_sums[metric]) / static_cast<double>(count) * scale,
+            static_cast<double>(this->get_percentile(m, 0.5)) * scale, static_cast<double>(this->get_percentile(m, 0.99)) * scale);
+        text += line;
+    }
+}
+
+const char* StageSnapshot::get_metric_name(StageMetric metric)
+{
+    assert(metric >= 0 && metric < STAGE_METRIC_COUNT);
+    return c_metric_names[metric];
+}
+
+int StageSnapshot::get_bucket(uint64_t value)
+{
+    if (value < 8)
+    {
+        return static_cast<int>(value);
+    }
+
+    // 4 buckets for every power of two from 8, told apart by the 2 bits after the top one.
+    int top = 63 - __builtin_clzll(value);
+    return 8 + (top - 3) * 4 + static_cast<int>((value >> (top - 2)) & 3);
+}
+
+uint64_t StageSnapshot::get_bucket_low(int bucket)
+{
+    assert(bucket >= 0 && bucket < c_bucket_count);
+    if (bucket < 8)
+    {
+        return static_cast<uint64_t>(bucket);
+    }
+
+    int top = (bucket - 8) / 4 + 3;
+    return static_cast<uint64_t>(4 + (bucket - 8) % 4) << (top - 2);
+}
+
+uint64_t StageSnapshot::get_bucket_high(int bucket)
+{
+    assert(bucket >= 0 && bucket < c_bucket_count);
+    if (bucket < 8)
+    {
+        return static_cast<uint64_t>(bucket);
+    }
+
+    int top = (bucket - 8) / 4 + 3;
+    return get_bucket_low(bucket) + (static_cast<uint64_t>(1) << (top - 2)) - 1;
+}
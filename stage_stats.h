@@ -0,0 +1,84 @@
+#ifndef _STAGE_STATS_H_
+#define _STAGE_STATS_H_
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+// what is measured: the wall time of the stages of extract and classify in nanoseconds,
+// and the sizes of every document.
+enum StageMetric
+{
+    // extract, with the stages below.
+    STAGE_EXTRACT,
+    // building the flat tree for the non-destructive extraction.
+    STAGE_FLAT_BUILD,
+    // the walk dropping negative nodes and computing features, with the scoring of the tree path.
+    STAGE_TRAVERSE,
+    // adding the parents and grandparents of the candidates, flat path.
+    STAGE_PROMOTE,
+    // scoring the candidates, flat path.
+    STAGE_SCORE,
+    STAGE_GET_BODY,
+    // sanitize and post validation.
+    STAGE_SANITIZE,
+    // classify, with the stages below.
+    STAGE_CLASSIFY,
+    STAGE_CLASSIFY_FEATURES,
+    STAGE_PREDICT,
+    // nodes walked and candidates scored for a document.
+    COUNT_NODES,
+    COUNT_CANDIDATES,
+    STAGE_METRIC_COUNT
+};
+
+// monotonic clock in nanoseconds.
+uint64_t stage_now();
+
+// adds a value to the histogram of the calling thread. no lock, no allocation after the
+// first call of a thread.
+void record_value(StageMetric metric, uint64_t value);
+
+// records the time since start and returns the current time, which starts the next stage.
+inline uint64_t record_stage(StageMetric metric, uint64_t start)
+{
+    uint64_t now = stage_now();
+    record_value(metric, now - start);
+    return now;
+}
+
+// the histograms of all threads merged, taken while the threads keep recording.
+// values of 0-7 have their own buckets, larger ones are in 4 buckets per power of two,
+// so a percentile is within 1/8 of the true one.
+class StageSnapshot
+{
+public:
+    static const int c_bucket_count = 8 + 61 * 4;
+
+    StageSnapshot();
+
+    // everything recorded so far by the threads of the process.
+    void take();
+    // what was recorded between earlier and this one, to get the stats of an interval.
+    void subtract(const StageSnapshot& earlier);
+
+    uint64_t get_count(StageMetric metric) const;
+    uint64_t get_sum(StageMetric metric) const;
+    // the value below which a fraction of the recorded values are, 0 if there is none.
+    uint64_t get_percentile(StageMetric metric, double fraction) const;
+
+    // a line for every metric recorded: name, count, mean, p50 and p99, times in microseconds.
+    void write(std::string& text) const;
+
+    static const char* get_metric_name(StageMetric metric);
+    static int get_bucket(uint64_t value);
+    // the values of bucket are in [low, high].
+    static uint64_t get_bucket_low(int bucket);
+    static uint64_t get_bucket_high(int bucket);
+
+private:
+    uint64_t m_counts[STAGE_METRIC_COUNT][c_bucket_count];
+    uint64_t m_sums[STAGE_METRIC_COUNT];
+};
+
+#endif
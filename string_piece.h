@@ -0,0 +1,57 @@
+#ifndef _STRING_PIECE_H_
+#define _STRING_PIECE_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// a view of chars owned by someone else, such as the html buffer of a dom tree.
+class StringPiece
+{
+public:
+    StringPiece() :
+        m_data(NULL), m_size(0)
+    {
+    }
+
+    StringPiece(const char* data, size_t size) :
+        m_data(data), m_size(size)
+    {
+    }
+
+    const char* data() const
+    {
+        return this->m_data;
+    }
+
+    size_t size() const
+    {
+        return this->m_size;
+    }
+
+    bool empty() const
+    {
+        return this->m_size == 0;
+    }
+
+    char operator[](size_t i) const
+    {
+        return this->m_data[i];
+    }
+
+    bool equals(const char* str) const
+    {
+        return (this->m_size == 0 || strncmp(this->m_data, str, this->m_size) == 0) && str[this->m_size] == '\0';
+    }
+
+    std::string as_string() const
+    {
+        return std::string(this->m_data, this->m_size);
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+#endif
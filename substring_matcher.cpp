@@ -0,0 +1,379 @@
+#include "substring_matcher.h"
+
+#include <assert.h>
+#include <cstring>
+
+using namespace std;
+
+SubstringMatcher::SubstringMatcher() :
+    m_fingerprint(14695981039346656037ull), m_all_lists(0), m_built(false), m_class_count(1)
+{
+    memset(this->m_byte_classes, 0, sizeof(this->m_byte_classes));
+    TrieNode root;
+    root.lists = 0;
+    this->m_trie.push_back(root);
+}
+
+int32_t SubstringMatcher::get_trie_child(int32_t node, unsigned char c) const
+{
+    const vector<pair<unsigned char, int32_t> >& children = this->m_trie[node].children;
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        if (children[i].first == c)
+        {
+            return children[i].second;
+        }
+    }
+
+    return -1;
+}
+
+void SubstringMatcher::add_patterns(const vector<string>& patterns, uint32_t list)
+{
+    assert(list != 0);
+    assert(!this->m_built);
+
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        const string& pattern = patterns[i];
+        // fnv-1a over the list and the pattern with its terminator.
+        this->m_fingerprint = (this->m_fingerprint ^ list) * 1099511628211ull;
+        for (size_t j = 0; j <= pattern.size(); ++j)
+        {
+            this->m_fingerprint = (this->m_fingerprint ^ static_cast<unsigned char>(pattern.c_str()[j])) * 1099511628211ull;
+        }
+
+        int32_t node = 0;
+        for (size_t j = 0; j < pattern.size(); ++j)
+        {
+            unsigned char c = static_cast<unsigned char>(pattern[j]);
+            int32_t child = this->get_trie_child(node, c);
+            if (child < 0)
+            {
+                child = static_cast<int32_t>(this->m_trie.size());
+                TrieNode trie_node;
+                trie_node.lists = 0;
+                this->m_trie.push_back(trie_node);
+                this->m_trie[node].children.push_back(make_pair(c, child));
+            }
+
+            node = child;
+        }
+
+        // an empty pattern is in every text, like string::find.
+        this->m_trie[node].lists |= list;
+        this->m_all_lists |= list;
+    }
+}
+
+void SubstringMatcher::build()
+{
+    assert(!this->m_built);
+
+    for (size_t i = 0; i < this->m_trie.size(); ++i)
+    {
+        const vector<pair<unsigned char, int32_t> >& children = this->m_trie[i].children;
+        for (size_t j = 0; j < children.size(); ++j)
+        {
+            if (this->m_byte_classes[children[j].first] == 0)
+            {
+                this->m_byte_classes[children[j].first] = static_cast<uint16_t>(this->m_class_count++);
+            }
+        }
+    }
+
+    int32_t state_count = static_cast<int32_t>(this->m_trie.size());
+    this->m_transitions.assign(static_cast<size_t>(state_count) * static_cast<size_t>(this->m_class_count), 0);
+    this->m_outputs.assign(static_cast<size_t>(state_count), 0);
+
+    // breadth first, so the failure state of a node is done before the node.
+    vector<int32_t> failures(static_cast<size_t>(state_count), 0);
+    vector<int32_t> queue;
+    queue.reserve(static_cast<size_t>(state_count));
+    queue.push_back(0);
+    this->m_outputs[0] = this->m_trie[0].lists;
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        int32_t state = queue[head];
+        int32_t* row = &this->m_transitions[static_cast<size_t>(state) * static_cast<size_t>(this->m_class_count)];
+        // missing transitions are those of the failure state, the root loops to itself.
+        if (state != 0)
+        {
+            const int32_t* failure_row = &this->m_transitions[static_cast<size_t>(failures[state]) * static_cast<size_t>(this->m_class_count)];
+            memcpy(row, failure_row, sizeof(int32_t) * static_cast<size_t>(this->m_class_count));
+        }
+
+        const vector<pair<unsigned char, int32_t> >& children = this->m_trie[state].children;
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+            int32_t child = children[i].second;
+            int32_t column = this->m_byte_classes[children[i].first];
+            failures[child] = state != 0 ? row[column] : 0;
+            row[column] = child;
+            this->m_outputs[child] = this->m_trie[child].lists | this->m_outputs[failures[child]];
+            queue.push_back(child);
+        }
+    }
+
+    // the trie is not needed any more.
+    vector<TrieNode>().swap(this->m_trie);
+    this->m_built = true;
+}
+
+uint32_t SubstringMatcher::match(const char* text, size_t length) const
+{
+    assert(this->m_built);
+
+    uint32_t lists = this->m_outputs[0];
+    int32_t state = 0;
+    for (size_t i = 0; i < length && lists != this->m_all_lists; ++i)
+    {
+        int32_t column = this->m_byte_classes[static_cast<unsigned char>(text[i])];
+        state = this->m_transitions[static_cast<size_t>(state) * static_cast<size_t>(this->m_class_count) + static_cast<size_t>(column)];
+        lists |= this->m_outputs[state];
+    }
+
+    return lists;
+}
+
+uint32_t SubstringMatcher::match(const char* text) const
+{
+    return this->match(text, strlen(text));
+}
+
+static uint32_t hash_value(const char* text, size_t length)
+{
+    // fnv-1a.
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+SharedSubstringMatchCache::SharedSubstringMatchCache(size_t capacity) :
+    m_set_count(1)
+{
+    while (this->m_set_count * c_shard_count * c_way_count < capacity)
+    {
+        this->m_set_count *= 2;
+    }
+
+    Entry empty;
+    empty.fingerprint = 0;
+    empty.hash = 0;
+    empty.lists = 0;
+    empty.used = false;
+    for (size_t i = 0; i < c_shard_count; ++i)
+    {
+        Shard& shard = this->m_shards[i];
+        int result = pthread_mutex_init(&shard.mutex, NULL);
+        assert(result == 0);
+        (void)result;
+        shard.entries.assign(this->m_set_count * c_way_count, empty);
+        shard.next_victim = 0;
+        shard.lookup_count = 0;
+        shard.hit_count = 0;
+    }
+}
+
+SharedSubstringMatchCache::~SharedSubstringMatchCache()
+{
+    for (size_t i = 0; i < c_shard_count; ++i)
+    {
+        pthread_mutex_destroy(&this->m_shards[i].mutex);
+    }
+}
+
+uint32_t SharedSubstringMatchCache::match(const SubstringMatcher* matcher, const char* text, size_t length)
+{
+    if (length > c_max_value_length)
+    {
+        return matcher->match(text, length);
+    }
+
+    uint64_t fingerprint = matcher->get_fingerprint();
+    uint32_t hash = hash_value(text, length);
+    // the low bits pick the shard, the next ones the set in it.
+    Shard& shard = this->m_shards[hash % c_shard_count];
+    Entry* set = &shard.entries[((hash / c_shard_count) & (this->m_set_count - 1)) * c_way_count];
+
+    pthread_mutex_lock(&shard.mutex);
+    ++shard.lookup_count;
+    for (size_t i = 0; i < c_way_count; ++i)
+    {
+        if (set[i].used && set[i].hash == hash && set[i].fingerprint == fingerprint && set[i].value.compare(0, string::npos, text, length) == 0)
+        {
+            uint32_t lists = set[i].lists;
+            ++shard.hit_count;
+            pthread_mutex_unlock(&shard.mutex);
+            return lists;
+        }
+    }
+
+    pthread_mutex_unlock(&shard.mutex);
+
+    // match out of the lock, another thread may insert the same value meanwhile, which is harmless.
+    uint32_t lists = matcher->match(text, length);
+
+    pthread_mutex_lock(&shard.mutex);
+    size_t way = 0;
+    while (way < c_way_count && set[way].used)
+    {
+        ++way;
+    }
+
+    if (way == c_way_count)
+    {
+        way = shard.next_victim++ % c_way_count;
+    }
+
+    set[way].fingerprint = fingerprint;
+    set[way].hash = hash;
+    set[way].lists = lists;
+    set[way].used = true;
+    set[way].value.assign(text, length);
+    pthread_mutex_unlock(&shard.mutex);
+    return lists;
+}
+
+void SharedSubstringMatchCache::clear()
+{
+    for (size_t i = 0; i < c_shard_count; ++i)
+    {
+        Shard& shard = this->m_shards[i];
+        pthread_mutex_lock(&shard.mutex);
+        for (size_t j = 0; j < shard.entries.size(); ++j)
+        {
+            shard.entries[j].used = false;
+        }
+
+        pthread_mutex_unlock(&shard.mutex);
+    }
+}
+
+uint64_t SharedSubstringMatchCache::get_lookup_count() const
+{
+    uint64_t count = 0;
+    for (size_t i = 0; i < c_shard_count; ++i)
+    {
+        Shard& shard = this->m_shards[i];
+        pthread_mutex_lock(&shard.mutex);
+        count += shard.lookup_count;
+        pthread_mutex_unlock(&shard.mutex);
+    }
+
+    return count;
+}
+
+uint64_t SharedSubstringMatchCache::get_hit_count() const
+{
+    uint64_t count = 0;
+    for (size_t i = 0; i < c_shard_count; ++i)
+    {
+        Shard& shard = this->m_shards[i];
+        pthread_mutex_lock(&shard.mutex);
+        count += shard.hit_count;
+        pthread_mutex_unlock(&shard.mutex);
+    }
+
+    return count;
+}
+
+static SharedSubstringMatchCache* s_process_cache = NULL;
+static pthread_once_t s_process_cache_once = PTHREAD_ONCE_INIT;
+
+static void create_process_cache()
+{
+    s_process_cache = new SharedSubstringMatchCache(65536);
+}
+
+SharedSubstringMatchCache& SharedSubstringMatchCache::get_process_cache()
+{
+    pthread_once(&s_process_cache_once, create_process_cache);
+    return *s_process_cache;
+}
+
+SubstringMatchCache::SubstringMatchCache(const SubstringMatcher* matcher, SharedSubstringMatchCache* shared) :
+    m_matcher(matcher), m_shared(shared), m_count(0), m_lookup_count(0), m_hit_count(0)
+{
+    assert(matcher != NULL);
+}
+
+void SubstringMatchCache::clear()
+{
+    // the slots are kept for the next document.
+    for (size_t i = 0; i < this->m_entries.size(); ++i)
+    {
+        this->m_entries[i].length = c_empty_slot;
+    }
+
+    this->m_values.clear();
+    this->m_count = 0;
+}
+
+void SubstringMatchCache::grow()
+{
+    vector<Entry> entries;
+    entries.swap(this->m_entries);
+    Entry empty = {0, 0, 0, c_empty_slot};
+    this->m_entries.assign(entries.empty() ? 64 : entries.size() * 2, empty);
+
+    size_t mask = this->m_entries.size() - 1;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].length != c_empty_slot)
+        {
+            size_t slot = entries[i].hash & mask;
+            while (this->m_entries[slot].length != c_empty_slot)
+            {
+                slot = (slot + 1) & mask;
+            }
+
+            this->m_entries[slot] = entries[i];
+        }
+    }
+}
+
+uint32_t SubstringMatchCache::match(const char* text, size_t length)
+{
+    // pages have no class or id on most nodes, it's not worth a lookup.
+    if (length == 0)
+    {
+        return this->m_matcher->match(text, 0);
+    }
+
+    ++this->m_lookup_count;
+    // at most half full.
+    if ((this->m_count + 1) * 2 > this->m_entries.size())
+    {
+        this->grow();
+    }
+
+    uint32_t hash = hash_value(text, length);
+    size_t mask = this->m_entries.size() - 1;
+    size_t slot = hash & mask;
+    while (this->m_entries[slot].length != c_empty_slot)
+    {
+        const Entry& entry = this->m_entries[slot];
+        if (entry.hash == hash && entry.length == length && memcmp(&this->m_values[entry.offset], text, length) == 0)
+        {
+            ++this->m_hit_count;
+            return entry.lists;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    Entry& entry = this->m_entries[slot];
+    entry.hash = hash;
+    entry.lists = this->m_shared != NULL ? this->m_shared->match(this->m_matcher, text, length) : this->m_matcher->match(text, length);
+    entry.offset = static_cast<uint32_t>(this->m_values.size());
+    entry.length = static_cast<uint32_t>(length);
+    this->m_values.insert(this->m_values.end(), text, text + length);
+    ++this->m_count;
+    return entry.lists;
+}
@@ -0,0 +1,172 @@
+#ifndef _SUBSTRING_MATCHER_H_
+#define _SUBSTRING_MATCHER_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+// aho-corasick automaton of up to 32 pattern lists, each one is a bit. one scan of a text
+// tells which lists have a pattern in it, the same as match_list(text, list, 2) >= 0
+// for every list, but the cost doesn't grow with the number of patterns.
+// the transitions are a dense table over the bytes which appear in the patterns.
+class SubstringMatcher
+{
+public:
+    SubstringMatcher();
+
+    // list is the bit reported by match when one of patterns is found,
+    // patterns are matched case sensitively.
+    void add_patterns(const std::vector<std::string>& patterns, uint32_t list);
+    // compile the patterns added, needed before match.
+    void build();
+
+    // the bits of the lists with a pattern in text.
+    uint32_t match(const char* text, size_t length) const;
+    uint32_t match(const char* text) const;
+
+    // hash of the patterns and their lists, matchers with the same one give the same answers.
+    uint64_t get_fingerprint() const
+    {
+        return this->m_fingerprint;
+    }
+
+private:
+    // the trie of the patterns, before build.
+    struct TrieNode
+    {
+        std::vector<std::pair<unsigned char, int32_t> > children;
+        uint32_t lists;
+    };
+
+    int32_t get_trie_child(int32_t node, unsigned char c) const;
+
+    std::vector<TrieNode> m_trie;
+    uint64_t m_fingerprint;
+    // all lists which have patterns, a scan stops once they are all found.
+    uint32_t m_all_lists;
+    bool m_built;
+
+    // byte to column of the table, column 0 for the bytes in no pattern.
+    uint16_t m_byte_classes[256];
+    int32_t m_class_count;
+    // next state of state s on a byte of class c is m_transitions[s * m_class_count + c].
+    std::vector<int32_t> m_transitions;
+    // lists matched when a state is reached, with the ones of its suffixes.
+    std::vector<uint32_t> m_outputs;
+};
+
+// memo of SubstringMatcher::match shared by the threads of a process, for the values which
+// repeat across the pages of a site. entries are keyed by the fingerprint of the matcher
+// as well, so matchers of different patterns share one cache, and the answers of old
+// patterns are never given once a matcher is configured again.
+// the cache is split in shards of their own lock, and a shard is a set associative table
+// which evicts entries round robin, so it never holds more than the capacity.
+class SharedSubstringMatchCache
+{
+public:
+    // capacity is rounded up to a power of 2.
+    explicit SharedSubstringMatchCache(size_t capacity);
+    ~SharedSubstringMatchCache();
+
+    // matcher->match(text, length), from the cache if a thread did it before.
+    uint32_t match(const SubstringMatcher* matcher, const char* text, size_t length);
+
+    void clear();
+
+    uint64_t get_lookup_count() const;
+    uint64_t get_hit_count() const;
+
+    // the cache of the process, created on first use and never deleted.
+    static SharedSubstringMatchCache& get_process_cache();
+
+private:
+    struct Entry
+    {
+        uint64_t fingerprint;
+        uint32_t hash;
+        uint32_t lists;
+        bool used;
+        std::string value;
+    };
+
+    struct Shard
+    {
+        pthread_mutex_t mutex;
+        std::vector<Entry> entries;
+        // the way replaced by the next insert in a full set.
+        uint32_t next_victim;
+        uint64_t lookup_count;
+        uint64_t hit_count;
+    };
+
+    static const size_t c_shard_count = 16;
+    static const size_t c_way_count = 4;
+    // longer values are not worth keeping, they rarely repeat.
+    static const size_t c_max_value_length = 256;
+
+    // not copyable, shards own their mutexes.
+    SharedSubstringMatchCache(const SharedSubstringMatchCache&);
+    SharedSubstringMatchCache& operator=(const SharedSubstringMatchCache&);
+
+    // the counters are read under the locks as well.
+    mutable Shard m_shards[c_shard_count];
+    size_t m_set_count;
+};
+
+// memo of SubstringMatcher::match for the values of one document, where the same
+// values repeat a lot, like the class names of a page. values are copied, so they
+// don't need to outlive the cache. clear it between documents.
+// values missed are looked up in shared if given, before they are matched.
+class SubstringMatchCache
+{
+public:
+    SubstringMatchCache(const SubstringMatcher* matcher, SharedSubstringMatchCache* shared = NULL);
+
+    uint32_t match(const char* text, size_t length);
+
+    uint32_t match(const char* text)
+    {
+        return this->match(text, strlen(text));
+    }
+
+    void clear();
+
+    // lookups of non empty values, and the ones found in the cache.
+    uint64_t get_lookup_count() const
+    {
+        return this->m_lookup_count;
+    }
+
+    uint64_t get_hit_count() const
+    {
+        return this->m_hit_count;
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t hash;
+        uint32_t lists;
+        // the value is m_values[offset, offset + length), length is c_empty_slot if the entry is free.
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    static const uint32_t c_empty_slot = 0xFFFFFFFF;
+
+    void grow();
+
+    const SubstringMatcher* m_matcher;
+    SharedSubstringMatchCache* m_shared;
+    // open addressing with linear probing, the size is a power of 2.
+    std::vector<Entry> m_entries;
+    std::vector<char> m_values;
+    size_t m_count;
+    uint64_t m_lookup_count;
+    uint64_t m_hit_count;
+};
+
+#endif
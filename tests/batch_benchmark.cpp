@@ -0,0 +1,103 @@
+#include "batch_processor.h"
+#include "body_extractor.h"
+#include "list_page_classifier.h"
+#include "stage_stats.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+// throughput of BatchProcessor on the fixture pages with 1, 2, 4... threads up to the cpus.
+// usage: batch_benchmark [copies] [files...]
+
+static const char* c_url = "http://www.google.com/w/a/b/c?q=1";
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+    int copies = argc > 1 ? atoi(argv[1]) : 50;
+    vector<string> pages;
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            pages.push_back(read_file(argv[i]));
+        }
+    }
+    else
+    {
+        pages.push_back(read_file("sina.html"));
+        pages.push_back(read_file("news.ori.html"));
+    }
+
+    BodyExtractor extractor;
+    ListPageClassifier classifier;
+    if (!extractor.init("../body_extractor.ini") || !classifier.init("list_page_classifier_test.ini"))
+    {
+        printf("init failed\n");
+        return 1;
+    }
+
+    // the batch is copies of every page.
+    size_t bytes = 0;
+    vector<BatchDocument> documents;
+    for (int i = 0; i < copies; ++i)
+    {
+        for (size_t j = 0; j < pages.size(); ++j)
+        {
+            documents.push_back(BatchDocument(pages[j].data(), pages[j].size(), c_url));
+            bytes += pages[j].size();
+        }
+    }
+
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    double single_seconds = 0;
+    for (int thread_count = 1; thread_count <= (cpu_count > 1 ? cpu_count : 1); thread_count *= 2)
+    {
+        BatchProcessor processor(&extractor, &classifier, thread_count);
+        vector<BatchResult> results;
+        // the first batch warms the arenas of the threads.
+        processor.process(documents, results);
+
+        double start = now();
+        processor.process(documents, results);
+        double seconds = now() - start;
+        if (thread_count == 1)
+        {
+            single_seconds = seconds;
+        }
+
+        printf("%3d threads %8.1f docs/s %8.1f MB/s  speedup %5.2f\n", thread_count, documents.size() / seconds,
+            bytes / (1024.0 * 1024.0) / seconds, single_seconds / seconds);
+    }
+
+    // where the time of all the batches went, per document.
+    StageSnapshot snapshot;
+    snapshot.take();
+    string stages;
+    snapshot.write(stages);
+    printf("\n%s", stages.c_str());
+
+    return 0;
+}
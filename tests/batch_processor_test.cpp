@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include "batch_processor.h"
+#include "body_extractor.h"
+#include "list_page_classifier.h"
+#include "html_parser.h"
+#include "dom_tree.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* c_url = "http://www.google.com/w/a/b/c?q=1";
+
+static string read_page(const char* file_name)
+{
+    ifstream file(file_name);
+    stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+class BatchProcessorTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_TRUE(this->m_extractor.init("../body_extractor.ini"));
+        ASSERT_TRUE(this->m_classifier.init("list_page_classifier_test.ini"));
+        this->m_pages.push_back(read_page("sina.html"));
+        this->m_pages.push_back(read_page("news.ori.html"));
+        this->m_pages.push_back("");
+        this->m_pages.push_back("<html><body><p>short</p></body></html>");
+
+        // results of the one document calls.
+        HtmlParser parser;
+        for (size_t i = 0; i < this->m_pages.size(); ++i)
+        {
+            BatchResult expected;
+            DomNode* dom = parser.parse(this->m_pages[i]);
+            if (dom != NULL)
+            {
+                expected.parsed = true;
+                expected.is_list_page = this->m_classifier.classify(dom, c_url);
+                DomNode* body = this->m_extractor.extract(dom);
+                if (body != NULL)
+                {
+                    expected.has_body = true;
+                    serialize_html(body, expected.body_html);
+                }
+
+                delete dom;
+            }
+
+            this->m_expected.push_back(expected);
+        }
+
+        EXPECT_TRUE(this->m_expected[0].has_body);
+        EXPECT_FALSE(this->m_expected[2].parsed);
+    }
+
+    void expect_results(const vector<BatchResult>& results, size_t count)
+    {
+        ASSERT_EQ(count, results.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const BatchResult& expected = this->m_expected[i % this->m_expected.size()];
+            EXPECT_EQ(expected.parsed, results[i].parsed) << i;
+            EXPECT_EQ(expected.is_list_page, results[i].is_list_page) << i;
+            EXPECT_EQ(expected.has_body, results[i].has_body) << i;
+            EXPECT_EQ(expected.body_html, results[i].body_html) << i;
+        }
+    }
+
+    BodyExtractor m_extractor;
+    ListPageClassifier m_classifier;
+    vector<string> m_pages;
+    vector<BatchResult> m_expected;
+};
+
+TEST_F(BatchProcessorTest, documents)
+{
+    BatchProcessor processor(&this->m_extractor, &this->m_classifier, 3);
+    EXPECT_EQ(3, processor.get_thread_count());
+
+    // more documents than threads, the results are in the input order.
+    vector<BatchDocument> documents;
+    for (size_t i = 0; i < 5 * this->m_pages.size(); ++i)
+    {
+        const string& page = this->m_pages[i % this->m_pages.size()];
+        documents.push_back(BatchDocument(page.data(), page.size(), c_url));
+    }
+
+    vector<BatchResult> results;
+    processor.process(documents, results);
+    expect_results(results, documents.size());
+
+    // the threads wait for the next batch.
+    documents.resize(2);
+    processor.process(documents, results);
+    expect_results(results, 2);
+
+    documents.clear();
+    processor.process(documents, results);
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(BatchProcessorTest, doms)
+{
+    HtmlParser parser;
+    vector<const DomNode*> doms;
+    vector<const char*> urls;
+    vector<string> before;
+    for (size_t i = 0; i < 3 * this->m_pages.size(); ++i)
+    {
+        const DomNode* dom = parser.parse(this->m_pages[i % this->m_pages.size()]);
+        doms.push_back(dom);
+        urls.push_back(c_url);
+        before.push_back("");
+        if (dom != NULL)
+        {
+            serialize_html(dom, before.back());
+        }
+    }
+
+    BatchProcessor processor(&this->m_extractor, &this->m_classifier, 2);
+    vector<BatchResult> results;
+    processor.process(doms, urls, results);
+    expect_results(results, doms.size());
+
+    // the trees are left as they were.
+    for (size_t i = 0; i < doms.size(); ++i)
+    {
+        if (doms[i] != NULL)
+        {
+            string after;
+            serialize_html(doms[i], after);
+            EXPECT_EQ(before[i], after) << i;
+            delete doms[i];
+        }
+    }
+}
+
+TEST_F(BatchProcessorTest, documents_and_doms)
+{
+    // buffers go through the tree extraction and trees through the flat one, the results
+    // are the same. the last page has a struct node in its body which is not a candidate.
+    vector<string> pages(this->m_pages);
+    string paragraph = "<p>";
+    for (int i = 0; i < 10; ++i)
+    {
+        paragraph += "This is a long sentence of the article, with commas, and more words. ";
+    }
+
+    paragraph += "</p>";
+    pages.push_back("<html><body><div>" + paragraph + paragraph + paragraph +
+        "<p>short.<span><div class=\"article\"><img src=x></div></span></p></div></body></html>");
+
+    HtmlParser parser;
+    vector<BatchDocument> documents;
+    vector<const DomNode*> doms;
+    vector<const char*> urls;
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        documents.push_back(BatchDocument(pages[i].data(), pages[i].size(), c_url));
+        doms.push_back(parser.parse(pages[i]));
+        urls.push_back(c_url);
+    }
+
+    BatchProcessor processor(&this->m_extractor, &this->m_classifier, 2);
+    vector<BatchResult> document_results;
+    vector<BatchResult> dom_results;
+    processor.process(documents, document_results);
+    processor.process(doms, urls, dom_results);
+    ASSERT_EQ(pages.size(), document_results.size());
+    ASSERT_EQ(pages.size(), dom_results.size());
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        EXPECT_EQ(document_results[i].parsed, dom_results[i].parsed) << i;
+        EXPECT_EQ(document_results[i].is_list_page, dom_results[i].is_list_page) << i;
+        EXPECT_EQ(document_results[i].has_body, dom_results[i].has_body) << i;
+        EXPECT_EQ(document_results[i].body_html, dom_results[i].body_html) << i;
+        delete doms[i];
+    }
+
+    EXPECT_TRUE(dom_results.back().has_body);
+    EXPECT_NE(string::npos, dom_results.back().body_html.find("article"));
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -3,326 +3,529 @@
 #include <map>
 #include <vector>
 #include "gtest/gtest.h"
-#include "python2.6/Python.h"
 
 #include "body_extractor.h"
+#include "list_page_classifier.h"
+#include "html_parser.h"
+#include "dom_arena.h"
+#include "stage_stats.h"
 
 using namespace std;
 
-class PythonWrapper
+void print_dom(DomNode* node, stringstream& text)
 {
-public:
-    PythonWrapper() :
-        _initialized(false)
+    const char* parent_tag = node->get_parent() != NULL ? node->get_parent()->get_tag() : "NULL";
+    text << node->get_tag() << "," << parent_tag << "," << node->get_text() << "," << (int)node->get_children()->size() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
     {
+        print_dom((*node->get_children())[i], text);
     }
+}
 
-    ~PythonWrapper()
+void read_file(const char* file_name, stringstream& output)
+{
+    ifstream file(file_name);
+    if (file.is_open())
     {
-        if (this->_initialized)
+        string line;
+        while (file.good())
         {
-            for (map<const char*, PyObject*>::iterator iter = this->_modules.begin(); iter != this->_modules.end(); ++iter)
-            {
-                Py_DECREF(iter->second);
-            }
-
-            Py_Finalize();
+            getline(file, line);
+            output << line << '\n';
         }
+
+        file.close();
     }
+}
 
-    bool init()
+void write_file(const char* file_name, const char* body_str)
+{
+    ofstream file(file_name);
+    if (file.is_open())
     {
-        assert(!this->_initialized);
-
-        Py_Initialize();
-        if (!Py_IsInitialized())
-        {
-            cout << "python init failed" << endl;
-            return false;
-        }
-
-        PyRun_SimpleString("import sys");
-        PyRun_SimpleString("sys.path.append('./')");
+        file << body_str;
+        file.close();
+    }
+}
 
+void test_file(const string& html)
+{
+    // build dom tree with the native html parser, the whole document lives in the arena.
+    DomArena& arena = DomArena::get_thread_arena();
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html.data(), html.size(), arena);
+    ASSERT_TRUE(dom != NULL);
 
-        this->_initialized = true;
-        return true;
-    }
+    // init body extractor
+    BodyExtractor extractor;
+    // init.
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
 
-    bool import_module(const char* module_name)
+    // extract dom
+    DomNode* body = extractor.extract(dom);
+    EXPECT_TRUE(body != NULL);
+    if (body != NULL)
     {
-        PyObject* module = PyImport_ImportModule(module_name);
-        if (!module)
-        {
-            cout << "import module failed" << endl;
-            return false;
-        }
+        cout << "body result " << body->get_tag() << " " << body->get_attribute("class") << " " << body->get_attribute("id") << endl;
+        string body_str;
+        serialize_html(body, body_str);
+        write_file("news.out.html", body_str.c_str());
+    }
 
-        PyObject* dict = PyModule_GetDict(module);
-        if (!dict)
-        {
-            cout << "get module dict failed" << endl;
-            return false;
-        }
+    stringstream text;
+    print_dom(dom, text);
+    arena.reset();
+}
 
-        this->_modules[module_name] = dict;
-        return true;
+void print_nodes(const DomNode* node, stringstream& text)
+{
+    text << node->get_tag() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        print_nodes((*node->get_children())[i], text);
     }
+}
 
-    bool print_dict(PyObject* dict)
+void print_kept_nodes(const FlatDom& dom, int32_t body, const FlatDomMask& kept, stringstream& text)
+{
+    for (int32_t i = body; i < dom.get_subtree_end(body); ++i)
     {
-        if (!PyDict_Check(dict))
+        if (kept.contains(i))
         {
-            cout << "invalid dict" << endl;
-            return false;
+            text << dom.get_tag(i) << "," << dom.get_node(i)->get_attribute("class") << "," << dom.get_node(i)->get_attribute("id") << endl;
         }
-
-        PyObject* keys = PyDict_Keys(dict);
-        for (int i = 0; i < PyList_GET_SIZE(keys); ++i)
-        {
-            PyObject* k = PyList_GET_ITEM(keys, i);
-            char* value = PyString_AsString(k);
-            Py_DECREF(k);
-            cout << value << endl;
-        }
-
-        Py_DECREF(keys);
-        return true;
     }
+}
 
-    const char* invoke(const char* module_name, const char* func_name, PyObject* param)
-    {
-        PyGILState_STATE gstate = PyGILState_Ensure();
-        PyObject* func = PyDict_GetItemString(this->_modules[module_name], func_name);
-        if (!func)
-        {
-            return "";
-        }
+void test_flat_file(const string& html)
+{
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
 
-        PyObject* result = PyObject_CallFunctionObjArgs(func, param, NULL);
-        
-        PyGILState_Release(gstate);
-        //Py_DECREF(func);
-        return PyString_AsString(result);
-    }
+    // the tree path modifies its dom, so the flat one is built from another parse.
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+    DomNode* flat_source = parser.parse(html);
+    ASSERT_TRUE(flat_source != NULL);
 
-    bool invoke_string(const char* module_name, const char* func_name, const string& text, PyObject*& result)
-    {
-        PyObject* func = PyDict_GetItemString(this->_modules[module_name], func_name);
-        if (!func)
-        {
-            return false;
-        }
+    string source_html;
+    serialize_html(flat_source, source_html);
 
-        PyObject* param = PyString_FromStringAndSize(text.data(), text.size());
+    FlatDom flat_dom;
+    FlatDomMask kept;
+    int32_t flat_body = extractor.extract(flat_source, flat_dom, kept);
+    ASSERT_EQ(flat_dom.size(), kept.size());
 
-        result = PyObject_CallFunctionObjArgs(func, param, NULL);
+    DomNode* body = extractor.extract(dom);
+    ASSERT_TRUE(body != NULL);
+    ASSERT_GE(flat_body, 0);
+    ASSERT_TRUE(kept.contains(flat_body));
+
+    // the same nodes are kept under the body.
+    stringstream expected, actual;
+    print_nodes(body, expected);
+    print_kept_nodes(flat_dom, flat_body, kept, actual);
+    EXPECT_EQ(expected.str(), actual.str());
+
+    // and written the same.
+    string expected_html, actual_html;
+    serialize_html(body, expected_html);
+    serialize_html(flat_dom, flat_body, kept, actual_html);
+    EXPECT_EQ(expected_html, actual_html);
+
+    // the source tree is not modified.
+    EXPECT_EQ(flat_source, flat_dom.get_node(0));
+    string unchanged_html;
+    serialize_html(flat_source, unchanged_html);
+    EXPECT_EQ(source_html, unchanged_html);
 
-        //Py_DECREF(func);
-        //Py_DECREF(param);
-        return true;
-    }
+    delete dom;
+    delete flat_source;
+}
 
-    PyObject* invoke_object(PyObject* obj, const char* func_name)
+// a page whose body has a struct node which is not a candidate, with a good class.
+static string nested_good_class_page()
+{
+    string paragraph = "<p>";
+    for (int i = 0; i < 10; ++i)
     {
-        return PyObject_CallMethod(obj, (char*)(func_name), NULL);
+        paragraph += "This is a long sentence of the article, with commas, and more words. ";
     }
 
-    const char* get_attr_string(PyObject* obj, const char* attr_name)
-    {
-        PyGILState_STATE gstate = PyGILState_Ensure();
-        PyObject* attr = PyObject_GetAttrString(obj, attr_name);
-        if (attr == NULL)
-        {
-            return "";
-        }
+    paragraph += "</p>";
+    return "<html><body><div>" + paragraph + paragraph + paragraph +
+        "<p>short.<span><div class=\"article\"><img src=x></div></span></p></div></body></html>";
+}
 
-        char* attr_value = PyString_AsString(attr);
-        PyGILState_Release(gstate);
-        //Py_DECREF(attr);
-        return attr_value;
+TEST(BodyExtractor, flat)
+{
+    const char* file_names[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(file_names) / sizeof(file_names[0]); ++i)
+    {
+        stringstream text;
+        read_file(file_names[i], text);
+        test_flat_file(text.str());
     }
 
-public:
-    bool _initialized;
-    map<const char*, PyObject*> _modules;
-};
-
-PythonWrapper python;
+    // a struct node in the body which is not a candidate and has a negative class weight
+    // if it were scored.
+    test_flat_file(nested_good_class_page());
+}
 
-PyObject* tag_type = NULL;
+// a page where the parent of the first paragraph ties with the parent of the second one,
+// which is in it and comes first in postorder. the empty links zero the paragraphs, and set
+// the link node densities of the sections to 3/4 and 1/2:
+// 0.5 * (48 + 2 + 26) * (1 - 0.75) == (0.5 * (2 + 26) + 2.5 * 2) * (1 - 0.5).
+static string tied_ancestors_page()
+{
+    return "<html><body><section><p>" + string(48, 'a') + "<a></a></p><section>bb<p>" + string(26, 'b') +
+        "<a></a></p><span></span></section><a></a></section><a></a><a></a><a></a><p>x</p></body></html>";
+}
 
-const char* get_dom_attr(PyObject* node, const char* attr_name)
+TEST(BodyExtractor, flat_tied_ancestors)
 {
-    PyObject* attr = PyObject_GetAttrString(node, "attrib");
-    if (attr == NULL)
-    {
-        return "";
-    }
+    // the outer section, promoted first, wins the tie in both paths, so the body is the body tag.
+    string html = tied_ancestors_page();
+    test_flat_file(html);
 
-    PyObject* result = PyObject_CallMethod(attr, (char*)"get", (char*)"ss", attr_name, "");
-    if (result == NULL)
-    {
-        return "";
-    }
-    else
-    {
-        return PyString_AsString(result);
-    }
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+    DomNode* body = extractor.extract(dom);
+    ASSERT_TRUE(body != NULL);
+    EXPECT_STREQ("body", body->get_tag());
+    delete dom;
 }
 
-// build dom tree from python lxml dom tree.
-DomNode* build_dom_tree(DomNode* parent, PyObject* node, map<DomNode*, PyObject*>& relation)
+TEST(BodyExtractor, flat_nested_good_class)
 {
-    const char* tag = python.get_attr_string(node, "tag");
-    const char* inner_text = python.get_attr_string(node, "text");
-    const char* inner_tail = python.get_attr_string(node, "tail");
-    string text;
-    if (inner_text != NULL)
-    {
-        text.append(inner_text);
-    }
+    // the class weight of the div is not scored by either path, so both keep it.
+    string html = nested_good_class_page();
+    test_flat_file(html);
 
-    if (inner_tail != NULL)
-    {
-        if (parent != NULL)
-        {
-            parent->append_text(inner_tail);
-        }
-    }
-
-    DomNode* dom_node = new DomNode(tag, text);
-    relation[dom_node] = node;
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+    FlatDom flat_dom;
+    FlatDomMask kept;
+    int32_t body = extractor.extract(dom, flat_dom, kept);
+    ASSERT_GE(body, 0);
+    string body_html;
+    serialize_html(flat_dom, body, kept, body_html);
+    EXPECT_NE(string::npos, body_html.find("class=\"article\"")) << body_html;
+    delete dom;
+}
 
-    //PyObject* parent = python.invoke_object(node, "getparent");
-    FILE* fp = fopen("object.txt", "w+");
-    PyObject_Print(node, fp, Py_PRINT_RAW);
-    fclose(fp);
-    PyObject* children = python.invoke_object(node, "getchildren");
-    if (children != NULL)
+// counts the nodes entered by the extraction traversal.
+class TagCountVisitor : public DomTreeVisitor
+{
+public:
+    virtual bool preprocess(DomNode* node)
     {
-        int count = PyList_GET_SIZE(children);
-        for (int i = 0; i < count; ++i)
-        {
-            PyObject* child = PyList_GET_ITEM(children, i);
-            if (PyObject_IsInstance(child, tag_type) != 1)
-            {
-                continue;
-            }
-
-            DomNode* child_node = build_dom_tree(dom_node, child, relation);
-            dom_node->append_child(child_node);
-        }
+        ++this->counts[node->get_tag()];
+        return true;
     }
 
-    dom_node->add_attribute("class", get_dom_attr(node, "class"));
-    dom_node->add_attribute("id", get_dom_attr(node, "id"));
+    map<string, int> counts;
+};
 
-    return dom_node;
+TEST(BodyExtractor, fused)
+{
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    stringstream text;
+    read_file("sina.html", text);
+    HtmlParser parser;
+    DomNode* dom = parser.parse(text.str());
+    ASSERT_TRUE(dom != NULL);
+    DomNode* fused_dom = parser.parse(text.str());
+    ASSERT_TRUE(fused_dom != NULL);
+
+    // the same body with another visitor in the traversal.
+    TagCountVisitor visitor;
+    DomNode* body = extractor.extract(dom);
+    DomNode* fused_body = extractor.extract(fused_dom, visitor);
+    ASSERT_TRUE(body != NULL);
+    ASSERT_TRUE(fused_body != NULL);
+    stringstream expected, actual;
+    print_nodes(body, expected);
+    print_nodes(fused_body, actual);
+    EXPECT_EQ(expected.str(), actual.str());
+
+    // the visitor sees the negative nodes too, they are unlinked after their subtree.
+    EXPECT_GT(visitor.counts["div"], 0);
+    EXPECT_GT(visitor.counts["script"], 0);
+    EXPECT_GT(visitor.counts["style"], 0);
+    TagCountVisitor body_visitor;
+    fused_body->preorder_traverse(body_visitor);
+    EXPECT_EQ(0, body_visitor.counts["script"]);
+
+    delete dom;
+    delete fused_dom;
 }
 
-void print_dom(DomNode* node, stringstream& text)
+TEST(BodyExtractor, fused_list_page_features)
 {
-    const char* parent_tag = node->get_parent() != NULL ? node->get_parent()->get_tag() : "NULL";
-    text << node->get_tag() << "," << parent_tag << "," << node->get_text() << "," << (int)node->get_children()->size() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
-    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    ListPageClassifier classifier;
+    ASSERT_TRUE(classifier.init("list_page_classifier_test.ini"));
+    const char* url = "http://news.sina.com.cn/c/2012-01-01/123.shtml";
+
+    const char* file_names[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(file_names) / sizeof(file_names[0]); ++i)
     {
-        print_dom((*node->get_children())[i], text);
+        stringstream text;
+        read_file(file_names[i], text);
+        HtmlParser parser;
+        DomNode* dom = parser.parse(text.str());
+        ASSERT_TRUE(dom != NULL);
+        DomNode* fused_dom = parser.parse(text.str());
+        ASSERT_TRUE(fused_dom != NULL);
+
+        // the features of the walk shared with the extraction are the ones of the whole page.
+        ListPageClassifier::FeatureVisitor visitor(&classifier);
+        DomTraversalStack stack;
+        DomTreeTraversal<ListPageClassifier::FeatureVisitor>::preorder(dom, visitor, stack);
+        ListPageClassifier::FeatureVisitor fused_visitor(&classifier);
+        EXPECT_TRUE(extractor.extract(fused_dom, fused_visitor) != NULL);
+        EXPECT_EQ(visitor.get_features(), fused_visitor.get_features()) << file_names[i];
+        EXPECT_EQ(classifier.classify(dom, url), classifier.classify(fused_visitor, url)) << file_names[i];
+
+        delete dom;
+        delete fused_dom;
     }
 }
 
-const char* module = "lxml.html";
+TEST(BodyExtractor, class_id_cache)
+{
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    uint64_t lookup_count = 0;
+    uint64_t hit_count = 0;
+    extractor.get_class_id_cache_stats(lookup_count, hit_count);
+    EXPECT_EQ(0u, lookup_count);
 
+    stringstream text;
+    read_file("sina.html", text);
+    HtmlParser parser;
+    DomNode* dom = parser.parse(text.str());
+    ASSERT_TRUE(dom != NULL);
+    extractor.extract(dom);
+    delete dom;
 
-map<DomNode*, PyObject*> dom_relation;
+    // class names repeat a lot in a page.
+    extractor.get_class_id_cache_stats(lookup_count, hit_count);
+    EXPECT_GT(lookup_count, 0u);
+    EXPECT_GT(hit_count, 0u);
+    EXPECT_LE(hit_count, lookup_count);
+}
 
-void node_dropped(DomNode* node)
+TEST(BodyExtractor, stage_stats)
 {
-    map<DomNode*, PyObject*>::iterator iter = dom_relation.find(node);
-    if (iter != dom_relation.end())
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    stringstream text;
+    read_file("sina.html", text);
+    HtmlParser parser;
+    DomNode* dom = parser.parse(text.str());
+    ASSERT_TRUE(dom != NULL);
+
+    StageSnapshot before;
+    before.take();
+    ASSERT_TRUE(extractor.extract(dom) != NULL);
+    StageSnapshot tree;
+    tree.take();
+    tree.subtract(before);
+
+    DomNode* flat_source = parser.parse(text.str());
+    ASSERT_TRUE(flat_source != NULL);
+    FlatDom flat_dom;
+    FlatDomMask kept;
+    before.take();
+    ASSERT_GE(extractor.extract(flat_source, flat_dom, kept), 0);
+    StageSnapshot flat;
+    flat.take();
+    flat.subtract(before);
+
+    StageMetric tree_stages[] = {STAGE_EXTRACT, STAGE_TRAVERSE, STAGE_GET_BODY, STAGE_SANITIZE, COUNT_NODES, COUNT_CANDIDATES};
+    for (size_t i = 0; i < sizeof(tree_stages) / sizeof(tree_stages[0]); ++i)
     {
-        PyObject* py_node = iter->second;
-        python.invoke_object(py_node, "drop_tree");
+        EXPECT_EQ(1u, tree.get_count(tree_stages[i])) << StageSnapshot::get_metric_name(tree_stages[i]);
+        EXPECT_EQ(1u, flat.get_count(tree_stages[i])) << StageSnapshot::get_metric_name(tree_stages[i]);
     }
+
+    EXPECT_EQ(0u, tree.get_count(STAGE_FLAT_BUILD));
+    EXPECT_EQ(1u, flat.get_count(STAGE_FLAT_BUILD));
+    EXPECT_EQ(1u, flat.get_count(STAGE_PROMOTE));
+    EXPECT_EQ(1u, flat.get_count(STAGE_SCORE));
+    // both walk the nodes left after the drops and score the same candidates.
+    EXPECT_GT(tree.get_sum(COUNT_NODES), tree.get_sum(COUNT_CANDIDATES));
+    EXPECT_EQ(tree.get_sum(COUNT_NODES), flat.get_sum(COUNT_NODES));
+    EXPECT_EQ(tree.get_sum(COUNT_CANDIDATES), flat.get_sum(COUNT_CANDIDATES));
+    EXPECT_GE(tree.get_sum(STAGE_EXTRACT), tree.get_sum(STAGE_TRAVERSE) + tree.get_sum(STAGE_GET_BODY) + tree.get_sum(STAGE_SANITIZE));
+
+    delete dom;
+    delete flat_source;
 }
 
-void read_file(const char* file_name, stringstream& output)
+// counts of the events of the last document recorded by the thread.
+static void count_flight_events(vector<int>& counts)
 {
-    ifstream file(file_name);
-    if (file.is_open())
+    vector<FlightEvent> events;
+    FlightRecorder::get_thread_recorder().get_events(events);
+    counts.assign(FLIGHT_EVENT_TYPE_COUNT, 0);
+    for (size_t i = 0; i < events.size(); ++i)
     {
-        string line;
-        while (file.good())
+        if (events[i].document == events.back().document)
         {
-            getline(file, line);
-            output << line << '\n';
+            ++counts[events[i].type];
         }
-
-        file.close();
     }
 }
 
-void write_file(const char* file_name, const char* body_str)
+TEST(BodyExtractor, flight_recorder)
 {
-    ofstream file(file_name);
-    if (file.is_open())
+    BodyExtractor extractor;
+    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    stringstream text;
+    read_file("sina.html", text);
+    HtmlParser parser;
+    DomNode* dom = parser.parse(text.str());
+    ASSERT_TRUE(dom != NULL);
+    DomNode* flat_source = parser.parse(text.str());
+    ASSERT_TRUE(flat_source != NULL);
+
+    ASSERT_TRUE(extractor.extract(dom) != NULL);
+    vector<int> tree_counts;
+    count_flight_events(tree_counts);
+
+    FlatDom flat_dom;
+    FlatDomMask kept;
+    ASSERT_GE(extractor.extract(flat_source, flat_dom, kept), 0);
+    vector<int> flat_counts;
+    count_flight_events(flat_counts);
+
+    // the same decisions, in another order.
+    EXPECT_EQ(1, tree_counts[FLIGHT_DOCUMENT]);
+    EXPECT_EQ(1, tree_counts[FLIGHT_BEST]);
+    EXPECT_EQ(1, tree_counts[FLIGHT_BODY]);
+    EXPECT_EQ(1, tree_counts[FLIGHT_DONE]);
+    EXPECT_GT(tree_counts[FLIGHT_DROP], 0);
+    EXPECT_GT(tree_counts[FLIGHT_CANDIDATE], 0);
+    for (int i = 0; i < FLIGHT_EVENT_TYPE_COUNT; ++i)
     {
-        file << body_str;
-        file.close();
+        EXPECT_EQ(tree_counts[i], flat_counts[i]) << FlightRecorder::get_event_type_name(static_cast<FlightEventType>(i));
     }
+
+    delete dom;
+    delete flat_source;
 }
 
-void test_file(const string& html)
+class BodyExtractorTest : public ::testing::Test
 {
-    PyObject* py_dom = NULL;
-    if (!python.invoke_string(module, "fromstring", html, py_dom))
+protected:
+    // a section > span > p, p tree, where the paragraphs have enough text to be valid.
+    virtual void SetUp()
     {
-        EXPECT_TRUE(false);
+        EXPECT_TRUE(this->m_extractor.init("../body_extractor.ini"));
+        this->m_dom = this->m_parser.parse("<html><body><section><span><p>first</p><p>second</p></span></section></body></html>");
+        ASSERT_TRUE(this->m_dom != NULL);
+        vector<DomNode*> nodes;
+        this->m_dom->find_tags("p", nodes);
+        ASSERT_EQ(2u, nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            nodes[i]->set_extra(BodyExtractor::FN_TEXT_LENGTH, 100);
+        }
+
+        this->m_paragraph = nodes[1];
+        this->m_span = this->m_paragraph->get_parent();
+        this->m_section = this->m_span->get_parent();
+        this->m_span->set_extra(BodyExtractor::FN_TEXT_LENGTH, 200);
+        this->m_section->set_extra(BodyExtractor::FN_TEXT_LENGTH, 200);
+        this->m_section->get_parent()->set_extra(BodyExtractor::FN_TEXT_LENGTH, 200);
     }
 
-    // build dom tree from python lxml dom tree.
-    DomNode* dom = build_dom_tree(NULL, py_dom, dom_relation);
-    // get html text of dom tree by call python lxml tostring method.
-    const char* body_str = python.invoke(module, "tostring", dom_relation[dom]);
-    // write.
-    write_file("news.ori.html", body_str);
+    virtual void TearDown()
+    {
+        delete this->m_dom;
+    }
 
-    // init body extractor
-    BodyExtractor extractor;
-    // init.
-    EXPECT_TRUE(extractor.init("../body_extractor.ini"));
+    int get_candidate_source(bool include_parent, bool include_grand_parent, DomNode* node)
+    {
+        this->m_extractor._include_parent_node_enabled = include_parent;
+        this->m_extractor._include_grand_parent_node_enabled = include_grand_parent;
+        return this->m_extractor.get_candidate_source(node);
+    }
 
-    // extract dom
-    DomNode* body = extractor.extract(dom);
-    EXPECT_TRUE(body != NULL);
-    if (body != NULL)
+    // the text length in bytes, and the code point, comma and stop counts of the subtree of node.
+    void get_text_features(const DomNode* node, double& text_length, double& char_count, double& comma_count, double& stop_count)
     {
-        cout << "body result " << body->get_tag() << " " << body->get_attribute("class") << " " << body->get_attribute("id") << endl;
-        FILE* fp = fopen("object.txt", "w+");
-        PyObject_Print(py_dom, fp, Py_PRINT_RAW);
-        fclose(fp);
-        const char* body_str = python.invoke(module, "tostring", dom_relation[body]);
-        write_file("news.out.html", body_str);
+        text_length = node->get_extra(BodyExtractor::FN_TEXT_LENGTH);
+        char_count = node->get_extra(BodyExtractor::FN_CHAR_COUNT);
+        comma_count = node->get_extra(BodyExtractor::FN_COMMA_COUNT);
+        stop_count = node->get_extra(BodyExtractor::FN_STOP_COUNT);
     }
 
-    stringstream text;
-    print_dom(dom, text);
-    dom_relation.clear();
-    delete dom;
-}
+    BodyExtractor m_extractor;
+    HtmlParser m_parser;
+    DomNode* m_dom;
+    DomNode* m_paragraph;
+    DomNode* m_span;
+    DomNode* m_section;
+};
 
-TEST(BodyExtractor, main)
+TEST_F(BodyExtractorTest, get_candidate_source)
 {
-    EXPECT_TRUE(python.init());
-    EXPECT_TRUE(python.import_module(module));
-    //EXPECT_TRUE(python.print_dict(python._modules[module]));
+    // every ancestor is selected once, whatever the count of its valid descendants.
+    EXPECT_EQ(0, get_candidate_source(true, true, this->m_paragraph));
+    EXPECT_EQ(1, get_candidate_source(true, true, this->m_span));
+    EXPECT_EQ(2, get_candidate_source(true, true, this->m_section));
+    EXPECT_EQ(-1, get_candidate_source(true, true, this->m_section->get_parent()));
+
+    EXPECT_EQ(1, get_candidate_source(true, false, this->m_span));
+    EXPECT_EQ(-1, get_candidate_source(true, false, this->m_section));
+
+    EXPECT_EQ(-1, get_candidate_source(false, true, this->m_span));
+    EXPECT_EQ(2, get_candidate_source(false, true, this->m_section));
 
-    DomNode::register_node_dropped(node_dropped);
-    tag_type = PyDict_GetItemString(python._modules["lxml.html"], "HtmlElement");
+    EXPECT_EQ(0, get_candidate_source(false, false, this->m_paragraph));
+    EXPECT_EQ(-1, get_candidate_source(false, false, this->m_span));
+    EXPECT_EQ(-1, get_candidate_source(false, false, this->m_section));
+}
 
+TEST_F(BodyExtractorTest, text_features)
+{
+    // "中文，测试。" 20 times in utf-8, the text length stays in bytes.
+    string text;
+    for (int i = 0; i < 20; ++i)
+    {
+        text += "\xe4\xb8\xad\xe6\x96\x87\xef\xbc\x8c\xe6\xb5\x8b\xe8\xaf\x95\xe3\x80\x82";
+    }
 
-    //EXPECT_TRUE(python.print_dict(python._modules[module]));
+    DomNode* dom = this->m_parser.parse("<html><body><div><p>" + text + "</p><p>" + text + "</p></div></body></html>");
+    ASSERT_TRUE(dom != NULL);
+    DomNode* body = this->m_extractor.extract(dom);
+    ASSERT_TRUE(body != NULL);
+    EXPECT_STREQ("div", body->get_tag());
+
+    double text_length, char_count, comma_count, stop_count;
+    get_text_features(body, text_length, char_count, comma_count, stop_count);
+    EXPECT_EQ(2 * 20 * 18, text_length);
+    EXPECT_EQ(2 * 20 * 6, char_count);
+    EXPECT_EQ(2 * 20, comma_count);
+    EXPECT_EQ(2 * 20, stop_count);
+    delete dom;
+}
 
+TEST(BodyExtractor, main)
+{
     //const char* html = "<html><a class='aa'>xyz</a>abc<div>hello, world.</div><th/><div><p id='ad_wrapper'>xyz</p><div id='body'>xxxxxxxxxxxxxxxxxxxxxxxxxxx,y,yyyyyyyyyyyyyyyyyyyyyyyyzzzzzzzzzzzzzzzzzzzzzzzzzzz</div></div></html>";
     //test_file(html);
 
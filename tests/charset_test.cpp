@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include "charset.h"
+#include "utils.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::binary);
+    stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+static string to_utf8(const string& text, Charset charset)
+{
+    string utf8;
+    convert_to_utf8(text.data(), text.size(), charset, utf8);
+    return utf8;
+}
+
+static Charset detect(const string& html)
+{
+    return detect_charset(html.data(), html.size());
+}
+
+// "新闻，中文。" in gbk, and "這是測試頁面。" in big5, whose trail bytes are often ascii.
+static const string c_gbk_text = "\xd0\xc2\xce\xc5\xa3\xac\xd6\xd0\xce\xc4\xa1\xa3";
+static const string c_gbk_text_utf8 = "\xe6\x96\xb0\xe9\x97\xbb\xef\xbc\x8c\xe4\xb8\xad\xe6\x96\x87\xe3\x80\x82";
+static const string c_big5_text = "\xb3o\xacO\xb4\xfa\xb8\xd5\xad\xb6\xad\xb1\xa1" "C";
+static const string c_big5_text_utf8 = "\xe9\x80\x99\xe6\x98\xaf\xe6\xb8\xac\xe8\xa9\xa6\xe9\xa0\x81\xe9\x9d\xa2\xe3\x80\x82";
+
+TEST(Charset, lookup)
+{
+    const char* labels[] = {"utf-8", "UTF8", "gb2312", "GBK", "gb18030", "big5", "Big5-HKSCS", "iso-8859-1", "us-ascii", "utf-16", "", "gb"};
+    Charset charsets[] = {CHARSET_UTF8, CHARSET_UTF8, CHARSET_GBK, CHARSET_GBK, CHARSET_GBK, CHARSET_BIG5, CHARSET_BIG5,
+        CHARSET_WINDOWS_1252, CHARSET_WINDOWS_1252, CHARSET_UNKNOWN, CHARSET_UNKNOWN, CHARSET_UNKNOWN};
+    for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); ++i)
+    {
+        EXPECT_EQ(charsets[i], lookup_charset(labels[i], strlen(labels[i]))) << labels[i];
+    }
+
+    EXPECT_STREQ("gbk", get_charset_name(CHARSET_GBK));
+}
+
+TEST(Charset, detect)
+{
+    // bom and meta tags come before the bytes.
+    EXPECT_EQ(CHARSET_UTF8, detect("\xef\xbb\xbf<html>" + c_gbk_text));
+    EXPECT_EQ(CHARSET_BIG5, detect("<meta charset=\"big5\">" + c_gbk_text));
+    EXPECT_EQ(CHARSET_GBK, detect("<meta http-equiv=\"Content-Type\" content=\"text/html; CHARSET = GB2312\">"));
+    EXPECT_EQ(CHARSET_UTF8, detect("<meta charset='utf-8'>"));
+    // unknown labels and accept-charset are skipped.
+    EXPECT_EQ(CHARSET_GBK, detect("<meta charset=\"x-unknown\"><meta charset=gbk>"));
+    EXPECT_EQ(CHARSET_UTF8, detect("<form accept-charset=\"big5\"></form>"));
+
+    // ascii and valid utf-8 are utf-8.
+    EXPECT_EQ(CHARSET_UTF8, detect(""));
+    EXPECT_EQ(CHARSET_UTF8, detect("<p>text</p>"));
+    EXPECT_EQ(CHARSET_UTF8, detect("<p>" + c_gbk_text_utf8 + "</p>"));
+
+    string gbk;
+    string big5;
+    for (int i = 0; i < 20; ++i)
+    {
+        gbk += "<p>" + c_gbk_text + "</p>";
+        big5 += "<p>" + c_big5_text + "</p>";
+    }
+
+    EXPECT_EQ(CHARSET_GBK, detect(gbk));
+    EXPECT_EQ(CHARSET_BIG5, detect(big5));
+    EXPECT_EQ(CHARSET_WINDOWS_1252, detect("<p>caf\xe9 na\xefve \x80 r\xe9sum\xe9</p>"));
+}
+
+TEST(Charset, convert)
+{
+    EXPECT_EQ("<p>" + c_gbk_text_utf8 + "</p>", to_utf8("<p>" + c_gbk_text + "</p>", CHARSET_GBK));
+    EXPECT_EQ("<p>" + c_big5_text_utf8 + "</p>", to_utf8("<p>" + c_big5_text + "</p>", CHARSET_BIG5));
+    EXPECT_EQ("caf\xc3\xa9 \xe2\x82\xac \xc2\x81", to_utf8("caf\xe9 \x80 \x81", CHARSET_WINDOWS_1252));
+    EXPECT_EQ("", to_utf8("", CHARSET_GBK));
+
+    // bytes which can't be converted are U+FFFD, an ascii byte after a lead byte is kept,
+    // and a four byte char of gb18030 is one U+FFFD.
+    EXPECT_EQ("\xef\xbf\xbd<p>", to_utf8("\xd0<p>", CHARSET_GBK));
+    EXPECT_EQ("a\xef\xbf\xbd", to_utf8("a\xd0", CHARSET_GBK));
+    EXPECT_EQ("\xef\xbf\xbd" "a", to_utf8("\x81\x30\x81\x30" "a", CHARSET_GBK));
+    EXPECT_EQ("\xef\xbf\xbd" "a", to_utf8("\xfa\xa1" "a", CHARSET_BIG5));
+
+    // utf-8 is checked, its bom is dropped.
+    EXPECT_EQ(c_gbk_text_utf8, to_utf8("\xef\xbb\xbf" + c_gbk_text_utf8, CHARSET_UTF8));
+    EXPECT_EQ("a\xef\xbf\xbd\xef\xbf\xbd" "b", to_utf8("a\xc0\xaf" "b", CHARSET_UTF8));
+
+    // the output is never longer than get_max_utf8_length.
+    string bytes(100, '\xfe');
+    EXPECT_GE(get_max_utf8_length(bytes.size()), to_utf8(bytes, CHARSET_WINDOWS_1252).size());
+}
+
+TEST(Charset, fixture)
+{
+    // sina.html is gb2312, converted its chars count once each.
+    string html = read_file("sina.html");
+    ASSERT_FALSE(html.empty());
+    ASSERT_EQ(CHARSET_GBK, detect(html));
+
+    string utf8 = to_utf8(html, CHARSET_GBK);
+    EXPECT_EQ(CHARSET_UTF8, detect(utf8.substr(utf8.find("<body"))));
+    EXPECT_EQ(utf8, to_utf8(utf8, CHARSET_UTF8));
+    TextStats utf8_stats;
+    TextStats stats;
+    count_text(utf8.data(), utf8.size(), utf8_stats);
+    count_text(html.data(), html.size(), stats);
+    EXPECT_LT(utf8_stats.non_space_count, stats.non_space_count);
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include "gtest/gtest.h"
+
+#include "body_extractor.h"
+#include "list_page_classifier.h"
+#include "html_parser.h"
+#include "flat_dom.h"
+#include "dom_arena.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+using namespace std;
+
+static const char* c_url = "http://www.google.com/w/a/b/c?q=1";
+
+static string read_page(const char* file_name)
+{
+    ifstream file(file_name);
+    stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// what a worker gets from a page, the bodies serialized.
+struct PageResult
+{
+    string body;
+    string flat_body;
+    bool is_list_page;
+    bool flat_is_list_page;
+};
+
+// shared by all the workers, nothing is written after init.
+struct SharedState
+{
+    BodyExtractor extractor;
+    ListPageClassifier classifier;
+    HtmlParser parser;
+    vector<string> pages;
+    vector<PageResult> expected;
+};
+
+static void process_page(const SharedState& state, const string& html, PageResult& result)
+{
+    // the destructive extraction on a tree of the thread arena.
+    DomArena& arena = DomArena::get_thread_arena();
+    DomNode* dom = state.parser.parse(html.data(), html.size(), arena);
+    result.is_list_page = state.classifier.classify(dom, c_url);
+    DomNode* body = state.extractor.extract(dom);
+    result.body.clear();
+    if (body != NULL)
+    {
+        serialize_html(body, result.body);
+    }
+
+    arena.reset();
+
+    // the non-destructive one on a heap tree.
+    DomNode* source = state.parser.parse(html);
+    FlatDom flat_dom;
+    FlatDomMask kept;
+    int32_t flat_body = state.extractor.extract(source, flat_dom, kept);
+    result.flat_is_list_page = state.classifier.classify(flat_dom, c_url);
+    result.flat_body.clear();
+    if (flat_body >= 0)
+    {
+        serialize_html(flat_dom, flat_body, kept, result.flat_body);
+    }
+
+    delete source;
+}
+
+struct WorkerTask
+{
+    const SharedState* state;
+    int round_count;
+    int mismatch_count;
+};
+
+static void* run_worker(void* arg)
+{
+    WorkerTask* task = static_cast<WorkerTask*>(arg);
+    const SharedState& state = *task->state;
+    PageResult result;
+    for (int round = 0; round < task->round_count; ++round)
+    {
+        for (size_t i = 0; i < state.pages.size(); ++i)
+        {
+            process_page(state, state.pages[i], result);
+            const PageResult& expected = state.expected[i];
+            if (result.body != expected.body || result.flat_body != expected.flat_body ||
+                result.is_list_page != expected.is_list_page || result.flat_is_list_page != expected.flat_is_list_page)
+            {
+                ++task->mismatch_count;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+TEST(Concurrency, shared_instances)
+{
+    SharedState state;
+    ASSERT_TRUE(state.extractor.init("../body_extractor.ini"));
+    ASSERT_TRUE(state.classifier.init("list_page_classifier_test.ini"));
+    const char* file_names[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(file_names) / sizeof(file_names[0]); ++i)
+    {
+        state.pages.push_back(read_page(file_names[i]));
+        ASSERT_FALSE(state.pages.back().empty()) << file_names[i];
+    }
+
+    // results of one thread first.
+    state.expected.resize(state.pages.size());
+    for (size_t i = 0; i < state.pages.size(); ++i)
+    {
+        process_page(state, state.pages[i], state.expected[i]);
+        EXPECT_FALSE(state.expected[i].body.empty()) << file_names[i];
+        EXPECT_EQ(state.expected[i].body, state.expected[i].flat_body) << file_names[i];
+    }
+
+    const int c_thread_count = 4;
+    WorkerTask tasks[c_thread_count];
+    pthread_t threads[c_thread_count];
+    for (int i = 0; i < c_thread_count; ++i)
+    {
+        tasks[i].state = &state;
+        tasks[i].round_count = 3;
+        tasks[i].mismatch_count = 0;
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, run_worker, &tasks[i]));
+    }
+
+    for (int i = 0; i < c_thread_count; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        EXPECT_EQ(0, tasks[i].mismatch_count) << "thread " << i;
+    }
+
+    // the counters of all threads add up.
+    uint64_t lookup_count = 0;
+    uint64_t hit_count = 0;
+    state.extractor.get_class_id_cache_stats(lookup_count, hit_count);
+    EXPECT_GT(lookup_count, 0u);
+    EXPECT_EQ(0u, lookup_count % (c_thread_count * 3 + 1));
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
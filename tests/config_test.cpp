@@ -54,6 +54,29 @@ TEST(Config, body_extractor)
     EXPECT_EQ(sanitize_expr, config.GetStringValue(c_section_name, "sanitize_expression"));
 }
 
+TEST(Config, cache)
+{
+    Config config;
+    config.Set("a", "number", "1");
+    config.Set("b", "number", "2.5");
+
+    // parsed values are kept per section and key.
+    EXPECT_EQ(1, config.GetIntValue("a", "number"));
+    EXPECT_EQ(2, config.GetIntValue("b", "number"));
+    EXPECT_EQ(1, config.GetIntValue("a", "number"));
+    EXPECT_EQ(2.5, config.GetDoubleValue("b", "number"));
+    EXPECT_TRUE(config.GetBoolValue("a", "number"));
+    EXPECT_FALSE(config.GetBoolValue("b", "number"));
+    EXPECT_EQ(string("2.5"), config.GetStringValue("b", "number"));
+
+    // and dropped when the value is set again.
+    config.Set("a", "number", "3");
+    EXPECT_EQ(3, config.GetIntValue("a", "number"));
+    EXPECT_EQ(3.0, config.GetDoubleValue("a", "number"));
+    EXPECT_FALSE(config.GetBoolValue("a", "number"));
+    EXPECT_EQ(2, config.GetIntValue("b", "number"));
+}
+
 int main(int argc, char* argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+
+#include "dom_arena.h"
+#include "dom_tree.h"
+#include "html_parser.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+
+using namespace std;
+
+void print_dom(const DomNode* node, stringstream& text)
+{
+    const char* parent_tag = node->get_parent() != NULL ? node->get_parent()->get_tag() : "NULL";
+    text << node->get_tag() << "," << parent_tag << "," << node->get_text() << "," << (int)node->get_children()->size() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        print_dom((*node->get_children())[i], text);
+    }
+}
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+TEST(DomArena, allocate)
+{
+    DomArena arena(256);
+    void* a = arena.allocate(3);
+    void* b = arena.allocate(40);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a) % 16);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(b) % 16);
+    EXPECT_EQ(static_cast<char*>(a) + 16, b);
+    EXPECT_EQ(64u, arena.get_allocated_size());
+
+    // the last allocation is given back.
+    arena.deallocate(b, 40);
+    EXPECT_EQ(b, arena.allocate(40));
+
+    EXPECT_STREQ("abc", arena.copy_string("abcdef", 3));
+
+    // larger than a block.
+    void* large = arena.allocate(1000);
+    EXPECT_TRUE(large != NULL);
+    EXPECT_EQ(256u + 1008u, arena.get_capacity());
+
+    // blocks are kept and reused after reset.
+    arena.reset();
+    EXPECT_EQ(0u, arena.get_allocated_size());
+    EXPECT_EQ(a, arena.allocate(8));
+    EXPECT_EQ(256u + 1008u, arena.get_capacity());
+}
+
+TEST(DomArena, allocator)
+{
+    DomArena arena;
+    vector<int, ArenaAllocator<int> > numbers((ArenaAllocator<int>(&arena)));
+    for (int i = 0; i < 1000; ++i)
+    {
+        numbers.push_back(i);
+    }
+
+    EXPECT_EQ(999, numbers.back());
+    EXPECT_GE(arena.get_allocated_size(), 1000 * sizeof(int));
+
+    // no arena, on the heap.
+    vector<int, ArenaAllocator<int> > heap_numbers(1000, 1);
+    EXPECT_EQ(1000u, heap_numbers.size());
+}
+
+TEST(DomArena, parse)
+{
+    const char* file_names[] = {"sina.html", "news.ori.html"};
+    DomArena arena;
+    HtmlParser parser;
+    for (size_t i = 0; i < sizeof(file_names) / sizeof(file_names[0]); ++i)
+    {
+        string html = read_file(file_names[i]);
+        ASSERT_FALSE(html.empty());
+
+        DomNode* heap_dom = parser.parse(html);
+        ASSERT_TRUE(heap_dom != NULL);
+        stringstream expected;
+        print_dom(heap_dom, expected);
+        delete heap_dom;
+
+        // the same arena is reused for every document, the second round doesn't grow it.
+        size_t capacity = 0;
+        for (int round = 0; round < 2; ++round)
+        {
+            arena.reset();
+            DomNode* dom = parser.parse(html.data(), html.size(), arena);
+            ASSERT_TRUE(dom != NULL);
+            EXPECT_EQ(&arena, dom->get_arena());
+            stringstream actual;
+            print_dom(dom, actual);
+            EXPECT_EQ(expected.str(), actual.str()) << file_names[i];
+
+            if (round == 0)
+            {
+                capacity = arena.get_capacity();
+            }
+            else
+            {
+                EXPECT_EQ(capacity, arena.get_capacity());
+            }
+        }
+    }
+}
+
+TEST(DomArena, modify)
+{
+    DomArena arena;
+    const char* html = "<html><body><div id=\"a\">x<p>y</p>z</div><div id=\"b\">w</div></body></html>";
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html, strlen(html), arena);
+    ASSERT_TRUE(dom != NULL);
+
+    vector<DomNode*> divs;
+    dom->find_tags("div", divs);
+    ASSERT_EQ(2u, divs.size());
+
+    // copied strings go into the arena.
+    divs[0]->set_tag("section");
+    divs[0]->add_attribute("class", "main");
+    divs[0]->add_attribute("data-x", "1");
+    divs[0]->append_text(string("!"));
+    divs[0]->set_extra(1, 2.0);
+    EXPECT_STREQ("section", divs[0]->get_tag());
+    EXPECT_STREQ("main", divs[0]->get_attribute("class"));
+    EXPECT_STREQ("1", divs[0]->get_attribute("data-x"));
+    EXPECT_STREQ("xz!", divs[0]->get_text());
+    EXPECT_EQ(2.0, divs[0]->get_extra(1));
+
+    // dropped arena nodes are only unlinked.
+    DomNode* body = divs[1]->get_parent();
+    EXPECT_TRUE(DomNode::drop_node(divs[1]));
+    EXPECT_EQ(1u, body->get_children()->size());
+
+    string output;
+    serialize_html(dom, output);
+    EXPECT_EQ("<html><body><section class=\"main\" data-x=\"1\" id=\"a\">xz!<p>y</p></section></body></html>", output);
+}
+
+void* parse_in_thread(void* arg)
+{
+    const char* html = static_cast<const char*>(arg);
+    DomArena& arena = DomArena::get_thread_arena();
+    HtmlParser parser;
+    for (int i = 0; i < 10; ++i)
+    {
+        arena.reset();
+        DomNode* dom = parser.parse(html, strlen(html), arena);
+        if (dom == NULL || dom->get_children()->size() != 1)
+        {
+            return NULL;
+        }
+    }
+
+    return &arena;
+}
+
+TEST(DomArena, thread_arena)
+{
+    DomArena& arena = DomArena::get_thread_arena();
+    EXPECT_EQ(&arena, &DomArena::get_thread_arena());
+
+    const char* html = "<div>a</div>";
+    pthread_t threads[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, parse_in_thread, const_cast<char*>(html)));
+    }
+
+    void* results[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        pthread_join(threads[i], &results[i]);
+        EXPECT_TRUE(results[i] != NULL);
+        EXPECT_NE(static_cast<void*>(&arena), results[i]);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
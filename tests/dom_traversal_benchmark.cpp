@@ -0,0 +1,278 @@
+#include "html_parser.h"
+#include "dom_tree.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include <time.h>
+
+using namespace std;
+
+// traversal of deep generated trees on a small thread stack, and of the fixture pages
+// against a recursive walk, to check the explicit stack costs nothing on shallow trees,
+// with the visitor dispatched through virtual calls and at compile time.
+// usage: dom_traversal_benchmark [iterations] [files...]
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+class CountingVisitor : public DomTreeVisitor
+{
+public:
+    CountingVisitor() :
+        count(0)
+    {
+    }
+
+    virtual bool visit(DomNode* node)
+    {
+        ++this->count;
+        return true;
+    }
+
+    long count;
+};
+
+// sums the text of the nodes and counts the links, with Base as DomTreeVisitor
+// the calls are virtual, with InlineDomTreeVisitor they are inlined.
+template <typename Base>
+class TextVisitor : public Base
+{
+public:
+    TextVisitor() :
+        count(0), links(0), text_length(0)
+    {
+    }
+
+    bool visit(DomNode* node)
+    {
+        ++this->count;
+        this->text_length += node->get_text_length();
+        if (node->get_tag_atom() == TAG_A)
+        {
+            ++this->links;
+        }
+
+        return true;
+    }
+
+    long count;
+    long links;
+    size_t text_length;
+};
+
+// the traversal before the explicit stack, for comparison.
+bool recursive_preorder(DomNode* node, DomTreeVisitor& visitor)
+{
+    if (!visitor.preprocess(node) || !visitor.visit(node))
+    {
+        return false;
+    }
+
+    const DomNodeList* children = node->get_children();
+    for (size_t i = 0; i < children->size(); ++i)
+    {
+        recursive_preorder((*children)[i], visitor);
+    }
+
+    return visitor.postprocess(node);
+}
+
+double nanoseconds_per_node(long nodes, double seconds)
+{
+    return seconds * 1e9 / static_cast<double>(nodes);
+}
+
+struct DeepTreeArgs
+{
+    int depth;
+    int iterations;
+};
+
+void* benchmark_deep_tree(void* arg)
+{
+    const DeepTreeArgs* args = static_cast<const DeepTreeArgs*>(arg);
+    double start = now();
+    DomNode* root = new DomNode(string("div"), string(""));
+    DomNode* node = root;
+    for (int i = 1; i < args->depth; ++i)
+    {
+        DomNode* child = new DomNode(string(i % 2 == 0 ? "b" : "i"), string(""));
+        node->append_child(child);
+        node = child;
+    }
+
+    double build_time = now() - start;
+
+    DomTraversalStack stack;
+    CountingVisitor preorder;
+    start = now();
+    for (int i = 0; i < args->iterations; ++i)
+    {
+        root->preorder_traverse(preorder, stack);
+    }
+
+    double preorder_time = now() - start;
+
+    CountingVisitor postorder;
+    start = now();
+    for (int i = 0; i < args->iterations; ++i)
+    {
+        root->postorder_traverse(postorder, stack);
+    }
+
+    double postorder_time = now() - start;
+
+    vector<DomNode*> results;
+    start = now();
+    for (int i = 0; i < args->iterations; ++i)
+    {
+        results.clear();
+        root->find_tags("b", results);
+    }
+
+    double find_time = now() - start;
+
+    string html;
+    start = now();
+    for (int i = 0; i < args->iterations; ++i)
+    {
+        html.clear();
+        serialize_html(root, html);
+    }
+
+    double serialize_time = now() - start;
+
+    start = now();
+    delete root;
+    double delete_time = now() - start;
+
+    long nodes = static_cast<long>(args->depth) * args->iterations;
+    printf("depth %8d: build %6.1f preorder %6.1f postorder %6.1f find_tags %6.1f serialize %6.1f delete %6.1f ns/node\n",
+        args->depth, nanoseconds_per_node(args->depth, build_time), nanoseconds_per_node(nodes, preorder_time),
+        nanoseconds_per_node(nodes, postorder_time), nanoseconds_per_node(nodes, find_time),
+        nanoseconds_per_node(nodes, serialize_time), nanoseconds_per_node(args->depth, delete_time));
+    return NULL;
+}
+
+// dispatch of the same visitor through the virtual interface and through DomTreeTraversal.
+template <typename Visitor>
+double time_traversal(DomNode* dom, Visitor& visitor, bool preorder, int iterations)
+{
+    DomTraversalStack stack;
+    double start = now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        if (preorder)
+        {
+            DomTreeTraversal<Visitor>::preorder(dom, visitor, stack);
+        }
+        else
+        {
+            DomTreeTraversal<Visitor>::postorder(dom, visitor, stack);
+        }
+    }
+
+    return now() - start;
+}
+
+void benchmark_page(const char* file_name, int iterations)
+{
+    string html = read_file(file_name);
+    if (html.empty())
+    {
+        printf("can't read %s\n", file_name);
+        return;
+    }
+
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    iterations *= 100;
+
+    // through a pointer the compiler can't see through, like the visitors of the other modules.
+    TextVisitor<DomTreeVisitor> recursive;
+    DomTreeVisitor* volatile visitor = &recursive;
+    double start = now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        recursive_preorder(dom, *visitor);
+    }
+
+    double recursive_time = now() - start;
+    long nodes = recursive.count;
+
+    TextVisitor<DomTreeVisitor> virtual_visitor;
+    DomTreeVisitor* volatile virtual_pointer = &virtual_visitor;
+    TextVisitor<InlineDomTreeVisitor> inline_visitor;
+    double virtual_preorder_time = time_traversal(dom, *virtual_pointer, true, iterations);
+    double inline_preorder_time = time_traversal(dom, inline_visitor, true, iterations);
+    double virtual_postorder_time = time_traversal(dom, *virtual_pointer, false, iterations);
+    double inline_postorder_time = time_traversal(dom, inline_visitor, false, iterations);
+    if (virtual_visitor.text_length != inline_visitor.text_length)
+    {
+        printf("%s: visitors disagree\n", file_name);
+    }
+
+    printf("%-16s %6ld nodes: recursive %5.2f, preorder virtual %5.2f inline %5.2f, postorder virtual %6.2f inline %6.2f ns/node\n",
+        file_name, nodes / iterations, nanoseconds_per_node(nodes, recursive_time),
+        nanoseconds_per_node(nodes, virtual_preorder_time), nanoseconds_per_node(nodes, inline_preorder_time),
+        nanoseconds_per_node(nodes, virtual_postorder_time), nanoseconds_per_node(nodes, inline_postorder_time));
+    delete dom;
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 10;
+    if (iterations <= 0)
+    {
+        iterations = 10;
+    }
+
+    // the deep trees run on a thread with a small stack, where recursion would overflow.
+    int depths[] = {1000, 10000, 100000, 1000000};
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i)
+    {
+        DeepTreeArgs args = {depths[i], iterations};
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, 64 * 1024);
+        pthread_t thread;
+        if (pthread_create(&thread, &attributes, benchmark_deep_tree, &args) == 0)
+        {
+            pthread_join(thread, NULL);
+        }
+
+        pthread_attr_destroy(&attributes);
+    }
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            benchmark_page(argv[i], iterations);
+        }
+    }
+    else
+    {
+        benchmark_page("sina.html", iterations);
+        benchmark_page("news.ori.html", iterations);
+    }
+
+    return 0;
+}
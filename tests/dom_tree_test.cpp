@@ -0,0 +1,356 @@
+#include "gtest/gtest.h"
+
+#include "dom_tree.h"
+#include "dom_arena.h"
+#include "boolean_classifier.h"
+#include "html_parser.h"
+
+#include <pthread.h>
+#include <sstream>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST(DomNode, extras)
+{
+    DomNode node(string("div"), string(""));
+    EXPECT_FALSE(node.has_extra(0));
+    EXPECT_EQ(0u, node.get_extra_mask());
+    EXPECT_EQ(-1.0, node.get_extra_default(3, -1.0));
+
+    // not set extras read as 0 in the span.
+    FeatureArray extras = node.get_extras();
+    EXPECT_EQ(static_cast<size_t>(DomNode::c_extra_count), extras.size);
+    EXPECT_EQ(0.0, extras.values[DomNode::c_extra_count - 1]);
+
+    node.set_extra(3, 2.5);
+    EXPECT_TRUE(node.has_extra(3));
+    EXPECT_FALSE(node.has_extra(2));
+    EXPECT_EQ(2.5, node.get_extra(3));
+    EXPECT_EQ(2.5, node.get_extra_default(3, -1.0));
+    EXPECT_EQ(1u << 3, node.get_extra_mask());
+    EXPECT_EQ(2.5, node.get_extras().values[3]);
+    EXPECT_EQ(0.0, node.get_extras().values[2]);
+
+    double values[] = {1, 2, 3, 4, 5};
+    node.set_extras(values, 5);
+    EXPECT_EQ(0x1fu, node.get_extra_mask());
+    EXPECT_EQ(4.0, node.get_extra(3));
+    double result = 0;
+    EXPECT_TRUE(node.get_extra(4, result));
+    EXPECT_EQ(5.0, result);
+    EXPECT_FALSE(node.get_extra(5, result));
+}
+
+TEST(DomNode, arena_extras)
+{
+    DomArena arena;
+    DomNode* node = DomNode::create(arena, "p");
+    size_t allocated = arena.get_allocated_size();
+    EXPECT_FALSE(node->has_extra(1));
+
+    // the slots are in the arena.
+    node->set_extra(1, 3.0);
+    EXPECT_EQ(allocated + (DomNode::c_extra_count * sizeof(double) + 15) / 16 * 16, arena.get_allocated_size());
+    EXPECT_EQ(3.0, node->get_extra(1));
+
+    // the span feeds the classifiers directly.
+    vector<string> feature_names;
+    feature_names.push_back("F0");
+    feature_names.push_back("F1");
+    BooleanClassifier classifier;
+    ASSERT_TRUE(classifier.init("F1 > 2", feature_names));
+    EXPECT_TRUE(classifier.classify(node->get_extras()));
+    node->set_extra(1, 1.0);
+    EXPECT_FALSE(classifier.classify(node->get_extras()));
+}
+
+TEST(DomNode, attributes)
+{
+    DomNode node(string("a"), string(""));
+    // class and id are never NULL.
+    EXPECT_STREQ("", node.get_class());
+    EXPECT_STREQ("", node.get_id());
+    EXPECT_STREQ("", node.get_attribute("class"));
+    EXPECT_FALSE(node.has_attribute("class"));
+    EXPECT_TRUE(node.get_attribute("href") == NULL);
+    EXPECT_TRUE(node.get_attribute("data-x") == NULL);
+
+    string value("main");
+    node.add_attribute("class", value.c_str());
+    value = "changed";
+    node.add_attribute("data-x", "1");
+    node.add_attribute("href", "/a");
+    EXPECT_STREQ("main", node.get_class());
+    EXPECT_TRUE(node.has_attribute("class"));
+    EXPECT_STREQ("1", node.get_attribute("data-x"));
+    EXPECT_STREQ("/a", node.get_attribute(ATTR_HREF));
+    EXPECT_EQ(3u, node.get_attribute_count());
+    EXPECT_EQ(ATTR_UNKNOWN, node.get_attribute_at(1).name_id);
+    EXPECT_EQ(ATTR_HREF, node.get_attribute_at(2).name_id);
+
+    // replaced in place.
+    node.add_attribute("class", "side");
+    node.add_attribute("data-x", "2");
+    EXPECT_STREQ("side", node.get_class());
+    EXPECT_STREQ("2", node.get_attribute("data-x"));
+    EXPECT_EQ(3u, node.get_attribute_count());
+
+    // more than the inline ones.
+    node.add_attribute("id", "x");
+    node.add_attribute("data-y", "3");
+    EXPECT_EQ(5u, node.get_attribute_count());
+    EXPECT_STREQ("side", node.get_class());
+    EXPECT_STREQ("x", node.get_id());
+    EXPECT_STREQ("3", node.get_attribute("data-y"));
+
+    vector<pair<const char*, const char*> > attributes;
+    node.get_attributes(attributes);
+    ASSERT_EQ(5u, attributes.size());
+    EXPECT_STREQ("class", attributes[0].first);
+    EXPECT_STREQ("data-y", attributes[4].first);
+}
+
+TEST(DomNode, arena_attributes)
+{
+    DomArena arena;
+    DomNode* node = DomNode::create(arena, "div");
+    node->add_attribute_view("class", "main");
+    node->add_attribute_view("id", "body");
+    node->add_attribute_view("title", "t");
+
+    // three attributes are inline.
+    size_t allocated = arena.get_allocated_size();
+    EXPECT_STREQ("main", node->get_class());
+    EXPECT_STREQ("body", node->get_id());
+    EXPECT_STREQ("t", node->get_attribute("title"));
+    EXPECT_EQ(allocated, arena.get_allocated_size());
+
+    node->add_attribute("data-x", "1");
+    EXPECT_GT(arena.get_allocated_size(), allocated);
+    EXPECT_STREQ("1", node->get_attribute("data-x"));
+    EXPECT_STREQ("main", node->get_class());
+}
+
+// records the calls, drops nodes of drop_tag in preprocess or visit.
+// Base is DomTreeVisitor for the virtual dispatch or InlineDomTreeVisitor for DomTreeTraversal.
+template <typename Base>
+class RecordingVisitor : public Base
+{
+public:
+    RecordingVisitor(const char* drop_tag, bool drop_in_visit) :
+        m_drop_tag(drop_tag), m_drop_in_visit(drop_in_visit)
+    {
+    }
+
+    bool preprocess(DomNode* node)
+    {
+        this->m_calls << "pre:" << node->get_tag() << " ";
+        return m_drop_in_visit || !this->drop(node);
+    }
+
+    bool visit(DomNode* node)
+    {
+        this->m_calls << "visit:" << node->get_tag() << " ";
+        return !m_drop_in_visit || !this->drop(node);
+    }
+
+    bool postprocess(DomNode* node)
+    {
+        this->m_calls << "post:" << node->get_tag() << " ";
+        return true;
+    }
+
+    string get_calls() const
+    {
+        return this->m_calls.str();
+    }
+
+private:
+    bool drop(DomNode* node)
+    {
+        if (strcmp(node->get_tag(), this->m_drop_tag) == 0)
+        {
+            DomNode::drop_node(node);
+            return true;
+        }
+
+        return false;
+    }
+
+    const char* m_drop_tag;
+    bool m_drop_in_visit;
+    stringstream m_calls;
+};
+
+TEST(DomNode, traverse)
+{
+    const char* html = "<html><body><div><p>a</p><i>b</i><p>c</p></div><i>d</i><span>e</span></body></html>";
+    HtmlParser parser;
+    DomTraversalStack stack;
+
+    DomNode* dom = parser.parse(html);
+    RecordingVisitor<DomTreeVisitor> preorder("i", false);
+    EXPECT_TRUE(dom->preorder_traverse(preorder, stack));
+    EXPECT_EQ("pre:html visit:html pre:body visit:body pre:div visit:div pre:p visit:p post:p pre:i pre:p visit:p post:p post:div "
+        "pre:i pre:span visit:span post:span post:body post:html ", preorder.get_calls());
+    string output;
+    serialize_html(dom, output);
+    EXPECT_EQ("<html><body><div><p>a</p><p>c</p></div><span>e</span></body></html>", output);
+    delete dom;
+
+    // dropped in visit, after the children.
+    dom = parser.parse(html);
+    RecordingVisitor<DomTreeVisitor> postorder("div", true);
+    EXPECT_TRUE(dom->postorder_traverse(postorder, stack));
+    EXPECT_EQ("pre:html pre:body pre:div pre:p visit:p post:p pre:i visit:i post:i pre:p visit:p post:p visit:div "
+        "pre:i visit:i post:i pre:span visit:span post:span visit:body post:body visit:html post:html ", postorder.get_calls());
+    output.clear();
+    serialize_html(dom, output);
+    EXPECT_EQ("<html><body><i>d</i><span>e</span></body></html>", output);
+
+    // the root can't be dropped.
+    RecordingVisitor<DomTreeVisitor> root("html", false);
+    EXPECT_FALSE(dom->preorder_traverse(root, stack));
+    delete dom;
+}
+
+TEST(DomNode, inline_traverse)
+{
+    const char* html = "<html><body><div><p>a</p><i>b</i><p>c</p></div><i>d</i><span>e</span></body></html>";
+    const char* drop_tags[] = {"i", "div", "span", "html"};
+    HtmlParser parser;
+    DomTraversalStack stack;
+    for (size_t i = 0; i < sizeof(drop_tags) / sizeof(drop_tags[0]); ++i)
+    {
+        for (int drop_in_visit = 0; drop_in_visit < 2; ++drop_in_visit)
+        {
+            // the same calls and drops with both dispatches.
+            DomNode* virtual_dom = parser.parse(html);
+            DomNode* inline_dom = parser.parse(html);
+            RecordingVisitor<DomTreeVisitor> virtual_visitor(drop_tags[i], drop_in_visit != 0);
+            RecordingVisitor<InlineDomTreeVisitor> inline_visitor(drop_tags[i], drop_in_visit != 0);
+            if (drop_in_visit)
+            {
+                EXPECT_EQ(virtual_dom->postorder_traverse(virtual_visitor, stack),
+                    DomTreeTraversal<RecordingVisitor<InlineDomTreeVisitor> >::postorder(inline_dom, inline_visitor, stack));
+            }
+            else
+            {
+                EXPECT_EQ(virtual_dom->preorder_traverse(virtual_visitor, stack),
+                    DomTreeTraversal<RecordingVisitor<InlineDomTreeVisitor> >::preorder(inline_dom, inline_visitor, stack));
+            }
+
+            EXPECT_EQ(virtual_visitor.get_calls(), inline_visitor.get_calls()) << drop_tags[i];
+            string virtual_output;
+            string inline_output;
+            serialize_html(virtual_dom, virtual_output);
+            serialize_html(inline_dom, inline_output);
+            EXPECT_EQ(virtual_output, inline_output) << drop_tags[i];
+            delete virtual_dom;
+            delete inline_dom;
+        }
+    }
+}
+
+TEST(DomNode, fused_traverse)
+{
+    const char* html = "<html><body><div><p>a</p><i>b</i><p>c</p></div><i>d</i><span>e</span></body></html>";
+    HtmlParser parser;
+    DomTraversalStack stack;
+    DomNode* dom = parser.parse(html);
+
+    // the first drops i in preprocess, then div in visit of a postorder traversal.
+    RecordingVisitor<InlineDomTreeVisitor> first("i", false);
+    RecordingVisitor<InlineDomTreeVisitor> second("div", true);
+    RecordingVisitor<DomTreeVisitor> third("none", false);
+    typedef FusedDomTreeVisitor<RecordingVisitor<DomTreeVisitor>, RecordingVisitor<DomTreeVisitor> > LastVisitors;
+    RecordingVisitor<DomTreeVisitor> fourth("none", false);
+    LastVisitors last(third, fourth);
+    typedef FusedDomTreeVisitor<RecordingVisitor<InlineDomTreeVisitor>, RecordingVisitor<InlineDomTreeVisitor> > FirstVisitors;
+    FirstVisitors first_two(first, second);
+    typedef FusedDomTreeVisitor<FirstVisitors, LastVisitors> AllVisitors;
+    AllVisitors all(first_two, last);
+    EXPECT_TRUE(DomTreeTraversal<AllVisitors>::postorder(dom, all, stack));
+
+    EXPECT_EQ("pre:html pre:body pre:div pre:p visit:p post:p pre:i pre:p visit:p post:p visit:div pre:i pre:span visit:span post:span "
+        "visit:body post:body visit:html post:html ", first.get_calls());
+    // the nodes dropped by the first ones are not seen by the others.
+    EXPECT_EQ("pre:html pre:body pre:div pre:p visit:p post:p pre:p visit:p post:p visit:div pre:span visit:span post:span "
+        "visit:body post:body visit:html post:html ", second.get_calls());
+    EXPECT_EQ("pre:html pre:body pre:div pre:p visit:p post:p pre:p visit:p post:p pre:span visit:span post:span "
+        "visit:body post:body visit:html post:html ", third.get_calls());
+    EXPECT_EQ(third.get_calls(), fourth.get_calls());
+
+    string output;
+    serialize_html(dom, output);
+    EXPECT_EQ("<html><body><span>e</span></body></html>", output);
+    delete dom;
+}
+
+class CountingVisitor : public DomTreeVisitor
+{
+public:
+    CountingVisitor() :
+        count(0)
+    {
+    }
+
+    virtual bool visit(DomNode* node)
+    {
+        ++this->count;
+        return true;
+    }
+
+    int count;
+};
+
+void* traverse_deep_tree(void* arg)
+{
+    int depth = *static_cast<int*>(arg);
+    DomNode* root = new DomNode(string("div"), string(""));
+    DomNode* node = root;
+    for (int i = 1; i < depth; ++i)
+    {
+        DomNode* child = new DomNode(string(i % 2 == 0 ? "b" : "i"), string(""));
+        node->append_child(child);
+        node = child;
+    }
+
+    CountingVisitor preorder;
+    CountingVisitor postorder;
+    root->preorder_traverse(preorder);
+    root->postorder_traverse(postorder);
+    vector<DomNode*> results;
+    root->find_tags("b", results);
+    string html;
+    serialize_html(root, html);
+    delete root;
+
+    bool success = preorder.count == depth && postorder.count == depth && static_cast<int>(results.size()) == (depth - 1) / 2 &&
+        html.size() == static_cast<size_t>(depth) * 7 + 4;
+    return success ? arg : NULL;
+}
+
+TEST(DomNode, deep_tree)
+{
+    // on a thread with a small stack, like the workers.
+    int depth = 100000;
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, 64 * 1024);
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, &attributes, traverse_deep_tree, &depth));
+    void* result = NULL;
+    pthread_join(thread, &result);
+    pthread_attr_destroy(&attributes);
+    EXPECT_EQ(&depth, result);
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
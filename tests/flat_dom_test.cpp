@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+
+#include "flat_dom.h"
+#include "dom_tree.h"
+#include "html_parser.h"
+
+#include <string>
+
+using namespace std;
+
+TEST(FlatDom, build)
+{
+    const char* html = "<html><body><div class=\"a\">x<p>y</p>z</div><div id=\"b\">w</div></body></html>";
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+
+    FlatDom flat_dom;
+    flat_dom.build(dom);
+
+    ASSERT_EQ(5, flat_dom.size());
+    const char* tags[] = {"html", "body", "div", "p", "div"};
+    int32_t parents[] = {-1, 0, 1, 2, 1};
+    int32_t first_children[] = {1, 2, 3, -1, -1};
+    int32_t next_siblings[] = {-1, -1, 4, -1, -1};
+    int32_t subtree_ends[] = {5, 5, 4, 4, 5};
+    int32_t depths[] = {0, 1, 2, 3, 2};
+    for (int32_t i = 0; i < flat_dom.size(); ++i)
+    {
+        EXPECT_STREQ(tags[i], flat_dom.get_tag(i)) << i;
+        EXPECT_EQ(parents[i], flat_dom.get_parent(i)) << i;
+        EXPECT_EQ(first_children[i], flat_dom.get_first_child(i)) << i;
+        EXPECT_EQ(next_siblings[i], flat_dom.get_next_sibling(i)) << i;
+        EXPECT_EQ(subtree_ends[i], flat_dom.get_subtree_end(i)) << i;
+        EXPECT_EQ(depths[i], flat_dom.get_depth(i)) << i;
+    }
+
+    // both divs share a tag id.
+    EXPECT_EQ(flat_dom.get_tag_id(2), flat_dom.get_tag_id(4));
+    EXPECT_EQ(4, flat_dom.get_tag_count());
+    EXPECT_STREQ("div", flat_dom.get_tag_name(flat_dom.get_tag_id(2)));
+
+    EXPECT_STREQ("a", flat_dom.get_class(2));
+    // the parser gives every node a class and an id.
+    EXPECT_STREQ("", flat_dom.get_id(2));
+    EXPECT_STREQ("b", flat_dom.get_id(4));
+
+    string text;
+    flat_dom.get_text(2, text);
+    EXPECT_EQ("xz", text);
+    EXPECT_EQ(2u, flat_dom.get_text_length(2));
+    // text of a heap node is one piece.
+    EXPECT_EQ(1u, flat_dom.get_text_piece_count(2));
+    EXPECT_EQ(dom, flat_dom.get_node(0));
+
+    flat_dom.clear();
+    EXPECT_EQ(0, flat_dom.size());
+    delete dom;
+}
+
+TEST(FlatDom, deep)
+{
+    // the build is not recursive.
+    string html;
+    for (int i = 0; i < 100000; ++i)
+    {
+        html += "<div>";
+    }
+
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+
+    FlatDom flat_dom;
+    flat_dom.build(dom);
+    EXPECT_EQ(flat_dom.size(), flat_dom.get_subtree_end(0));
+    EXPECT_EQ(flat_dom.size() - 1, flat_dom.get_depth(flat_dom.size() - 1));
+    delete dom;
+}
+
+TEST(FlatDomMask, erase)
+{
+    FlatDomMask mask;
+    mask.assign(200, true);
+    EXPECT_EQ(200, mask.size());
+    EXPECT_EQ(200, mask.count());
+
+    // ranges over whole words and parts of them.
+    mask.erase(10, 150);
+    EXPECT_TRUE(mask.contains(9));
+    EXPECT_FALSE(mask.contains(10));
+    EXPECT_FALSE(mask.contains(149));
+    EXPECT_TRUE(mask.contains(150));
+    EXPECT_EQ(60, mask.count());
+
+    mask.erase(199);
+    mask.insert(64);
+    EXPECT_FALSE(mask.contains(199));
+    EXPECT_TRUE(mask.contains(64));
+    EXPECT_EQ(60, mask.count());
+
+    mask.assign(3, false);
+    EXPECT_EQ(0, mask.count());
+    mask.insert(2);
+    EXPECT_EQ(1, mask.count());
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,53 @@
+#include "flight_recorder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// prints the events saved by FlightRecorder::save_all, a line per event under its thread.
+// usage: flight_dump file [document], with a document only its events are printed.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s file [document]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        printf("can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    vector<FlightThreadEvents> threads;
+    bool success = FlightRecorder::load(file, threads);
+    fclose(file);
+    if (!success)
+    {
+        printf("%s is not a flight recorder file\n", argv[1]);
+        return 1;
+    }
+
+    long document = argc > 2 ? atol(argv[2]) : 0;
+    string line;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        printf("thread %u, %u events\n", threads[i].thread, static_cast<unsigned>(threads[i].events.size()));
+        for (size_t j = 0; j < threads[i].events.size(); ++j)
+        {
+            const FlightEvent& event = threads[i].events[j];
+            if (document == 0 || static_cast<long>(event.document) == document)
+            {
+                FlightRecorder::format_event(event, line);
+                printf("  %s\n", line.c_str());
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "gtest/gtest.h"
+
+#include "flight_recorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+using namespace std;
+
+// events of the last document of the thread.
+static void get_document_events(vector<FlightEvent>& events)
+{
+    FlightRecorder::get_thread_recorder().get_events(events);
+    size_t first = events.size();
+    while (first > 0 && events[first - 1].document == events.back().document)
+    {
+        --first;
+    }
+
+    events.erase(events.begin(), events.begin() + static_cast<long>(first));
+}
+
+TEST(FlightRecorder, record)
+{
+    FlightRecorder& recorder = FlightRecorder::get_thread_recorder();
+    recorder.begin_document(1);
+    recorder.record(FLIGHT_DROP, TAG_DIV, "sidebar", "side", 0, 0);
+    recorder.record(FLIGHT_CANDIDATE, TAG_P, "", "main", 1 | 4, 12.5);
+    recorder.record(FLIGHT_SANITIZE_DROP, TAG_FORM, NULL, NULL, 0, -3);
+    recorder.record(FLIGHT_BODY, TAG_DIV, "a_very_long_class_name_for_the_body", NULL, 0, 2345);
+    recorder.record(FLIGHT_DONE, TAG_UNKNOWN, NULL, NULL, 1, 420);
+
+    vector<FlightEvent> events;
+    get_document_events(events);
+    ASSERT_EQ(6u, events.size());
+    EXPECT_EQ(FLIGHT_DOCUMENT, events[0].type);
+    EXPECT_EQ(1, events[0].detail);
+    EXPECT_EQ(FLIGHT_DROP, events[1].type);
+    EXPECT_EQ(TAG_DIV, events[1].tag);
+    EXPECT_EQ(12.5f, events[2].value);
+
+    const char* expected[] =
+    {
+        "document flat",
+        "drop div.sidebar",
+        "candidate p#main source 1 passed 12.5",
+        "sanitize_drop form score -3",
+        "body div.a_very_long_class_na text 2345",
+        "done body 420 us"
+    };
+    string line;
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        FlightRecorder::format_event(events[i], line);
+        char document[16];
+        snprintf(document, sizeof(document), "%u ", events[i].document);
+        EXPECT_EQ(string(document) + expected[i], line);
+    }
+}
+
+TEST(FlightRecorder, ring)
+{
+    FlightRecorder& recorder = FlightRecorder::get_thread_recorder();
+    recorder.begin_document(0);
+    for (size_t i = 0; i < FlightRecorder::c_capacity + 10; ++i)
+    {
+        recorder.record(FLIGHT_DROP, TAG_DIV, NULL, NULL, 0, static_cast<double>(i));
+    }
+
+    // the oldest events are overwritten.
+    vector<FlightEvent> events;
+    recorder.get_events(events);
+    ASSERT_EQ(FlightRecorder::c_capacity, events.size());
+    EXPECT_EQ(10.0f, events[0].value);
+    EXPECT_EQ(static_cast<float>(FlightRecorder::c_capacity + 9), events.back().value);
+}
+
+struct WriterTask
+{
+    FlightRecorder* recorder;
+    int started;
+};
+
+static void* record_events(void* arg)
+{
+    WriterTask* task = static_cast<WriterTask*>(arg);
+    FlightRecorder& recorder = FlightRecorder::get_thread_recorder();
+    task->recorder = &recorder;
+    __atomic_store_n(&task->started, 1, __ATOMIC_RELEASE);
+    recorder.begin_document(0);
+    for (int i = 0; i < 20 * static_cast<int>(FlightRecorder::c_capacity); ++i)
+    {
+        // the class and the detail follow the value, a torn event wouldn't match.
+        char name[16];
+        snprintf(name, sizeof(name), "n%d", i);
+        recorder.record(FLIGHT_DROP, TAG_DIV, name, NULL, i & 0xff, static_cast<double>(i));
+    }
+
+    return NULL;
+}
+
+TEST(FlightRecorder, read_while_recording)
+{
+    WriterTask task = {NULL, 0};
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, record_events, &task));
+    while (__atomic_load_n(&task.started, __ATOMIC_ACQUIRE) == 0)
+    {
+    }
+
+    vector<FlightEvent> events;
+    for (int round = 0; round < 50; ++round)
+    {
+        task.recorder->get_events(events);
+        for (size_t i = 1; i < events.size(); ++i)
+        {
+            if (events[i].type != FLIGHT_DROP)
+            {
+                continue;
+            }
+
+            int value = static_cast<int>(events[i].value);
+            char name[16];
+            snprintf(name, sizeof(name), "n%d", value);
+            ASSERT_EQ(value & 0xff, events[i].detail);
+            ASSERT_EQ(0, strncmp(name, events[i].name, sizeof(events[i].name)));
+            // consecutive, nothing lost in the middle.
+            if (events[i - 1].type == FLIGHT_DROP)
+            {
+                ASSERT_EQ(events[i - 1].value + 1, events[i].value);
+            }
+        }
+    }
+
+    pthread_join(thread, NULL);
+}
+
+TEST(FlightRecorder, save_load)
+{
+    FlightRecorder& recorder = FlightRecorder::get_thread_recorder();
+    recorder.begin_document(0);
+    recorder.record(FLIGHT_BEST, TAG_TD, "content", NULL, 0, 7);
+    vector<FlightEvent> events;
+    recorder.get_events(events);
+
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file != NULL);
+    ASSERT_TRUE(FlightRecorder::save_all(file));
+    rewind(file);
+    vector<FlightThreadEvents> threads;
+    ASSERT_TRUE(FlightRecorder::load(file, threads));
+    fclose(file);
+
+    // every thread which recorded is there, this one with the same events.
+    bool found = false;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        if (threads[i].thread == recorder.get_thread_index())
+        {
+            found = true;
+            ASSERT_EQ(events.size(), threads[i].events.size());
+            EXPECT_EQ(0, memcmp(&events[0], &threads[i].events[0], events.size() * sizeof(FlightEvent)));
+        }
+    }
+
+    EXPECT_TRUE(found);
+    EXPECT_GE(threads.size(), 2u);
+
+    file = tmpfile();
+    fputs("not a flight file", file);
+    rewind(file);
+    EXPECT_FALSE(FlightRecorder::load(file, threads));
+    fclose(file);
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,268 @@
+#include "gtest/gtest.h"
+
+#include "html_parser.h"
+#include "charset.h"
+#include "dom_arena.h"
+#include "dom_tree.h"
+#include "flat_dom.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// same format as print_dom in list_page_classifier_test, with class and id.
+void print_dom(const DomNode* node, stringstream& text)
+{
+    const char* parent_tag = node->get_parent() != NULL ? node->get_parent()->get_tag() : "NULL";
+    text << node->get_tag() << "," << parent_tag << "," << node->get_text() << "," << (int)node->get_children()->size() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        print_dom((*node->get_children())[i], text);
+    }
+}
+
+string parse_and_print(const char* html)
+{
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html, strlen(html));
+    stringstream text;
+    if (dom != NULL)
+    {
+        print_dom(dom, text);
+        delete dom;
+    }
+
+    return text.str();
+}
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+TEST(HtmlParser, text_and_tail)
+{
+    // tails of children are merged into the parent's text, like the lxml bridge does.
+    const char* html = "<html><div>a<b>xxx</b>yyy<c>zzz</c>aaa</div></html>";
+    const char* printed =
+        "html,NULL,,1,,\n"
+        "div,html,ayyyaaa,2,,\n"
+        "b,div,xxx,0,,\n"
+        "c,div,zzz,0,,\n";
+    EXPECT_EQ(string(printed), parse_and_print(html));
+}
+
+TEST(HtmlParser, attributes)
+{
+    const char* html = "<HTML><DIV Class=\"main body\" id='x&amp;y' data-x=1 class=\"dup\" hidden>t</DIV></HTML>";
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html, strlen(html));
+    ASSERT_TRUE(dom != NULL);
+    ASSERT_EQ(1u, dom->get_children()->size());
+    DomNode* div = (*dom->get_children())[0];
+    EXPECT_STREQ("div", div->get_tag());
+    EXPECT_STREQ("main body", div->get_attribute("class"));
+    EXPECT_STREQ("x&y", div->get_attribute("id"));
+    EXPECT_STREQ("1", div->get_attribute("data-x"));
+    EXPECT_STREQ("", div->get_attribute("hidden"));
+    EXPECT_STREQ("", dom->get_attribute("class"));
+    EXPECT_STREQ("", dom->get_attribute("id"));
+    delete dom;
+}
+
+TEST(HtmlParser, implied_structure)
+{
+    // implicit root, void tags, self closing tags, implied end tags and stray end tags.
+    const char* html = "hello<p>one<p>two<br>three<ul><li>a<li>b</ul><div/>x</span></body>tail";
+    const char* printed =
+        "html,NULL,helloxtail,4,,\n"
+        "p,html,one,0,,\n"
+        "p,html,twothree,1,,\n"
+        "br,p,,0,,\n"
+        "ul,html,,2,,\n"
+        "li,ul,a,0,,\n"
+        "li,ul,b,0,,\n"
+        "div,html,,0,,\n";
+    EXPECT_EQ(string(printed), parse_and_print(html));
+}
+
+TEST(HtmlParser, raw_text)
+{
+    const char* html = "<html>\n<head>\n<title>a &lt; b</title>\n<script>if (a<b && c) {}</scrip></script>\n</head><!-- <p>comment</p> --><body><![CDATA[x]]>1 &gt; 0 &#x4e2d;&#20013; &nbsp &bogus;</body></html>";
+    const char* printed =
+        "html,NULL,,2,,\n"
+        "head,html,,2,,\n"
+        "title,head,a < b,0,,\n"
+        "script,head,if (a<b && c) {}</scrip>,0,,\n"
+        "body,html,1 > 0 \xe4\xb8\xad\xe4\xb8\xad \xc2\xa0 &bogus;,0,,\n";
+    EXPECT_EQ(string(printed), parse_and_print(html));
+}
+
+TEST(HtmlParser, serialize)
+{
+    const char* html = "<html><body><div class=\"a\">x &amp; y<br><p id=\"p\">z</p></div></body></html>";
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html, strlen(html));
+    ASSERT_TRUE(dom != NULL);
+    string output;
+    serialize_html(dom, output);
+    EXPECT_EQ(string(html), output);
+    delete dom;
+}
+
+TEST(HtmlParser, serialize_kept)
+{
+    const char* html = "<html><body><div class=\"a\">x<br><p id=\"p\">z</p></div><p>w</p></body></html>";
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html, strlen(html));
+    ASSERT_TRUE(dom != NULL);
+    FlatDom flat_dom;
+    flat_dom.build(dom);
+    FlatDomMask kept;
+    kept.assign(flat_dom.size(), true);
+
+    string output;
+    serialize_html(flat_dom, 0, kept, output);
+    EXPECT_EQ(string(html), output);
+
+    // the subtree of a node which is not kept is left out.
+    kept.erase(2, flat_dom.get_subtree_end(2));
+    output.clear();
+    serialize_html(flat_dom, 0, kept, output);
+    EXPECT_EQ("<html><body><p>w</p></body></html>", output);
+
+    output.clear();
+    serialize_html(flat_dom, 1, kept, output);
+    EXPECT_EQ("<body><p>w</p></body>", output);
+
+    // the tree is untouched.
+    output.clear();
+    serialize_html(dom, output);
+    EXPECT_EQ(string(html), output);
+    delete dom;
+}
+
+TEST(HtmlParser, fixture)
+{
+    string html = read_file("sina.html");
+    ASSERT_FALSE(html.empty());
+
+    HtmlParser parser;
+    DomNode* dom = parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+    EXPECT_STREQ("html", dom->get_tag());
+
+    vector<DomNode*> bodies;
+    dom->find_tags("body", bodies);
+    EXPECT_EQ(1u, bodies.size());
+
+    vector<DomNode*> headers;
+    dom->find_tags("h1", headers);
+    EXPECT_EQ(1u, headers.size());
+    delete dom;
+}
+
+TEST(HtmlParser, to_utf8)
+{
+    // sina.html is gb2312, its tree is the same as before with the text in utf-8.
+    string html = read_file("sina.html");
+    ASSERT_FALSE(html.empty());
+
+    HtmlParser parser;
+    HtmlParser utf8_parser(SI_AUTO, true);
+    DomNode* dom = parser.parse(html);
+    DomNode* utf8_dom = utf8_parser.parse(html);
+    ASSERT_TRUE(dom != NULL);
+    ASSERT_TRUE(utf8_dom != NULL);
+
+    vector<DomNode*> headers;
+    vector<DomNode*> utf8_headers;
+    dom->find_tags("h1", headers);
+    utf8_dom->find_tags("h1", utf8_headers);
+    ASSERT_EQ(1u, headers.size());
+    ASSERT_EQ(1u, utf8_headers.size());
+    string header = headers[0]->get_text();
+    string utf8_header;
+    convert_to_utf8(header.data(), header.size(), CHARSET_GBK, utf8_header);
+    EXPECT_EQ(utf8_header, utf8_headers[0]->get_text());
+    EXPECT_NE(header, utf8_header);
+
+    // the arena converts the same.
+    DomArena arena;
+    DomNode* arena_dom = utf8_parser.parse(html.data(), html.size(), arena);
+    ASSERT_TRUE(arena_dom != NULL);
+    stringstream expected;
+    stringstream text;
+    print_dom(utf8_dom, expected);
+    print_dom(arena_dom, text);
+    EXPECT_EQ(expected.str(), text.str());
+
+    delete dom;
+    delete utf8_dom;
+}
+
+bool in_buffer(const char* p, const string& buffer)
+{
+    return p >= buffer.data() && p < buffer.data() + buffer.size();
+}
+
+void check_views(const DomNode* node, const string& buffer)
+{
+    EXPECT_TRUE(in_buffer(node->get_tag(), buffer) || strcmp(node->get_tag(), "html") == 0) << node->get_tag();
+    for (size_t i = 0; i < node->get_text_piece_count(); ++i)
+    {
+        StringPiece piece = node->get_text_piece(i);
+        EXPECT_TRUE(in_buffer(piece.data(), buffer) || piece.equals("<"));
+        EXPECT_EQ('\0', piece.data()[piece.size()]);
+    }
+
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        check_views((*node->get_children())[i], buffer);
+    }
+}
+
+TEST(HtmlParser, parse_in_place)
+{
+    const char* file_names[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(file_names) / sizeof(file_names[0]); ++i)
+    {
+        string html = read_file(file_names[i]);
+        ASSERT_FALSE(html.empty());
+
+        HtmlParser parser;
+        DomNode* copied = parser.parse(html);
+        ASSERT_TRUE(copied != NULL);
+        stringstream expected;
+        print_dom(copied, expected);
+        string expected_html;
+        serialize_html(copied, expected_html);
+        delete copied;
+
+        // html[length] is written by the parser.
+        string buffer(html);
+        buffer.push_back('\0');
+        DomNode* viewed = parser.parse_in_place(&buffer[0], html.size());
+        ASSERT_TRUE(viewed != NULL);
+        stringstream actual;
+        print_dom(viewed, actual);
+        string actual_html;
+        serialize_html(viewed, actual_html);
+        check_views(viewed, buffer);
+        delete viewed;
+
+        EXPECT_EQ(expected.str(), actual.str()) << file_names[i];
+        EXPECT_EQ(expected_html, actual_html) << file_names[i];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+#include "html_scanner.h"
+#include "html_parser.h"
+#include "dom_tree.h"
+#include "dom_arena.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <time.h>
+#include <new>
+
+using namespace std;
+
+// throughput of the structural scanner and the whole parser on the fixture pages.
+// usage: html_scanner_benchmark [iterations] [files...]
+
+// allocations per parse, to compare copied and in place trees.
+static size_t s_allocation_count = 0;
+
+void* operator new(size_t size)
+{
+    ++s_allocation_count;
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double megabytes_per_second(size_t bytes, int iterations, double seconds)
+{
+    return bytes * static_cast<double>(iterations) / (1024.0 * 1024.0) / seconds;
+}
+
+void benchmark(const char* file_name, int iterations)
+{
+    string html = read_file(file_name);
+    if (html.empty())
+    {
+        printf("can't read %s\n", file_name);
+        return;
+    }
+
+    for (int isa = SI_SCALAR; isa < SI_TOTAL_ISA_COUNT; ++isa)
+    {
+        if (!HtmlStructuralIndex::isa_supported(isa))
+        {
+            continue;
+        }
+
+        HtmlStructuralIndex index;
+        double start = now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            index.build(html.data(), html.size(), isa);
+        }
+
+        double scan_seconds = now() - start;
+
+        HtmlParser parser(isa);
+        size_t allocation_count = s_allocation_count;
+        start = now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            delete parser.parse(html);
+        }
+
+        double parse_seconds = now() - start;
+        size_t parse_allocations = (s_allocation_count - allocation_count) / iterations;
+
+        // the buffer is restored from html before each parse, the copy is timed as well.
+        string buffer;
+        allocation_count = s_allocation_count;
+        start = now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            buffer.assign(html.data(), html.size() + 1);
+            delete parser.parse_in_place(&buffer[0], html.size());
+        }
+
+        double in_place_seconds = now() - start;
+        size_t in_place_allocations = (s_allocation_count - allocation_count) / iterations;
+
+        // the arena is warmed by the first document, teardown is a reset.
+        DomArena arena;
+        parser.parse(html.data(), html.size(), arena);
+        allocation_count = s_allocation_count;
+        start = now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            arena.reset();
+            parser.parse(html.data(), html.size(), arena);
+        }
+
+        double arena_seconds = now() - start;
+        size_t arena_allocations = (s_allocation_count - allocation_count) / iterations;
+
+        printf("%-16s %-8s scan %10.1f MB/s  parse %8.1f MB/s %7d allocs  in place %8.1f MB/s %7d allocs  arena %8.1f MB/s %7d allocs\n",
+            file_name, HtmlStructuralIndex::isa_name(isa), megabytes_per_second(html.size(), iterations, scan_seconds),
+            megabytes_per_second(html.size(), iterations, parse_seconds), static_cast<int>(parse_allocations),
+            megabytes_per_second(html.size(), iterations, in_place_seconds), static_cast<int>(in_place_allocations),
+            megabytes_per_second(html.size(), iterations, arena_seconds), static_cast<int>(arena_allocations));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            benchmark(argv[i], iterations);
+        }
+    }
+    else
+    {
+        benchmark("sina.html", iterations);
+        benchmark("news.ori.html", iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+
+#include "html_scanner.h"
+#include "html_parser.h"
+#include "dom_tree.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+string read_file(const char* file_name)
+{
+    ifstream file(file_name, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void print_dom(const DomNode* node, stringstream& text)
+{
+    const char* parent_tag = node->get_parent() != NULL ? node->get_parent()->get_tag() : "NULL";
+    text << node->get_tag() << "," << parent_tag << "," << node->get_text() << "," << (int)node->get_children()->size() << "," << node->get_attribute("class") << "," << node->get_attribute("id") << endl;
+    for (size_t i = 0; i < node->get_children()->size(); ++i)
+    {
+        print_dom((*node->get_children())[i], text);
+    }
+}
+
+bool is_text_stop(char c)
+{
+    return c == '<' || c == '&';
+}
+
+bool is_tag_stop(char c)
+{
+    return static_cast<unsigned char>(c) <= 0x20 || strchr("<>/=\"'&", c) != NULL;
+}
+
+// compare the index of every isa with a byte by byte reference.
+void check_index(const string& data)
+{
+    for (int isa = SI_SCALAR; isa < SI_TOTAL_ISA_COUNT; ++isa)
+    {
+        if (!HtmlStructuralIndex::isa_supported(isa))
+        {
+            continue;
+        }
+
+        HtmlStructuralIndex index;
+        index.build(data.data(), data.size(), isa);
+        ASSERT_EQ(data.size(), index.length());
+
+        size_t text_stop = index.next_text_stop(0);
+        size_t tag_stop = index.next_tag_stop(0);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            if (is_text_stop(data[i]))
+            {
+                ASSERT_EQ(i, text_stop) << HtmlStructuralIndex::isa_name(isa) << " " << data.size();
+                text_stop = index.next_text_stop(i + 1);
+            }
+
+            if (is_tag_stop(data[i]))
+            {
+                ASSERT_EQ(i, tag_stop) << HtmlStructuralIndex::isa_name(isa) << " " << data.size();
+                tag_stop = index.next_tag_stop(i + 1);
+            }
+        }
+
+        EXPECT_EQ(data.size(), text_stop);
+        EXPECT_EQ(data.size(), tag_stop);
+    }
+}
+
+TEST(HtmlStructuralIndex, random)
+{
+    const char alphabet[] = "<>&/=\"' \t\r\nab\x80\xff\x01";
+    srand(42);
+    for (size_t length = 0; length < 300; ++length)
+    {
+        string data;
+        for (size_t i = 0; i < length; ++i)
+        {
+            data.push_back(alphabet[rand() % (sizeof(alphabet) - 1)]);
+        }
+
+        check_index(data);
+    }
+}
+
+TEST(HtmlStructuralIndex, fixtures)
+{
+    const char* files[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+    {
+        string html = read_file(files[i]);
+        ASSERT_FALSE(html.empty());
+        check_index(html);
+    }
+}
+
+// dom trees built with every isa should be the same.
+TEST(HtmlStructuralIndex, dom_tree)
+{
+    const char* files[] = {"sina.html", "news.ori.html"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+    {
+        string html = read_file(files[i]);
+        stringstream expected;
+        DomNode* dom = HtmlParser(SI_SCALAR).parse(html);
+        ASSERT_TRUE(dom != NULL);
+        print_dom(dom, expected);
+        delete dom;
+
+        for (int isa = SI_SCALAR + 1; isa < SI_TOTAL_ISA_COUNT; ++isa)
+        {
+            if (!HtmlStructuralIndex::isa_supported(isa))
+            {
+                continue;
+            }
+
+            stringstream text;
+            dom = HtmlParser(isa).parse(html);
+            ASSERT_TRUE(dom != NULL);
+            print_dom(dom, text);
+            delete dom;
+            EXPECT_TRUE(expected.str() == text.str()) << files[i] << " " << HtmlStructuralIndex::isa_name(isa);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+
+#include "html_tags.h"
+#include "dom_tree.h"
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+TEST(HtmlTags, lookup)
+{
+    // every known tag is in its slot.
+    for (int i = TAG_UNKNOWN + 1; i < TAG_COUNT; ++i)
+    {
+        HtmlTag tag = static_cast<HtmlTag>(i);
+        const char* name = get_html_tag_name(tag);
+        ASSERT_TRUE(name != NULL);
+        EXPECT_EQ(tag, lookup_html_tag(name)) << name;
+        EXPECT_EQ(tag, lookup_html_tag(name, strlen(name))) << name;
+    }
+
+    EXPECT_EQ(TAG_A, lookup_html_tag("a"));
+    EXPECT_EQ(TAG_DIV, lookup_html_tag("div"));
+    EXPECT_EQ(TAG_H1, lookup_html_tag("h1"));
+    EXPECT_TRUE(get_html_tag_name(TAG_UNKNOWN) == NULL);
+
+    // no prefix or case insensitive matches.
+    EXPECT_EQ(TAG_ABBR, lookup_html_tag("abbr"));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag("ab"));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag("DIV"));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag("divx"));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag("body1"));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag(""));
+    EXPECT_EQ(TAG_UNKNOWN, lookup_html_tag("blockquotes"));
+    EXPECT_EQ(TAG_P, lookup_html_tag("pre", 1));
+}
+
+TEST(HtmlTags, attributes)
+{
+    for (int i = ATTR_UNKNOWN + 1; i < ATTR_COUNT; ++i)
+    {
+        HtmlAttribute attribute = static_cast<HtmlAttribute>(i);
+        const char* name = get_html_attribute_name(attribute);
+        ASSERT_TRUE(name != NULL);
+        EXPECT_EQ(attribute, lookup_html_attribute(name)) << name;
+    }
+
+    EXPECT_EQ(ATTR_CLASS, lookup_html_attribute("class"));
+    EXPECT_EQ(ATTR_ID, lookup_html_attribute("id"));
+    EXPECT_EQ(ATTR_ID, lookup_html_attribute("idx", 2));
+    EXPECT_EQ(ATTR_UNKNOWN, lookup_html_attribute("i"));
+    EXPECT_EQ(ATTR_UNKNOWN, lookup_html_attribute("classes"));
+    EXPECT_EQ(ATTR_UNKNOWN, lookup_html_attribute("data-x"));
+    EXPECT_EQ(ATTR_UNKNOWN, lookup_html_attribute(""));
+}
+
+TEST(HtmlTags, tag_set)
+{
+    HtmlTag tags[] = {TAG_A, TAG_WBR, TAG_DIV};
+    HtmlTagSet set(tags, sizeof(tags) / sizeof(tags[0]));
+    EXPECT_TRUE(set.contains(TAG_A));
+    EXPECT_TRUE(set.contains(TAG_WBR));
+    EXPECT_TRUE(set.contains(TAG_DIV));
+    EXPECT_FALSE(set.contains(TAG_ABBR));
+    EXPECT_FALSE(set.contains(TAG_UNKNOWN));
+    EXPECT_FALSE(set.empty());
+    EXPECT_TRUE(HtmlTagSet().empty());
+}
+
+TEST(HtmlTags, dom_node)
+{
+    DomNode node(string("article"), string(""));
+    EXPECT_EQ(TAG_ARTICLE, node.get_tag_atom());
+    node.set_tag("a");
+    EXPECT_EQ(TAG_A, node.get_tag_atom());
+    node.set_tag("x-custom");
+    EXPECT_EQ(TAG_UNKNOWN, node.get_tag_atom());
+
+    DomNode view("span");
+    EXPECT_EQ(TAG_SPAN, view.get_tag_atom());
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
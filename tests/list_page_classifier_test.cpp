@@ -239,6 +239,43 @@ protected:
         delete dom;
     }
 
+    void test_flat_traverse()
+    {
+        DomNode* dom = create_dom_tree(default_html);
+        FlatDom flat_dom;
+        flat_dom.build(dom);
+
+        vector<int> features(ListPageClassifier::IFN_TOTAL_FEATURE_COUNT, 0);
+        m_classifier.traverse(flat_dom, features);
+        int results[] = {12, 35, 2};
+        vector<int> results_vector(results, results + sizeof(results) / sizeof(int));
+        compare_vector(results_vector, features);
+
+        EXPECT_EQ(this->m_classifier.classify(dom, default_url), this->m_classifier.classify(flat_dom, default_url));
+        delete dom;
+    }
+
+    void test_feature_visitor()
+    {
+        DomNode* dom = create_dom_tree(default_html);
+        ListPageClassifier::FeatureVisitor visitor(&this->m_classifier);
+        DomNode* other = create_dom_tree(default_html);
+        DomTreeVisitor other_visitor;
+
+        // fused with another visitor, the same features as the traversal of the classifier.
+        typedef FusedDomTreeVisitor<DomTreeVisitor, ListPageClassifier::FeatureVisitor> FusedVisitor;
+        FusedVisitor fused_visitor(other_visitor, visitor);
+        DomTraversalStack stack;
+        EXPECT_TRUE(DomTreeTraversal<FusedVisitor>::postorder(dom, fused_visitor, stack));
+        int results[] = {12, 35, 2};
+        vector<int> results_vector(results, results + sizeof(results) / sizeof(int));
+        compare_vector(results_vector, visitor.get_features());
+
+        EXPECT_EQ(this->m_classifier.classify(other, default_url), this->m_classifier.classify(visitor, default_url));
+        delete dom;
+        delete other;
+    }
+
     void test_extract_features()
     {
         DomNode* dom = create_dom_tree(default_html);
@@ -303,6 +340,16 @@ TEST_F(ListPageClassifierTest, traverse)
     test_traverse();
 }
 
+TEST_F(ListPageClassifierTest, flat_traverse)
+{
+    test_flat_traverse();
+}
+
+TEST_F(ListPageClassifierTest, feature_visitor)
+{
+    test_feature_visitor();
+}
+
 TEST_F(ListPageClassifierTest, calculate_features)
 {
     test_calculate_features();
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include "log.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+// the messages written to a temporary file while it lives, the defaults are back after.
+class LogTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        this->m_file = tmpfile();
+        ASSERT_TRUE(this->m_file != NULL);
+        set_log_file(this->m_file);
+    }
+
+    virtual void TearDown()
+    {
+        set_log_file(NULL);
+        set_log_level(LOG_LEVEL_INFO);
+        set_log_categories(LOG_ALL_CATEGORIES);
+        fclose(this->m_file);
+    }
+
+    string read_log()
+    {
+        string text;
+        fflush(this->m_file);
+        rewind(this->m_file);
+        char buffer[256];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), this->m_file)) > 0)
+        {
+            text.append(buffer, size);
+        }
+
+        return text;
+    }
+
+    FILE* m_file;
+};
+
+static int count_call(int& count)
+{
+    return ++count;
+}
+
+TEST_F(LogTest, levels)
+{
+    int count = 0;
+    ERROR_LOG(LOG_CONFIG, "bad " << count_call(count));
+    INFO_LOG(LOG_CONFIG, "info " << 2);
+    // not written, and not formatted.
+    set_log_level(LOG_LEVEL_WARNING);
+    INFO_LOG(LOG_CONFIG, "info " << count_call(count));
+    WARNING_LOG(LOG_CONFIG, "warning");
+    set_log_level(LOG_LEVEL_NONE);
+    ERROR_LOG(LOG_CONFIG, "none " << count_call(count));
+
+    EXPECT_EQ(1, count);
+    EXPECT_EQ("error: bad 1\ninfo: info 2\nwarning: warning\n", read_log());
+}
+
+TEST_F(LogTest, categories)
+{
+    set_log_categories(LOG_DOM | LOG_EXTRACT);
+    ERROR_LOG(LOG_CONFIG, "config");
+    ERROR_LOG(LOG_DOM, "dom");
+    ERROR_LOG(LOG_EXTRACT, "extract");
+    EXPECT_FALSE(log_enabled(LOG_LEVEL_ERROR, LOG_CLASSIFY));
+    EXPECT_EQ("error: dom\nerror: extract\n", read_log());
+}
+
+TEST_F(LogTest, compiled_out)
+{
+    // above LOG_MAX_LEVEL, which is info in the tests, the arguments are not even evaluated.
+    ASSERT_EQ(LOG_LEVEL_INFO, LOG_MAX_LEVEL);
+    set_log_level(LOG_LEVEL_TRACE);
+    int count = 0;
+    DEBUG_LOG(LOG_DOM, "debug " << count_call(count));
+    TRACE_LOG(LOG_DOM, "trace " << count_call(count));
+    EXPECT_EQ(0, count);
+    EXPECT_TRUE(log_enabled(LOG_LEVEL_TRACE, LOG_DOM));
+    EXPECT_FALSE(LOG_ENABLED(LOG_LEVEL_TRACE, LOG_DOM));
+    EXPECT_EQ("", read_log());
+}
+
+TEST_F(LogTest, null_string)
+{
+    const char* missing = NULL;
+    INFO_LOG(LOG_DOM, "class " << log_string(missing) << " id " << log_string("a"));
+    EXPECT_EQ("info: class (null) id a\n", read_log());
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include "stage_stats.h"
+
+#include <string>
+#include <pthread.h>
+
+using namespace std;
+
+TEST(StageStats, buckets)
+{
+    // the buckets cover all values in order, without gaps.
+    EXPECT_EQ(0u, StageSnapshot::get_bucket_low(0));
+    for (int bucket = 0; bucket < StageSnapshot::c_bucket_count; ++bucket)
+    {
+        uint64_t low = StageSnapshot::get_bucket_low(bucket);
+        uint64_t high = StageSnapshot::get_bucket_high(bucket);
+        ASSERT_LE(low, high) << bucket;
+        EXPECT_EQ(bucket, StageSnapshot::get_bucket(low)) << bucket;
+        EXPECT_EQ(bucket, StageSnapshot::get_bucket(high)) << bucket;
+        if (bucket + 1 < StageSnapshot::c_bucket_count)
+        {
+            EXPECT_EQ(high + 1, StageSnapshot::get_bucket_low(bucket + 1)) << bucket;
+        }
+        else
+        {
+            EXPECT_EQ(~static_cast<uint64_t>(0), high);
+        }
+    }
+}
+
+TEST(StageStats, percentiles)
+{
+    StageSnapshot before;
+    before.take();
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        record_value(COUNT_CANDIDATES, i * 1000);
+    }
+
+    StageSnapshot after;
+    after.take();
+    after.subtract(before);
+    EXPECT_EQ(1000u, after.get_count(COUNT_CANDIDATES));
+    EXPECT_EQ(500500000u, after.get_sum(COUNT_CANDIDATES));
+    EXPECT_NEAR(500000.0, static_cast<double>(after.get_percentile(COUNT_CANDIDATES, 0.5)), 500000.0 / 8);
+    EXPECT_NEAR(990000.0, static_cast<double>(after.get_percentile(COUNT_CANDIDATES, 0.99)), 990000.0 / 8);
+    EXPECT_EQ(0u, after.get_percentile(STAGE_PREDICT, 0.5));
+
+    // small values are exact.
+    before.take();
+    record_value(COUNT_NODES, 3);
+    after.take();
+    after.subtract(before);
+    EXPECT_EQ(3u, after.get_percentile(COUNT_NODES, 0.99));
+
+    string text;
+    after.write(text);
+    EXPECT_NE(string::npos, text.find("nodes"));
+    EXPECT_EQ(string::npos, text.find("candidates"));
+}
+
+static void* record_values(void* arg)
+{
+    (void)arg;
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t start = stage_now();
+        record_stage(STAGE_TRAVERSE, start);
+        record_value(COUNT_NODES, 10);
+    }
+
+    return NULL;
+}
+
+TEST(StageStats, threads)
+{
+    StageSnapshot before;
+    before.take();
+
+    // the stats of threads which are gone are still counted.
+    for (int round = 0; round < 2; ++round)
+    {
+        const int c_thread_count = 4;
+        pthread_t threads[c_thread_count];
+        for (int i = 0; i < c_thread_count; ++i)
+        {
+            ASSERT_EQ(0, pthread_create(&threads[i], NULL, record_values, NULL));
+        }
+
+        for (int i = 0; i < c_thread_count; ++i)
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    StageSnapshot after;
+    after.take();
+    after.subtract(before);
+    EXPECT_EQ(8000u, after.get_count(STAGE_TRAVERSE));
+    EXPECT_EQ(8000u, after.get_count(COUNT_NODES));
+    EXPECT_EQ(80000u, after.get_sum(COUNT_NODES));
+    EXPECT_EQ(10u, after.get_percentile(COUNT_NODES, 0.5));
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,265 @@
+#include "gtest/gtest.h"
+
+#include "substring_matcher.h"
+#include "utils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST(SubstringMatcher, match)
+{
+    const char* first_patterns[] = {"he", "she", "his", "hers"};
+    const char* second_patterns[] = {"rs", "ad_wrapper", "ad"};
+    vector<string> first(first_patterns, first_patterns + sizeof(first_patterns) / sizeof(first_patterns[0]));
+    vector<string> second(second_patterns, second_patterns + sizeof(second_patterns) / sizeof(second_patterns[0]));
+
+    SubstringMatcher matcher;
+    matcher.add_patterns(first, 1);
+    matcher.add_patterns(second, 4);
+    matcher.build();
+
+    EXPECT_EQ(0u, matcher.match(""));
+    EXPECT_EQ(0u, matcher.match("xyz"));
+    EXPECT_EQ(1u, matcher.match("ushe"));
+    // through the failure links.
+    EXPECT_EQ(5u, matcher.match("ushers"));
+    EXPECT_EQ(4u, matcher.match("main_ad"));
+    EXPECT_EQ(1u, matcher.match("xhisx"));
+    EXPECT_EQ(0u, matcher.match("h"));
+    // case sensitive.
+    EXPECT_EQ(0u, matcher.match("HE"));
+    // only length bytes are scanned.
+    EXPECT_EQ(0u, matcher.match("ad", 1));
+}
+
+TEST(SubstringMatcher, empty)
+{
+    SubstringMatcher matcher;
+    matcher.build();
+    EXPECT_EQ(0u, matcher.match("abc"));
+
+    // an empty pattern matches everything, like match_list.
+    SubstringMatcher empty_matcher;
+    empty_matcher.add_patterns(vector<string>(1, ""), 2);
+    empty_matcher.build();
+    EXPECT_EQ(2u, empty_matcher.match(""));
+    EXPECT_EQ(2u, empty_matcher.match("abc"));
+}
+
+TEST(SubstringMatcher, match_list)
+{
+    // the same answers as match_list with random patterns and texts on a small alphabet.
+    srand(7);
+    for (int round = 0; round < 50; ++round)
+    {
+        vector<vector<string> > lists(4);
+        SubstringMatcher matcher;
+        for (size_t i = 0; i < lists.size(); ++i)
+        {
+            int count = rand() % 6;
+            for (int j = 0; j < count; ++j)
+            {
+                string pattern;
+                int length = 1 + rand() % 4;
+                for (int k = 0; k < length; ++k)
+                {
+                    pattern += static_cast<char>('a' + rand() % 3);
+                }
+
+                lists[i].push_back(pattern);
+            }
+
+            matcher.add_patterns(lists[i], 1u << i);
+        }
+
+        matcher.build();
+        for (int j = 0; j < 100; ++j)
+        {
+            string text;
+            int length = rand() % 12;
+            for (int k = 0; k < length; ++k)
+            {
+                text += static_cast<char>('a' + rand() % 4);
+            }
+
+            uint32_t expected = 0;
+            for (size_t i = 0; i < lists.size(); ++i)
+            {
+                if (match_list(text.c_str(), lists[i], 2) >= 0)
+                {
+                    expected |= 1u << i;
+                }
+            }
+
+            ASSERT_EQ(expected, matcher.match(text.c_str())) << text;
+        }
+    }
+}
+
+TEST(SubstringMatchCache, match)
+{
+    const char* patterns[] = {"ad", "nav"};
+    SubstringMatcher matcher;
+    matcher.add_patterns(vector<string>(patterns, patterns + 2), 1);
+    matcher.build();
+
+    SubstringMatchCache cache(&matcher);
+    EXPECT_EQ(1u, cache.match("ad_wrapper"));
+    EXPECT_EQ(0u, cache.match("content"));
+    EXPECT_EQ(1u, cache.match("ad_wrapper"));
+    // a prefix of a cached value is another value.
+    EXPECT_EQ(1u, cache.match("ad_wrapper", 2));
+    EXPECT_EQ(0u, cache.match("ad_wrapper", 1));
+    EXPECT_EQ(5u, cache.get_lookup_count());
+    EXPECT_EQ(1u, cache.get_hit_count());
+
+    // empty values are not looked up.
+    EXPECT_EQ(0u, cache.match(""));
+    EXPECT_EQ(5u, cache.get_lookup_count());
+
+    // the counters go on across documents.
+    cache.clear();
+    EXPECT_EQ(1u, cache.match("ad_wrapper"));
+    EXPECT_EQ(6u, cache.get_lookup_count());
+    EXPECT_EQ(1u, cache.get_hit_count());
+}
+
+TEST(SubstringMatchCache, grow)
+{
+    const char* patterns[] = {"7", "13"};
+    SubstringMatcher matcher;
+    matcher.add_patterns(vector<string>(patterns, patterns + 1), 1);
+    matcher.add_patterns(vector<string>(patterns + 1, patterns + 2), 2);
+    matcher.build();
+
+    // the same answers as the matcher, for many more values than the first table holds.
+    SubstringMatchCache cache(&matcher);
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            char text[16];
+            snprintf(text, sizeof(text), "c%d", i);
+            ASSERT_EQ(matcher.match(text), cache.match(text)) << text;
+        }
+    }
+
+    EXPECT_EQ(2000u, cache.get_lookup_count());
+    EXPECT_EQ(1000u, cache.get_hit_count());
+}
+
+TEST(SharedSubstringMatchCache, match)
+{
+    const char* patterns[] = {"ad", "nav"};
+    SubstringMatcher matcher;
+    matcher.add_patterns(vector<string>(patterns, patterns + 1), 1);
+    matcher.build();
+    SubstringMatcher other_matcher;
+    other_matcher.add_patterns(vector<string>(patterns + 1, patterns + 2), 1);
+    other_matcher.build();
+    EXPECT_NE(matcher.get_fingerprint(), other_matcher.get_fingerprint());
+
+    SharedSubstringMatchCache shared(64);
+    EXPECT_EQ(1u, shared.match(&matcher, "ad_nav", 6));
+    EXPECT_EQ(1u, shared.match(&matcher, "ad_nav", 6));
+    // the verdicts of other patterns are kept apart.
+    EXPECT_EQ(1u, shared.match(&other_matcher, "ad_nav", 6));
+    EXPECT_EQ(0u, shared.match(&other_matcher, "ad", 2));
+    EXPECT_EQ(4u, shared.get_lookup_count());
+    EXPECT_EQ(1u, shared.get_hit_count());
+
+    // the documents of another cache find what the first one matched.
+    SubstringMatchCache first(&matcher, &shared);
+    SubstringMatchCache second(&matcher, &shared);
+    EXPECT_EQ(0u, first.match("content"));
+    EXPECT_EQ(0u, second.match("content"));
+    EXPECT_EQ(2u, shared.get_hit_count());
+
+    shared.clear();
+    EXPECT_EQ(1u, shared.match(&matcher, "ad_nav", 6));
+    EXPECT_EQ(2u, shared.get_hit_count());
+}
+
+TEST(SharedSubstringMatchCache, evict)
+{
+    const char* patterns[] = {"7"};
+    SubstringMatcher matcher;
+    matcher.add_patterns(vector<string>(patterns, patterns + 1), 1);
+    matcher.build();
+
+    // many more values than the capacity, the answers stay right.
+    SharedSubstringMatchCache shared(64);
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            char text[16];
+            int length = snprintf(text, sizeof(text), "c%d", i);
+            ASSERT_EQ(matcher.match(text), shared.match(&matcher, text, static_cast<size_t>(length))) << text;
+        }
+    }
+
+    EXPECT_LT(shared.get_hit_count(), 2000u);
+}
+
+struct SharedMatchTask
+{
+    const SubstringMatcher* matcher;
+    SharedSubstringMatchCache* shared;
+    int mismatch_count;
+};
+
+static void* run_shared_match_task(void* arg)
+{
+    SharedMatchTask* task = static_cast<SharedMatchTask*>(arg);
+    for (int i = 0; i < 20000; ++i)
+    {
+        char text[16];
+        int length = snprintf(text, sizeof(text), "c%d", i % 300);
+        if (task->shared->match(task->matcher, text, static_cast<size_t>(length)) != task->matcher->match(text))
+        {
+            ++task->mismatch_count;
+        }
+    }
+
+    return NULL;
+}
+
+TEST(SharedSubstringMatchCache, threads)
+{
+    const char* patterns[] = {"7", "13"};
+    SubstringMatcher matcher;
+    matcher.add_patterns(vector<string>(patterns, patterns + 2), 1);
+    matcher.build();
+
+    SharedSubstringMatchCache shared(256);
+    SharedMatchTask tasks[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        tasks[i].matcher = &matcher;
+        tasks[i].shared = &shared;
+        tasks[i].mismatch_count = 0;
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, run_shared_match_task, &tasks[i]));
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        EXPECT_EQ(0, tasks[i].mismatch_count);
+    }
+
+    EXPECT_EQ(80000u, shared.get_lookup_count());
+    EXPECT_GT(shared.get_hit_count(), 0u);
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
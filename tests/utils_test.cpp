@@ -133,6 +133,73 @@ TEST(count_without_spaces, main)
     }
 }
 
+TEST(count_text, main)
+{
+    // nbsp, U+3000 and the zero width space are spaces, invalid bytes count one each.
+    // the byte count only leaves out ascii spaces.
+    const string strs[] = {"", "a, b", "\xc2\xa0\xe3\x80\x80\xe2\x80\x8b", "\xe5\xaf\xbc\xe8\x88\xaa\xef\xbc\x8c\xe6\x96\xb0\xe9\x97\xbb\xe3\x80\x82",
+        "\xe5\xaf", "\xc0\xaf\xed\xa0\x80", "\xf0\x9f\x98\x80x", "\xe5\xa5\xbd\xef\xbc\x81\xe5\x90\x97\xef\xbc\x9f\xe3\x80\x81"};
+    int non_space_counts[] = {0, 3, 0, 6, 2, 5, 2, 5};
+    int non_space_byte_counts[] = {0, 3, 8, 18, 2, 5, 5, 15};
+    int comma_counts[] = {0, 1, 0, 1, 0, 0, 0, 1};
+    int stop_counts[] = {0, 0, 0, 1, 0, 0, 0, 2};
+    for (size_t i = 0; i < sizeof(strs) / sizeof(strs[0]); ++i)
+    {
+        TextStats stats;
+        count_text(strs[i].data(), strs[i].size(), stats);
+        EXPECT_EQ(non_space_counts[i], stats.non_space_count) << i;
+        EXPECT_EQ(non_space_byte_counts[i], stats.non_space_byte_count) << i;
+        EXPECT_EQ(comma_counts[i], stats.comma_count) << i;
+        EXPECT_EQ(stop_counts[i], stats.stop_count) << i;
+    }
+}
+
+TEST(count_text, blocks)
+{
+    // counted at once with the vector loop, or a code point at a time with the scalar one,
+    // wherever the text starts and ends.
+    string text;
+    for (int i = 0; i < 8; ++i)
+    {
+        text += "a b,\tcd\xe4\xb8\xad\xe3\x80\x81 efgh,ijklmnopqrstu\xc2\xa0\xe3\x80\x82\r\n";
+    }
+
+    vector<size_t> starts;
+    for (size_t i = 0; i <= text.size(); ++i)
+    {
+        if (i == text.size() || (static_cast<unsigned char>(text[i]) & 0xc0) != 0x80)
+        {
+            starts.push_back(i);
+        }
+    }
+
+    for (size_t i = 0; starts[i] < 40; ++i)
+    {
+        for (size_t j = i; j < starts.size(); j += 3)
+        {
+            TextStats stats;
+            count_text(text.data() + starts[i], starts[j] - starts[i], stats);
+            TextStats code_point_stats;
+            for (size_t k = i; k < j; ++k)
+            {
+                count_text(text.data() + starts[k], starts[k + 1] - starts[k], code_point_stats);
+            }
+
+            EXPECT_EQ(code_point_stats.non_space_count, stats.non_space_count) << i << " " << j;
+            EXPECT_EQ(code_point_stats.non_space_byte_count, stats.non_space_byte_count) << i << " " << j;
+            EXPECT_EQ(code_point_stats.comma_count, stats.comma_count) << i << " " << j;
+            EXPECT_EQ(code_point_stats.stop_count, stats.stop_count) << i << " " << j;
+        }
+    }
+
+    TextStats stats;
+    count_text(text.data(), text.size(), stats);
+    EXPECT_EQ(8 * 26, stats.non_space_count);
+    EXPECT_EQ(8 * 34, stats.non_space_byte_count);
+    EXPECT_EQ(8 * 3, stats.comma_count);
+    EXPECT_EQ(8, stats.stop_count);
+}
+
 int main(int argc, char* argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,10 +1,18 @@
 #include "utils.h"
 
+#include <cstddef>
 #include <cstring>
 #include <algorithm>
 #include <cctype>
 #include <functional>
+#include <limits>
 #include <vector>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#define UTILS_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -104,28 +112,192 @@ int match_list(const char* str, const vector<string>& string_list, int pattern)
     return -1;
 }
 
-static const string g_spaces = std::string(" \r\t\n\x0c\x0d");
+static bool is_ascii_space(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\x0c' || c == '\r';
+}
 
-int count_without_spaces(const char* str)
+static bool is_unicode_space(uint32_t code_point)
+{
+    switch (code_point)
+    {
+    case 0xa0:
+    case 0x1680:
+    case 0x2028:
+    case 0x2029:
+    case 0x202f:
+    case 0x205f:
+    case 0x3000:
+    case 0xfeff:
+        return true;
+    default:
+        // the fixed width spaces and the zero width space.
+        return code_point >= 0x2000 && code_point <= 0x200b;
+    }
+}
+
+static bool is_cjk_comma(uint32_t code_point)
+{
+    return code_point == 0xff0c || code_point == 0x3001;
+}
+
+static bool is_cjk_stop(uint32_t code_point)
 {
-    int count = 0;
-    while (*str != '\0')
+    return code_point == 0x3002 || code_point == 0xff01 || code_point == 0xff1f;
+}
+
+size_t decode_utf8(const char* text, size_t text_length, uint32_t& code_point)
+{
+    const unsigned char* str = reinterpret_cast<const unsigned char*>(text);
+    size_t length;
+    uint32_t min_code_point;
+    if (text_length == 0)
     {
-        if ((unsigned char)(*str) <= 0xFF)
+        return 0;
+    }
+    else if (str[0] >= 0xc2 && str[0] <= 0xdf)
+    {
+        length = 2;
+        min_code_point = 0x80;
+        code_point = str[0] & 0x1f;
+    }
+    else if (str[0] >= 0xe0 && str[0] <= 0xef)
+    {
+        length = 3;
+        min_code_point = 0x800;
+        code_point = str[0] & 0x0f;
+    }
+    else if (str[0] >= 0xf0 && str[0] <= 0xf4)
+    {
+        length = 4;
+        min_code_point = 0x10000;
+        code_point = str[0] & 0x07;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (text_length < length)
+    {
+        return 0;
+    }
+
+    for (size_t i = 1; i < length; ++i)
+    {
+        if ((str[i] & 0xc0) != 0x80)
         {
-            if (g_spaces.find_first_of(*str) == std::string::npos)
+            return 0;
+        }
+
+        code_point = (code_point << 6) | (str[i] & 0x3f);
+    }
+
+    // overlong forms, surrogates and code points past U+10FFFF are not valid.
+    if (code_point < min_code_point || (code_point >= 0xd800 && code_point <= 0xdfff) || code_point > 0x10ffff)
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+#ifdef UTILS_SSE2
+// the scalar loop leaves runs of ascii of a block or more to the vector one.
+static const ptrdiff_t c_text_block_size = 16;
+
+// counts the ascii bytes at the start of the block, returns how many there are.
+static int count_ascii_block(const unsigned char* block, int& non_space_count, int& comma_count)
+{
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    unsigned int high = static_cast<unsigned int>(_mm_movemask_epi8(chars));
+    unsigned int ascii = high == 0 ? 0xffff : (1u << __builtin_ctz(high)) - 1;
+    __m128i spaces = _mm_cmpeq_epi8(chars, _mm_set1_epi8(' '));
+    spaces = _mm_or_si128(spaces, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t')));
+    spaces = _mm_or_si128(spaces, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+    spaces = _mm_or_si128(spaces, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\x0c')));
+    spaces = _mm_or_si128(spaces, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r')));
+    unsigned int space_mask = static_cast<unsigned int>(_mm_movemask_epi8(spaces)) & ascii;
+    unsigned int comma_mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(',')))) & ascii;
+    int ascii_count = __builtin_popcount(ascii);
+    non_space_count += ascii_count - __builtin_popcount(space_mask);
+    comma_count += __builtin_popcount(comma_mask);
+    return ascii_count;
+}
+#else
+// without a vector loop the scalar one takes every byte.
+static const ptrdiff_t c_text_block_size = numeric_limits<ptrdiff_t>::max();
+#endif
+
+void count_text(const char* str, size_t length, TextStats& stats)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+    const unsigned char* end = p + length;
+    // the non space chars which are ascii and which are not, and the bytes >= 0x80.
+    int non_space_ascii_count = 0;
+    int non_space_code_point_count = 0;
+    int high_byte_count = 0;
+    int comma_count = 0;
+    int stop_count = 0;
+    while (p < end)
+    {
+#ifdef UTILS_SSE2
+        // runs of ascii are counted a block at a time, up to the first byte >= 0x80.
+        while (end - p >= c_text_block_size)
+        {
+            int block_count = count_ascii_block(p, non_space_ascii_count, comma_count);
+            p += block_count;
+            if (block_count < c_text_block_size)
             {
-                count++;
+                break;
             }
         }
-        else
+#endif
+
+        // the code points which are not ascii, and the tail shorter than a block.
+        while (p < end && (*p >= 0x80 || end - p < c_text_block_size))
         {
-            //We didn't consider encoding of the str, and space chars such as 0xa0 and \u3000 can't be skipped
-            count++;
-        }
+            if (*p < 0x80)
+            {
+                non_space_ascii_count += is_ascii_space(*p) ? 0 : 1;
+                comma_count += *p == ',' ? 1 : 0;
+                ++p;
+                continue;
+            }
 
-        str++;
+            uint32_t code_point;
+            size_t size = decode_utf8(reinterpret_cast<const char*>(p), static_cast<size_t>(end - p), code_point);
+            if (size == 0)
+            {
+                // text in another encoding, count the byte as before.
+                ++non_space_code_point_count;
+                ++high_byte_count;
+                ++p;
+                continue;
+            }
+
+            non_space_code_point_count += is_unicode_space(code_point) ? 0 : 1;
+            high_byte_count += static_cast<int>(size);
+            comma_count += is_cjk_comma(code_point) ? 1 : 0;
+            stop_count += is_cjk_stop(code_point) ? 1 : 0;
+            p += size;
+        }
     }
 
-    return count;
+    stats.non_space_count += non_space_ascii_count + non_space_code_point_count;
+    stats.non_space_byte_count += non_space_ascii_count + high_byte_count;
+    stats.comma_count += comma_count;
+    stats.stop_count += stop_count;
+}
+
+int count_without_spaces(const char* str)
+{
+    return count_without_spaces(str, strlen(str));
+}
+
+int count_without_spaces(const char* str, size_t length)
+{
+    TextStats stats;
+    count_text(str, length, stats);
+    return stats.non_space_byte_count;
 }
@@ -2,6 +2,7 @@
 #define _URL_PARSE_H_
 #include <string>
 #include <vector>
+#include <stdint.h>
 
 using namespace std;
 
@@ -29,5 +30,34 @@ void split(const string& str, const char* delimeter, vector<string>& segments);
 // pattern: 2: str contains any
 // pattern: 3: str endswith any
 int match_list(const char* str, const vector<string>& string_list, int pattern = 0);
+
+// counts of a utf-8 text, see count_text.
+struct TextStats
+{
+    TextStats() :
+        non_space_count(0),
+        non_space_byte_count(0),
+        comma_count(0),
+        stop_count(0)
+    {
+    }
+
+    // code points which are not spaces, a byte which is not valid utf-8 counts as one.
+    int non_space_count;
+    // bytes which are not ascii spaces, the length count_without_spaces gives.
+    int non_space_byte_count;
+    // ',' and the cjk comma and enumeration comma, U+FF0C and U+3001.
+    int comma_count;
+    // the cjk full stop, exclamation and question marks, U+3002, U+FF01 and U+FF1F.
+    int stop_count;
+};
+
+// adds the counts of the text to stats in one pass. spaces are the ascii ones,
+// nbsp, the unicode ones such as U+3000, and the zero width ones.
+void count_text(const char* str, size_t length, TextStats& stats);
+// decodes the code point at the start of text, returns its length in bytes,
+// 0 if text does not start with valid utf-8.
+size_t decode_utf8(const char* text, size_t length, uint32_t& code_point);
 int count_without_spaces(const char* str);
+int count_without_spaces(const char* str, size_t length);
 #endif